@@ -0,0 +1,364 @@
+/***********************************
+Benchmark suite of the loaders and the checks, run on a directory made by ProtoGen (or a real resource directory).
+Every phase is repeated and the best time is reported with rows/s, MB/s and the peak RSS of the process.
+A report saved with --save can be passed back with --baseline to compare two builds.
+***********************************/
+#include "pch.h"
+#include "ProtoChecker.h"
+#include "CsvReader.h"
+#include "CsvSchema.h"
+#include "TokenTables.h"
+#include "VnumRangeIndex.h"
+#include <chrono>
+#include <functional>
+#include <filesystem>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment(lib, "psapi.lib")
+#else
+	#include <sys/resource.h>
+#endif
+
+namespace
+{
+	/**
+	 * \brief
+	 * Result of a phase, rows and bytes are what a single iteration processes.
+	 */
+	struct SPhaseResult
+	{
+		std::string name;
+		double bestMs;
+		uint64_t rows;
+		uint64_t bytes;
+		uint64_t peakRss;
+	};
+
+	/**
+	 * \brief
+	 * Peak resident set size of the process.
+	 * \return: uint64_t, bytes
+	 */
+	auto GetPeakRss() -> uint64_t
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.PeakWorkingSetSize;
+		return 0;
+#else
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+	#ifdef __APPLE__
+		return static_cast<uint64_t>(usage.ru_maxrss);
+	#else
+		return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+	#endif
+#endif
+	}
+
+	auto GetFileSize(const std::string& path) -> uint64_t
+	{
+		std::error_code error;
+		const auto size = std::filesystem::file_size(path, error);
+		return error ? 0 : size;
+	}
+
+	class cBenchmark
+	{
+		private:
+			uint32_t m_iRepeat;
+			std::vector<SPhaseResult> m_vecResult;
+
+		public:
+			explicit cBenchmark(uint32_t iRepeat) : m_iRepeat(std::max<uint32_t>(1, iRepeat)) {}
+
+		public:
+			/**
+			 * \brief
+			 * Time a phase m_iRepeat times and keep the best run.
+			 * \param: name: string
+			 * \param: rows: uint64_t
+			 * \param: bytes: uint64_t
+			 * \param: phase: function
+			 */
+			auto Run(const std::string& name, uint64_t rows, uint64_t bytes, const std::function<void()>& phase) -> void
+			{
+				auto bestMs = std::numeric_limits<double>::max();
+				for (uint32_t i = 0; i < m_iRepeat; ++i)
+				{
+					const auto start = std::chrono::steady_clock::now();
+					phase();
+					const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					bestMs = std::min(bestMs, elapsed);
+				}
+
+				m_vecResult.push_back({ name, bestMs, rows, bytes, GetPeakRss() });
+			}
+
+			auto GetResults() const -> const std::vector<SPhaseResult>&
+			{
+				return m_vecResult;
+			}
+	};
+
+	/**
+	 * \brief
+	 * Read a report written by --save, one "name milliseconds" pair per line.
+	 * \param: fileName: string
+	 * \return: map
+	 */
+	auto LoadBaseline(const std::string& fileName) -> std::map<std::string, double>
+	{
+		std::map<std::string, double> mapBaseline;
+		std::ifstream file(fileName);
+
+		std::string stName;
+		double ms;
+		while (file >> stName >> ms)
+			mapBaseline[stName] = ms;
+
+		return mapBaseline;
+	}
+
+	auto PrintUsage() -> void
+	{
+		std::cout << "Usage: ProtoBench <data directory> [options]\n"
+			"  --repeat N              runs of every phase, the best one is reported (default 3)\n"
+			"  --save FILE             write the timings as a baseline\n"
+			"  --baseline FILE         compare the timings with a saved baseline\n"
+			"  --max-regression PCT    exit with 1 if a phase is slower than the baseline by more than PCT percent\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string stDataPath, stSaveFile, stBaselineFile;
+	uint32_t iRepeat = 3;
+	double maxRegression = -1.0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string stArgument(argv[i]);
+		const auto bValue = i + 1 < argc;
+
+		if (stArgument == "--repeat" && bValue)
+			iRepeat = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (stArgument == "--save" && bValue)
+			stSaveFile = argv[++i];
+		else if (stArgument == "--baseline" && bValue)
+			stBaselineFile = argv[++i];
+		else if (stArgument == "--max-regression" && bValue)
+			maxRegression = std::stod(argv[++i]);
+		else if (stDataPath.empty() && stArgument[0] != '-')
+			stDataPath = stArgument;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (stDataPath.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (stDataPath.back() != '/' && stDataPath.back() != '\\')
+		stDataPath += '/';
+
+	const auto & stItemProtoPath = stDataPath + ITEM_PROTO_FILE_NAME;
+	const auto iItemProtoBytes = GetFileSize(stItemProtoPath);
+	const auto iTotalBytes = iItemProtoBytes + GetFileSize(stDataPath + ITEM_NAMES_FILE_NAME) +
+		GetFileSize(stDataPath + MOB_PROTO_FILE_NAME) + GetFileSize(stDataPath + MOB_NAMES_FILE_NAME);
+
+	cCsvFile csvFile;
+	if (!csvFile.Load(stItemProtoPath.c_str(), '\t'))
+	{
+		std::cerr << "Cannot load " << stItemProtoPath << std::endl;
+		return 1;
+	}
+
+	const uint64_t iItemRows = csvFile.GetRowCount();
+	cBenchmark benchmark(iRepeat);
+
+	benchmark.Run("csv_load", iItemRows, iItemProtoBytes, [&]
+	{
+		cCsvFile file;
+		file.Load(stItemProtoPath.c_str(), '\t');
+	});
+
+	benchmark.Run("csv_load_mapped", iItemRows, iItemProtoBytes, [&]
+	{
+		cCsvMappedFile file;
+		file.Load(stItemProtoPath.c_str(), '\t');
+	});
+
+	// Named field access over every row: a runtime alias lookup per field against a schema bound once.
+	cCsvTable csvTable;
+	csvTable.LoadMapped(stItemProtoPath.c_str(), '\t');
+	csvTable.AddHeaderAliases();
+
+	cCsvSchema<SItemProtoSchema> itemSchema;
+	if (!itemSchema.Bind(csvTable))
+	{
+		std::cerr << "The header of " << stItemProtoPath << " lacks item_proto columns" << std::endl;
+		return 1;
+	}
+
+	volatile int64_t iFieldSum = 0;
+	benchmark.Run("named_access_alias", iItemRows, 0, [&]
+	{
+		int64_t sum = 0;
+		for (csvTable.Rewind(), csvTable.Next(); csvTable.Next();)
+			sum += csvTable.AsInt("GOLD") + csvTable.AsInt("SHOP_BUY_PRICE") + csvTable.AsInt("REFINESET") + csvTable.AsStringView("ITEM_NAME(K)").size();
+		iFieldSum = sum;
+	});
+
+	benchmark.Run("named_access_schema", iItemRows, 0, [&]
+	{
+		int64_t sum = 0;
+		for (csvTable.Rewind(), csvTable.Next(); csvTable.Next();)
+			sum += csvTable.Get<SItemProtoSchema::GOLD>(itemSchema) + csvTable.Get<SItemProtoSchema::SHOP_BUY_PRICE>(itemSchema) +
+				csvTable.Get<SItemProtoSchema::REFINESET>(itemSchema) + csvTable.Get<SItemProtoSchema::NAME>(itemSchema).size();
+		iFieldSum = sum;
+	});
+
+	// Token columns looked up in their dictionaries, to compare with the cost of tokenizing the rows (csv_load_mapped).
+	const std::pair<SItemProtoSchema::EColumn, const cTokenDictionary*> tokenColumns[] =
+	{
+		{SItemProtoSchema::TYPE, &ITEM_TYPE_TOKENS},
+		{SItemProtoSchema::LIMIT_TYPE0, &LIMIT_TYPE_TOKENS},
+		{SItemProtoSchema::LIMIT_TYPE1, &LIMIT_TYPE_TOKENS},
+		{SItemProtoSchema::ADDON_TYPE0, &APPLY_TYPE_TOKENS},
+		{SItemProtoSchema::ADDON_TYPE1, &APPLY_TYPE_TOKENS},
+		{SItemProtoSchema::ADDON_TYPE2, &APPLY_TYPE_TOKENS},
+	};
+
+	benchmark.Run("token_lookup", iItemRows, 0, [&]
+	{
+		const auto & file = csvTable.m_MappedFile;
+		int64_t sum = 0;
+		for (size_t row = 1; row < file.GetRowCount(); ++row)
+		{
+			for (const auto & column : tokenColumns)
+				sum += column.second->Find(file.GetField(row, itemSchema[column.first]));
+		}
+		iFieldSum = sum;
+	});
+
+	// The checks never log here, the checker has no writer.
+	// Snapshots are off so the parser is measured, the snapshot path has phases of its own.
+	CProtoChecker checker(stDataPath, false);
+	const auto & itemProto = checker.load_file(ITEM_PROTO_FILE_NAME);
+	const auto & itemNames = checker.load_file(ITEM_NAMES_FILE_NAME);
+	const uint64_t iCompareRows = std::get<1>(itemProto).size() + std::get<1>(itemNames).size();
+
+	benchmark.Run("load_file", iItemRows, iItemProtoBytes, [&]
+	{
+		checker.load_file(ITEM_PROTO_FILE_NAME);
+	});
+
+	benchmark.Run("find_duplicate", std::get<1>(itemProto).size(), 0, [&]
+	{
+		checker.find_duplicate(itemProto);
+	});
+
+	benchmark.Run("compare", iCompareRows, 0, [&]
+	{
+		checker.compare(itemProto, itemNames);
+	});
+
+	// Index of the item keys and a batch of free block queries spread over the vnums.
+	benchmark.Run("range_index", iCompareRows, 0, [&]
+	{
+		CVnumRangeIndex index;
+		CProtoChecker::add_range_keys(itemProto, 0, index);
+		CProtoChecker::add_range_keys(itemNames, 1, index);
+		index.Build();
+
+		int64_t sum = 0;
+		uint32_t first = 0;
+		for (uint32_t query = 0; query < 100000; ++query)
+			sum += index.FindFree(1 + query % 1000, query * 97, first) ? first : 0;
+		iFieldSum = sum;
+	});
+
+	benchmark.Run("run", iItemRows, iTotalBytes, [&]
+	{
+		CProtoChecker obj(stDataPath, false);
+		obj.run();
+	});
+
+	benchmark.Run("similar_names", std::get<1>(itemNames).size(), GetFileSize(stDataPath + ITEM_NAMES_FILE_NAME), [&]
+	{
+		checker.find_similar_names(ITEM_NAMES_FILE_NAME);
+	});
+
+	benchmark.Run("clone_rows", iItemRows, iItemProtoBytes, [&]
+	{
+		checker.find_clone_rows({ ITEM_PROTO_FILE_NAME, { "ITEM_VNUM~RANGE", "ITEM_NAME(K)" } });
+	});
+
+	// The first load writes the snapshots, every timed one maps them.
+	CProtoChecker snapshotChecker(stDataPath);
+	benchmark.Run("load_file_snapshot", iItemRows, iItemProtoBytes, [&]
+	{
+		snapshotChecker.load_file(ITEM_PROTO_FILE_NAME);
+	});
+
+	benchmark.Run("run_snapshot", iItemRows, iTotalBytes, [&]
+	{
+		CProtoChecker obj(stDataPath);
+		obj.run();
+	});
+
+	const auto & mapBaseline = stBaselineFile.empty() ? std::map<std::string, double>() : LoadBaseline(stBaselineFile);
+	auto bRegression = false;
+
+	std::cout << format("%-20s %12s %14s %10s %12s", "phase", "best ms", "rows/s", "MB/s", "peak RSS MB");
+	if (!mapBaseline.empty())
+		std::cout << format(" %12s %9s", "baseline ms", "delta");
+	std::cout << '\n';
+
+	for (const auto & result : benchmark.GetResults())
+	{
+		const auto seconds = std::max(result.bestMs, 1e-6) / 1000.0;
+		std::cout << format("%-20s %12.3f %14.0f %10.1f %12.1f", result.name.c_str(), result.bestMs,
+			result.rows / seconds, result.bytes / seconds / (1024.0 * 1024.0), result.peakRss / (1024.0 * 1024.0));
+
+		const auto it = mapBaseline.find(result.name);
+		if (it != mapBaseline.end() && it->second > 0.0)
+		{
+			const auto delta = (result.bestMs - it->second) / it->second * 100.0;
+			std::cout << format(" %12.3f %+8.1f%%", it->second, delta);
+
+			if (maxRegression >= 0.0 && delta > maxRegression)
+			{
+				std::cout << "  REGRESSION";
+				bRegression = true;
+			}
+		}
+
+		std::cout << '\n';
+	}
+
+	if (!stSaveFile.empty())
+	{
+		std::ofstream file(stSaveFile, std::ios::out | std::ios::trunc);
+		for (const auto & result : benchmark.GetResults())
+			file << result.name << ' ' << format("%.3f", result.bestMs) << '\n';
+	}
+
+	return bRegression ? 1 : 0;
+}
@@ -0,0 +1,326 @@
+/***********************************
+Synthetic proto generator, writes item_proto/item_names/mob_proto/mob_names into a directory.
+Shape of the data (duplicates, missing names, `~` ranges, quoted fields) is controlled from the command line,
+the same seed always produces the same files.
+***********************************/
+#include "pch.h"
+#include "ProtoChecker.h"
+#include <cstdio>
+#include <random>
+#include <filesystem>
+
+namespace
+{
+	/**
+	 * \brief
+	 * Generator options, the rates are fractions of the rows.
+	 */
+	struct SOptions
+	{
+		std::string outputPath;
+		uint64_t itemRows = 10000;
+		uint64_t mobRows = 0;
+		double duplicateRate = 0.001;
+		double missingRate = 0.001;
+		double rangeRate = 0.02;
+		double quotedRate = 0.01;
+		uint64_t seed = 5489;
+	};
+
+	const char* const ITEM_PROTO_HEADER = "ITEM_VNUM~RANGE\tITEM_NAME(K)\tITEM_TYPE\tSUB_TYPE\tSIZE\tANTI_FLAG\tFLAG\tITEM_WEAR\tIMMUNE\tGOLD\tSHOP_BUY_PRICE\tREFINE\tREFINESET\tMAGIC_PCT"
+		"\tLIMIT_TYPE0\tLIMIT_VALUE0\tLIMIT_TYPE1\tLIMIT_VALUE1\tADDON_TYPE0\tADDON_VALUE0\tADDON_TYPE1\tADDON_VALUE1\tADDON_TYPE2\tADDON_VALUE2"
+		"\tVALUE0\tVALUE1\tVALUE2\tVALUE3\tVALUE4\tVALUE5\tSpecular\tSOCKET\tATTU_ADDON";
+
+	const char* const MOB_PROTO_HEADER = "VNUM\tNAME\tRANK\tTYPE\tBATTLE_TYPE\tLEVEL\tSIZE\tAI_FLAG\tMOUNT_CAPACITY\tRACE_FLAG\tIMMUNE_FLAG\tEMPIRE\tFOLDER\tON_CLICK"
+		"\tST\tDX\tHT\tIQ\tDAMAGE_MIN\tDAMAGE_MAX\tMAX_HP\tREGEN_CYCLE\tREGEN_PERCENT\tGOLD_MIN\tGOLD_MAX\tEXP\tDEF\tATTACK_SPEED\tMOVE_SPEED"
+		"\tAGGRESSIVE_HP_PCT\tAGGRESSIVE_SIGHT\tATTACK_RANGE\tDROP_ITEM\tRESURRECTION_VNUM\tENCHANT_CURSE\tENCHANT_SLOW\tENCHANT_POISON\tENCHANT_STUN"
+		"\tENCHANT_CRITICAL\tENCHANT_PENETRATE\tRESIST_SWORD\tRESIST_TWOHAND\tRESIST_DAGGER\tRESIST_BELL\tRESIST_FAN\tRESIST_BOW\tRESIST_FIRE"
+		"\tRESIST_ELECT\tRESIST_MAGIC\tRESIST_WIND\tRESIST_POISON\tDAM_MULTIPLY\tSUMMON\tDRAIN_SP\tMOB_COLOR\tPOLYMORPH_ITEM\tSKILL_LEVEL0\tSKILL_VNUM0"
+		"\tSKILL_LEVEL1\tSKILL_VNUM1\tSKILL_LEVEL2\tSKILL_VNUM2\tSKILL_LEVEL3\tSKILL_VNUM3\tSKILL_LEVEL4\tSKILL_VNUM4\tSP_BERSERK\tSP_STONESKIN"
+		"\tSP_GODSPEED\tSP_DEATHBLOW\tSP_REVIVE";
+
+	const char* const NAMES_HEADER = "VNUM\tLOCALE_NAME";
+
+	const char* const ITEM_TYPES[] = { "ITEM_ARMOR", "ITEM_WEAPON", "ITEM_COSTUME", "ITEM_MATERIAL", "ITEM_GIFTBOX", "ITEM_USE", "ITEM_QUEST", "ITEM_NONE" };
+	const char* const MOB_RANKS[] = { "PAWN", "S_PAWN", "KNIGHT", "S_KNIGHT", "BOSS", "KING" };
+
+	/**
+	 * \brief
+	 * Buffered file writer, the generated files easily reach gigabytes.
+	 */
+	class cBufferedWriter
+	{
+		private:
+			static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+			FILE* m_pFile;
+			std::string m_Buffer;
+
+		public:
+			explicit cBufferedWriter(const std::string& fileName) : m_pFile(fopen(fileName.c_str(), "wb"))
+			{
+				m_Buffer.reserve(BUFFER_SIZE + 4096);
+			}
+
+			~cBufferedWriter()
+			{
+				if (!m_pFile)
+					return;
+
+				fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_pFile);
+				fclose(m_pFile);
+			}
+
+			auto IsOpen() const -> bool
+			{
+				return m_pFile != nullptr;
+			}
+
+			auto Buffer() -> std::string&
+			{
+				return m_Buffer;
+			}
+
+			auto EndLine() -> void
+			{
+				m_Buffer += '\n';
+				if (m_Buffer.size() < BUFFER_SIZE)
+					return;
+
+				fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_pFile);
+				m_Buffer.clear();
+			}
+	};
+
+	class cProtoGenerator
+	{
+		private:
+			const SOptions& m_Options;
+			std::mt19937_64 m_Random;
+
+		public:
+			explicit cProtoGenerator(const SOptions& options) : m_Options(options), m_Random(options.seed) {}
+
+		public:
+			auto Generate(const std::string& stProtoName, const std::string& stNamesName, uint64_t iRows, bool bItem) -> bool;
+
+		private:
+			auto Chance(double rate) -> bool
+			{
+				return static_cast<double>(m_Random() >> 11) * (1.0 / 9007199254740992.0) < rate;
+			}
+
+			auto Next(uint64_t bound) -> uint64_t
+			{
+				return m_Random() % bound;
+			}
+
+			auto AppendName(std::string& output, uint64_t vnum) -> void;
+			auto AppendItemFields(std::string& output) -> void;
+			auto AppendMobFields(std::string& output) -> void;
+	};
+
+	/**
+	 * \brief
+	 * Plain name, or a quoted one with an escaped quote or a line break inside.
+	 */
+	auto cProtoGenerator::AppendName(std::string& output, uint64_t vnum) -> void
+	{
+		if (!Chance(m_Options.quotedRate))
+		{
+			output += "Name ";
+			output += std::to_string(vnum);
+			return;
+		}
+
+		output += Next(4) ? "\"Name \"\"" : "\"Name\n\"\"";
+		output += std::to_string(vnum);
+		output += "\"\"\"";
+	}
+
+	auto cProtoGenerator::AppendItemFields(std::string& output) -> void
+	{
+		output += '\t';
+		output += ITEM_TYPES[Next(std::size(ITEM_TYPES))];
+		output += "\t0\t1\tNONE\tNONE\tWEAR_BODY\tNONE\t";
+		output += std::to_string(Next(100000));
+		output += '\t';
+		output += std::to_string(Next(100000));
+		output += "\t0\t0\t15\tLEVEL\t";
+		output += std::to_string(Next(120));
+		output += "\tLIMIT_NONE\t0\tAPPLY_NONE\t0\tAPPLY_NONE\t0\tAPPLY_NONE\t0";
+
+		for (int i = 0; i < 6; ++i)
+		{
+			output += '\t';
+			output += std::to_string(Next(50));
+		}
+
+		output += "\t0\t0\t0";
+	}
+
+	auto cProtoGenerator::AppendMobFields(std::string& output) -> void
+	{
+		output += '\t';
+		output += MOB_RANKS[Next(std::size(MOB_RANKS))];
+		output += "\tMONSTER\tMELEE\t";
+		output += std::to_string(1 + Next(120));
+		output += "\t0\t\t0\tANIMAL\t\t0\tfolder\t0";
+
+		for (int i = 14; i < 71; ++i)
+		{
+			output += '\t';
+			output += std::to_string(Next(i < 32 ? 2000 : 10));
+		}
+	}
+
+	/**
+	 * \brief
+	 * Write a proto file and its names file.
+	 * Vnums grow with small gaps; a range row covers the next 100 vnums, a duplicate row repeats an earlier vnum.
+	 * Names are dropped for some rows and added for some vnums which have no proto row.
+	 * \return: bool
+	 */
+	auto cProtoGenerator::Generate(const std::string& stProtoName, const std::string& stNamesName, uint64_t iRows, bool bItem) -> bool
+	{
+		cBufferedWriter proto(stProtoName);
+		cBufferedWriter names(stNamesName);
+		if (!proto.IsOpen() || !names.IsOpen())
+			return false;
+
+		proto.Buffer() += bItem ? ITEM_PROTO_HEADER : MOB_PROTO_HEADER;
+		proto.EndLine();
+		names.Buffer() += NAMES_HEADER;
+		names.EndLine();
+
+		std::vector<uint64_t> vecVnum;
+		vecVnum.reserve(iRows);
+		uint64_t vnum = 1;
+
+		for (uint64_t row = 0; row < iRows; ++row)
+		{
+			auto & protoLine = proto.Buffer();
+			auto itemVnum = vnum;
+			auto iSpan = uint64_t(1);
+
+			if (!vecVnum.empty() && Chance(m_Options.duplicateRate))
+			{
+				itemVnum = vecVnum[Next(vecVnum.size())];
+				protoLine += std::to_string(itemVnum);
+			}
+			else if (bItem && Chance(m_Options.rangeRate))
+			{
+				iSpan = 100;
+				protoLine += std::to_string(itemVnum);
+				protoLine += '~';
+				protoLine += std::to_string(itemVnum + iSpan - 1);
+			}
+			else
+			{
+				protoLine += std::to_string(itemVnum);
+			}
+
+			vecVnum.push_back(itemVnum);
+			if (itemVnum == vnum)
+				vnum += iSpan + (Next(4) ? 0 : Next(10));
+
+			protoLine += '\t';
+			AppendName(protoLine, itemVnum);
+			bItem ? AppendItemFields(protoLine) : AppendMobFields(protoLine);
+			proto.EndLine();
+
+			if (!Chance(m_Options.missingRate))
+			{
+				auto & namesLine = names.Buffer();
+				namesLine += std::to_string(itemVnum);
+				namesLine += '\t';
+				AppendName(namesLine, itemVnum);
+				names.EndLine();
+			}
+
+			if (Chance(m_Options.missingRate))
+			{
+				auto & namesLine = names.Buffer();
+				namesLine += std::to_string(vnum++);
+				namesLine += "\tOrphan name";
+				names.EndLine();
+			}
+		}
+
+		return true;
+	}
+
+	auto PrintUsage() -> void
+	{
+		std::cout << "Usage: ProtoGen <output directory> [options]\n"
+			"  --rows N            item_proto rows (default 10000)\n"
+			"  --mob-rows N        mob_proto rows (default rows / 5)\n"
+			"  --duplicate-rate P  rows repeating an earlier vnum (default 0.001)\n"
+			"  --missing-rate P    rows without a name, and names without a row (default 0.001)\n"
+			"  --range-rate P      item rows written as a 100 vnum `~` range (default 0.02)\n"
+			"  --quoted-rate P     quoted names, a quarter of them spanning two lines (default 0.01)\n"
+			"  --seed N            random seed (default 5489)\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	SOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string stArgument(argv[i]);
+		const auto bValue = i + 1 < argc;
+
+		if (stArgument == "--rows" && bValue)
+			options.itemRows = std::stoull(argv[++i]);
+		else if (stArgument == "--mob-rows" && bValue)
+			options.mobRows = std::stoull(argv[++i]);
+		else if (stArgument == "--duplicate-rate" && bValue)
+			options.duplicateRate = std::stod(argv[++i]);
+		else if (stArgument == "--missing-rate" && bValue)
+			options.missingRate = std::stod(argv[++i]);
+		else if (stArgument == "--range-rate" && bValue)
+			options.rangeRate = std::stod(argv[++i]);
+		else if (stArgument == "--quoted-rate" && bValue)
+			options.quotedRate = std::stod(argv[++i]);
+		else if (stArgument == "--seed" && bValue)
+			options.seed = std::stoull(argv[++i]);
+		else if (options.outputPath.empty() && stArgument[0] != '-')
+			options.outputPath = stArgument;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (options.outputPath.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (options.mobRows == 0)
+		options.mobRows = std::max<uint64_t>(1, options.itemRows / 5);
+
+	std::error_code error;
+	std::filesystem::create_directories(options.outputPath, error);
+
+	const auto & stPath = options.outputPath + "/";
+	cProtoGenerator generator(options);
+	if (!generator.Generate(stPath + ITEM_PROTO_FILE_NAME, stPath + ITEM_NAMES_FILE_NAME, options.itemRows, true) ||
+		!generator.Generate(stPath + MOB_PROTO_FILE_NAME, stPath + MOB_NAMES_FILE_NAME, options.mobRows, false))
+	{
+		std::cerr << "Cannot write into " << options.outputPath << std::endl;
+		return 1;
+	}
+
+	// Freshly written files would be racy for the snapshots (see cProtoSnapshot), so every timed snapshot load would hash
+	// the source. Generated data is dated back to look like a resource directory which wasn't touched for a while.
+	const auto time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+	for (const auto & stFileName : { ITEM_PROTO_FILE_NAME, ITEM_NAMES_FILE_NAME, MOB_PROTO_FILE_NAME, MOB_NAMES_FILE_NAME })
+		std::filesystem::last_write_time(stPath + stFileName, time, error);
+
+	std::cout << "Generated " << options.itemRows << " item rows and " << options.mobRows << " mob rows in " << options.outputPath << std::endl;
+	return 0;
+}
@@ -0,0 +1,340 @@
+#include "pch.h"
+#include "ColumnRules.h"
+#include "CsvColumnTable.h"
+#include "ThreadPool.h"
+#include <charconv>
+
+namespace
+{
+	enum EColumnOperator
+	{
+		OPERATOR_EQUAL,
+		OPERATOR_NOT_EQUAL,
+		OPERATOR_LESS,
+		OPERATOR_LESS_EQUAL,
+		OPERATOR_GREATER,
+		OPERATOR_GREATER_EQUAL,
+		OPERATOR_IN,
+		OPERATOR_NOT_IN,
+	};
+
+	const std::pair<const char*, EColumnOperator> COLUMN_OPERATORS[] =
+	{
+		{"==",     OPERATOR_EQUAL},
+		{"!=",     OPERATOR_NOT_EQUAL},
+		{"<",      OPERATOR_LESS},
+		{"<=",     OPERATOR_LESS_EQUAL},
+		{">",      OPERATOR_GREATER},
+		{">=",     OPERATOR_GREATER_EQUAL},
+		{"in",     OPERATOR_IN},
+		{"not_in", OPERATOR_NOT_IN},
+	};
+
+	using TRowValidator = std::function<void(size_t, size_t, std::vector<uint32_t>&)>;
+	using TRowCondition = std::function<bool(size_t)>;
+
+	auto ParseInteger(std::string_view text, int64_t& value) -> bool
+	{
+		const auto end = text.data() + text.size();
+		const auto result = std::from_chars(text.data(), end, value);
+		return !text.empty() && result.ec == std::errc() && result.ptr == end;
+	}
+
+	auto SplitValues(const std::string& stValues) -> std::vector<std::string>
+	{
+		std::vector<std::string> vecValue;
+		for (size_t begin = 0; begin <= stValues.size();)
+		{
+			const auto end = std::min(stValues.find(',', begin), stValues.size());
+			vecValue.emplace_back(stValues, begin, end - begin);
+			begin = end + 1;
+		}
+		return vecValue;
+	}
+
+	/**
+	 * \brief
+	 * Operand of a comparison at a row: a column of the row or a constant.
+	 */
+	template <typename T>
+	auto GetOperand(const T* values, size_t row) -> T
+	{
+		return values[row];
+	}
+
+	inline auto GetOperand(int64_t value, size_t) -> int64_t
+	{
+		return value;
+	}
+
+	/**
+	 * \brief
+	 * Validator of a comparison, instantiated per column storage type, operand kind and operator.
+	 * The condition is only evaluated for the rows failing the comparison, which are few.
+	 */
+	template <typename TLeft, typename TRight, typename TCompare>
+	auto MakeComparison(const TLeft* left, TRight right, TCompare compare, TRowCondition when) -> TRowValidator
+	{
+		return [left, right, compare, when](size_t begin, size_t end, std::vector<uint32_t>& vecRow)
+		{
+			for (auto row = begin; row < end; ++row)
+			{
+				if (!compare(left[row], GetOperand(right, row)) && (!when || when(row)))
+					vecRow.push_back(static_cast<uint32_t>(row));
+			}
+		};
+	}
+
+	template <typename F>
+	auto WithComparison(EColumnOperator op, F func) -> TRowValidator
+	{
+		switch (op)
+		{
+			case OPERATOR_EQUAL:
+				return func(std::equal_to<>());
+			case OPERATOR_NOT_EQUAL:
+				return func(std::not_equal_to<>());
+			case OPERATOR_LESS:
+				return func(std::less<>());
+			case OPERATOR_LESS_EQUAL:
+				return func(std::less_equal<>());
+			case OPERATOR_GREATER:
+				return func(std::greater<>());
+			case OPERATOR_GREATER_EQUAL:
+				return func(std::greater_equal<>());
+			default:
+				return nullptr;
+		}
+	}
+
+	/**
+	 * \brief
+	 * A column with values, columns left out of the table's mask have none.
+	 */
+	auto FindLoadedColumn(const cCsvColumnTable& table, const std::string& stName) -> int
+	{
+		const auto col = table.FindColumn(stName);
+		if (col < 0)
+			return -1;
+
+		const auto & column = table.GetColumn(static_cast<size_t>(col));
+		const auto count = column.int32Values.size() + column.int64Values.size() + column.tokenIds.size();
+		return count == table.GetRowCount() ? col : -1;
+	}
+}
+
+/**
+ * \brief
+ * Compile every rule against a table, the table must outlive the rule set.
+ * A rule which can't be compiled (unknown column or operator, bad operand) is skipped by Validate, see GetError.
+ * \param: table: cCsvColumnTable
+ * \param: vecRule: vector
+ */
+auto CColumnRuleSet::Compile(const cCsvColumnTable& table, const std::vector<SColumnRule>& vecRule) -> void
+{
+	m_pTable = &table;
+	m_vecValidator.clear();
+	m_vecError.clear();
+	m_vecNumeric.assign(table.GetColCount(), nullptr);
+
+	for (const auto & rule : vecRule)
+	{
+		std::string stError;
+		auto validator = Compile(rule, stError);
+		if (!validator && stError.empty())
+			stError = "invalid rule";
+
+		m_vecValidator.emplace_back(std::move(validator));
+		m_vecError.emplace_back(std::move(stError));
+	}
+}
+
+/**
+ * \brief
+ * Run every compiled rule over every row, in blocks of rows spread over the thread pool.
+ * \return: vector, for each rule the rows breaking it in ascending order
+ */
+auto CColumnRuleSet::Validate() const -> std::vector<std::vector<uint32_t>>
+{
+	std::vector<std::vector<uint32_t>> vecResult(m_vecValidator.size());
+	const auto rowCount = m_pTable ? m_pTable->GetRowCount() : 0;
+	const auto blockCount = (rowCount + BLOCK_ROW_COUNT - 1) / BLOCK_ROW_COUNT;
+
+	std::vector<std::vector<std::vector<uint32_t>>> vecBlock(blockCount);
+	CThreadPool::Instance().ParallelFor(blockCount, [this, rowCount, &vecBlock](size_t block)
+	{
+		const auto begin = block * BLOCK_ROW_COUNT;
+		const auto end = std::min(rowCount, begin + BLOCK_ROW_COUNT);
+
+		auto & vecRow = vecBlock[block];
+		vecRow.resize(m_vecValidator.size());
+		for (size_t rule = 0; rule < m_vecValidator.size(); ++rule)
+		{
+			if (m_vecValidator[rule])
+				m_vecValidator[rule](begin, end, vecRow[rule]);
+		}
+	});
+
+	for (const auto & vecRow : vecBlock)
+	{
+		for (size_t rule = 0; rule < vecRow.size(); ++rule)
+			vecResult[rule].insert(vecResult[rule].end(), vecRow[rule].begin(), vecRow[rule].end());
+	}
+
+	return vecResult;
+}
+
+/**
+ * \brief
+ * Compile a single rule.
+ * \param: rule: SColumnRule
+ * \param: stError: string, set when the rule can't be compiled
+ * \return: validator, empty when the rule can't be compiled
+ */
+auto CColumnRuleSet::Compile(const SColumnRule& rule, std::string& stError) -> TValidator
+{
+	const auto & table = *m_pTable;
+	const auto col = FindLoadedColumn(table, rule.column);
+	if (col < 0)
+	{
+		stError = rule.column + " not found";
+		return nullptr;
+	}
+
+	const auto itOperator = std::find_if(std::begin(COLUMN_OPERATORS), std::end(COLUMN_OPERATORS), [&rule](const auto & it) { return rule.op == it.first; });
+	if (itOperator == std::end(COLUMN_OPERATORS))
+	{
+		stError = "unknown operator " + rule.op;
+		return nullptr;
+	}
+
+	TCondition when;
+	if (!rule.whenColumn.empty())
+	{
+		const auto whenCol = FindLoadedColumn(table, rule.whenColumn);
+		if (whenCol < 0)
+		{
+			stError = rule.whenColumn + " not found";
+			return nullptr;
+		}
+
+		when = CompileCondition(static_cast<size_t>(whenCol), rule.whenValues);
+	}
+
+	auto op = itOperator->second;
+	int64_t literal = 0;
+	const auto bLiteral = ParseInteger(rule.operand, literal);
+	const auto operandCol = bLiteral ? -1 : FindLoadedColumn(table, rule.operand);
+	std::vector<std::string> vecValue;
+
+	// A text column compared with text is a membership test.
+	if (op == OPERATOR_IN || op == OPERATOR_NOT_IN)
+		vecValue = SplitValues(rule.operand);
+	else if (!bLiteral && operandCol < 0 && (op == OPERATOR_EQUAL || op == OPERATOR_NOT_EQUAL))
+	{
+		vecValue.push_back(rule.operand);
+		op = op == OPERATOR_EQUAL ? OPERATOR_IN : OPERATOR_NOT_IN;
+	}
+	else if (!bLiteral && operandCol < 0)
+	{
+		stError = rule.operand + " not found";
+		return nullptr;
+	}
+
+	if (op == OPERATOR_IN || op == OPERATOR_NOT_IN)
+	{
+		const auto bIn = op == OPERATOR_IN;
+		const auto membership = CompileCondition(static_cast<size_t>(col), vecValue);
+		return [membership, bIn, when](size_t begin, size_t end, std::vector<uint32_t>& vecRow)
+		{
+			for (auto row = begin; row < end; ++row)
+			{
+				if (membership(row) != bIn && (!when || when(row)))
+					vecRow.push_back(static_cast<uint32_t>(row));
+			}
+		};
+	}
+
+	const auto left = GetNumeric(static_cast<size_t>(col));
+	const auto right = operandCol < 0 ? std::make_pair<const int32_t*, const int64_t*>(nullptr, nullptr) : GetNumeric(static_cast<size_t>(operandCol));
+	return WithComparison(op, [&](auto compare) -> TValidator
+	{
+		const auto WithRight = [&](auto values) -> TValidator
+		{
+			if (operandCol < 0)
+				return MakeComparison(values, literal, compare, when);
+			if (right.first)
+				return MakeComparison(values, right.first, compare, when);
+			return MakeComparison(values, right.second, compare, when);
+		};
+
+		return left.first ? WithRight(left.first) : WithRight(left.second);
+	});
+}
+
+/**
+ * \brief
+ * Membership test of a column in a set of values: a flag per interned token for text columns,
+ * a sorted array of the values for integer columns.
+ * \param: col: size_t
+ * \param: vecValue: vector
+ * \return: condition
+ */
+auto CColumnRuleSet::CompileCondition(size_t col, const std::vector<std::string>& vecValue) -> TCondition
+{
+	const auto & column = m_pTable->GetColumn(col);
+	if (column.type == cCsvColumnTable::COLUMN_TOKEN)
+	{
+		const auto & interner = *m_pTable->GetInterner();
+		auto flags = std::make_shared<std::vector<uint8_t>>(interner.Size(), 0);
+		for (const auto & stValue : vecValue)
+		{
+			uint32_t id;
+			if (interner.Find(stValue, id))
+				(*flags)[id] = 1;
+		}
+
+		const auto tokens = column.tokenIds.data();
+		return [tokens, flags](size_t row) { return (*flags)[tokens[row]] != 0; };
+	}
+
+	auto values = std::make_shared<std::vector<int64_t>>();
+	for (const auto & stValue : vecValue)
+	{
+		int64_t value;
+		if (ParseInteger(stValue, value))
+			values->push_back(value);
+	}
+
+	std::sort(values->begin(), values->end());
+
+	const auto numeric = GetNumeric(col);
+	if (numeric.first)
+		return [numbers = numeric.first, values](size_t row) { return std::binary_search(values->begin(), values->end(), int64_t(numbers[row])); };
+	return [numbers = numeric.second, values](size_t row) { return std::binary_search(values->begin(), values->end(), numbers[row]); };
+}
+
+/**
+ * \brief
+ * Integer array of a column, a text column is converted once (a value which isn't a number reads as its leading digits).
+ * \param: col: size_t
+ * \return: pair, the int32 or the int64 array
+ */
+auto CColumnRuleSet::GetNumeric(size_t col) -> std::pair<const int32_t*, const int64_t*>
+{
+	const auto & column = m_pTable->GetColumn(col);
+	if (column.type == cCsvColumnTable::COLUMN_INT32)
+		return { column.int32Values.data(), nullptr };
+	if (column.type == cCsvColumnTable::COLUMN_INT64)
+		return { nullptr, column.int64Values.data() };
+
+	auto & numeric = m_vecNumeric[col];
+	if (!numeric)
+	{
+		numeric = std::make_shared<std::vector<int64_t>>(m_pTable->GetRowCount());
+		for (size_t row = 0; row < numeric->size(); ++row)
+			(*numeric)[row] = m_pTable->AsInt64(row, col);
+	}
+
+	return { nullptr, numeric->data() };
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <functional>
+#include <memory>
+
+class cCsvColumnTable;
+
+/**
+ * \brief
+ * Constraint on a column of a file, checked on every row.
+ * op: ==, !=, <, <=, >, >= against operand, an integer or the header name of another column of the same row,
+ *     in / not_in against operand as comma separated values.
+ * whenColumn/whenValues: only rows whose whenColumn holds one of the values are checked, every row when empty.
+ */
+struct SColumnRule
+{
+	std::string file;
+	std::string column;
+	std::string op;
+	std::string operand;
+	std::string whenColumn;
+	std::vector<std::string> whenValues;
+};
+
+/**
+ * \brief
+ * Column rules of one file compiled against its loaded table.
+ * Compiling resolves the header names, operands and value sets once and picks a validator specialized for the
+ * operator and the storage type of the columns, so validating a rule is a loop over plain arrays.
+ * Rows are validated in blocks on the thread pool, every rule runs over a block while its columns are in cache,
+ * so a set of rules costs about one pass over the columns instead of one per rule.
+ */
+class CColumnRuleSet
+{
+	private:
+		static constexpr size_t BLOCK_ROW_COUNT = 4096;
+
+		using TValidator = std::function<void(size_t, size_t, std::vector<uint32_t>&)>;
+		using TCondition = std::function<bool(size_t)>;
+
+		const cCsvColumnTable* m_pTable;
+		std::vector<TValidator> m_vecValidator;
+		std::vector<std::string> m_vecError;
+		std::vector<std::shared_ptr<std::vector<int64_t>>> m_vecNumeric;
+
+	public:
+		CColumnRuleSet() : m_pTable(nullptr) {}
+		virtual ~CColumnRuleSet() = default;
+
+	public:
+		auto Compile(const cCsvColumnTable& table, const std::vector<SColumnRule>& vecRule) -> void;
+		auto Validate() const -> std::vector<std::vector<uint32_t>>;
+
+		/**
+		 * \brief
+		 * Why a rule couldn't be compiled, empty when it was.
+		 */
+		auto GetError(size_t rule) const -> const std::string&
+		{
+			return m_vecError[rule];
+		}
+
+	private:
+		auto Compile(const SColumnRule& rule, std::string& stError) -> TValidator;
+		auto CompileCondition(size_t col, const std::vector<std::string>& vecValue) -> TCondition;
+		auto GetNumeric(size_t col) -> std::pair<const int32_t*, const int64_t*>;
+
+		CColumnRuleSet(const CColumnRuleSet&) {}
+
+		auto operator =(const CColumnRuleSet&) const -> const CColumnRuleSet&
+		{
+			return *this;
+		}
+};
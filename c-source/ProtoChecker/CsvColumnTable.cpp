@@ -0,0 +1,208 @@
+#include "pch.h"
+#include "CsvColumnTable.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	/**
+	 * \brief
+	 * Parse an integer written in canonical form, so storing the number loses nothing of the text.
+	 * Empty strings, signs other than a single '-', leading zeros and "-0" are rejected.
+	 */
+	auto ParseCanonicalInt(std::string_view text, int64_t& value) -> bool
+	{
+		const auto negative = !text.empty() && text[0] == '-';
+		const auto digits = text.substr(negative ? 1 : 0);
+		if (digits.empty() || digits.size() > 18 || (digits[0] == '0' && (digits.size() > 1 || negative)))
+			return false;
+
+		int64_t result = 0;
+		for (const auto c : digits)
+		{
+			if (c < '0' || c > '9')
+				return false;
+			result = result * 10 + (c - '0');
+		}
+
+		value = negative ? -result : result;
+		return true;
+	}
+
+	auto GetFieldOrEmpty(const cCsvMappedFile& file, size_t row, size_t col) -> std::string_view
+	{
+		return col < file.GetColCount(row) ? file.GetField(row, col) : std::string_view();
+	}
+}
+
+cCsvColumnTable::cCsvColumnTable(std::shared_ptr<cStringInterner> pInterner)
+: m_pInterner(pInterner ? std::move(pInterner) : std::make_shared<cStringInterner>()), m_RowCount(0)
+{
+}
+
+/**
+ * \brief
+ * Load a csv file through the mapped loader and convert it to columns.
+ * \param: fileName: string
+ * \param: seperator: char
+ * \param: quote: char
+ * \param: mask: cCsvColumnMask, by index, only these columns are read and converted
+ * \return: bool
+ */
+auto cCsvColumnTable::Load(const char* fileName, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
+{
+	Destroy();
+
+	cCsvMappedFile file;
+	if (!file.Load(fileName, seperator, quote, mask))
+		return false;
+
+	Build(file, mask);
+	return true;
+}
+
+/**
+ * \brief
+ * Build the columns from a loaded file, the first row is the header.
+ * Columns are independent and built in parallel, each one interns its distinct values in a single batch.
+ * Columns outside the mask keep their name but hold no values.
+ * \param: file: cCsvMappedFile
+ * \param: mask: cCsvColumnMask, by index
+ */
+auto cCsvColumnTable::Build(const cCsvMappedFile& file, const cCsvColumnMask& mask) -> void
+{
+	Destroy();
+	if (file.GetRowCount() == 0)
+		return;
+
+	m_RowCount = file.GetRowCount() - 1;
+	m_vecColumn.resize(file.GetColCount(0));
+	m_vecRowLine.reserve(m_RowCount);
+	for (size_t row = 1; row < file.GetRowCount(); ++row)
+		m_vecRowLine.push_back(file.GetLine(row));
+
+	CThreadPool::Instance().ParallelFor(m_vecColumn.size(), [this, &file, &mask](size_t col)
+	{
+		if (mask.Wants(col))
+			BuildColumn(file, col);
+		else
+			m_vecColumn[col].name = std::string(file.GetField(0, col));
+	});
+}
+
+auto cCsvColumnTable::Destroy() -> void
+{
+	m_vecColumn.clear();
+	m_vecRowLine.clear();
+	m_RowCount = 0;
+}
+
+/**
+ * \brief
+ * Find a column by its header name, case insensitive like cCsvAlias.
+ * \param: name: string_view
+ * \return: int, -1 if there is no such column
+ */
+auto cCsvColumnTable::FindColumn(std::string_view name) const -> int
+{
+	for (size_t col = 0; col < m_vecColumn.size(); ++col)
+	{
+		const auto & stName = m_vecColumn[col].name;
+		if (stName.size() == name.size() && std::equal(stName.begin(), stName.end(), name.begin(), [](char a, char b) { return tolower(static_cast<unsigned char>(a)) == tolower(static_cast<unsigned char>(b)); }))
+			return static_cast<int>(col);
+	}
+
+	return -1;
+}
+
+auto cCsvColumnTable::AsInt64(size_t row, size_t col) const -> int64_t
+{
+	const auto & column = m_vecColumn[col];
+	switch (column.type)
+	{
+		case COLUMN_INT32:
+			return column.int32Values[row];
+		case COLUMN_INT64:
+			return column.int64Values[row];
+		default:
+			return atoll(std::string(m_pInterner->Get(column.tokenIds[row])).c_str());
+	}
+}
+
+auto cCsvColumnTable::AsString(size_t row, size_t col) const -> std::string
+{
+	const auto & column = m_vecColumn[col];
+	switch (column.type)
+	{
+		case COLUMN_INT32:
+			return std::to_string(column.int32Values[row]);
+		case COLUMN_INT64:
+			return std::to_string(column.int64Values[row]);
+		default:
+			return std::string(m_pInterner->Get(column.tokenIds[row]));
+	}
+}
+
+/**
+ * \brief
+ * Bytes held by the columns of this table, the shared interner is accounted separately.
+ * \return: size_t
+ */
+auto cCsvColumnTable::MemoryUsage() const -> size_t
+{
+	auto usage = m_vecRowLine.capacity() * sizeof(uint32_t);
+	for (const auto & column : m_vecColumn)
+	{
+		usage += sizeof(SColumn) + column.name.capacity() + column.int32Values.capacity() * sizeof(int32_t)
+			+ column.int64Values.capacity() * sizeof(int64_t) + column.tokenIds.capacity() * sizeof(uint32_t);
+	}
+
+	return usage;
+}
+
+auto cCsvColumnTable::BuildColumn(const cCsvMappedFile& file, size_t col) -> void
+{
+	auto & column = m_vecColumn[col];
+	column.name = std::string(file.GetField(0, col));
+
+	auto bInt32 = true;
+	auto bNumeric = m_RowCount > 0;
+	for (size_t row = 1; row <= m_RowCount && bNumeric; ++row)
+	{
+		int64_t value = 0;
+		bNumeric = ParseCanonicalInt(GetFieldOrEmpty(file, row, col), value);
+		bInt32 = bInt32 && bNumeric && value >= INT32_MIN && value <= INT32_MAX;
+	}
+
+	if (bNumeric)
+	{
+		column.type = bInt32 ? COLUMN_INT32 : COLUMN_INT64;
+		for (size_t row = 1; row <= m_RowCount; ++row)
+		{
+			int64_t value = 0;
+			ParseCanonicalInt(GetFieldOrEmpty(file, row, col), value);
+			if (bInt32)
+				column.int32Values.push_back(static_cast<int32_t>(value));
+			else
+				column.int64Values.push_back(value);
+		}
+		return;
+	}
+
+	// Dictionary encode locally first, so the shared interner is locked once per column.
+	std::unordered_map<std::string_view, uint32_t> mapLocalId;
+	std::vector<std::string_view> vecDistinct;
+	column.type = COLUMN_TOKEN;
+	column.tokenIds.reserve(m_RowCount);
+
+	for (size_t row = 1; row <= m_RowCount; ++row)
+	{
+		const auto & it = mapLocalId.try_emplace(GetFieldOrEmpty(file, row, col), static_cast<uint32_t>(vecDistinct.size()));
+		if (it.second)
+			vecDistinct.push_back(it.first->first);
+		column.tokenIds.push_back(it.first->second);
+	}
+
+	const auto & vecGlobalId = m_pInterner->InternBatch(vecDistinct);
+	for (auto & id : column.tokenIds)
+		id = vecGlobalId[id];
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "CsvReader.h"
+#include "StringInterner.h"
+
+/**
+ * \brief
+ * Columnar copy of a csv file, built from its header row.
+ * Columns whose every value is a plain integer are stored as dense int32/int64 arrays,
+ * every other column is dictionary encoded through a string interner which can be shared between tables.
+ * The table doesn't keep any reference to the source file once built.
+ */
+class cCsvColumnTable
+{
+	public:
+		enum EColumnType : uint8_t
+		{
+			COLUMN_INT32,
+			COLUMN_INT64,
+			COLUMN_TOKEN,
+		};
+
+		struct SColumn
+		{
+			std::string name;
+			EColumnType type = COLUMN_TOKEN;
+			std::vector<int32_t> int32Values;
+			std::vector<int64_t> int64Values;
+			std::vector<uint32_t> tokenIds;
+		};
+
+	private:
+		std::shared_ptr<cStringInterner> m_pInterner;
+		std::vector<SColumn> m_vecColumn;
+		std::vector<uint32_t> m_vecRowLine;
+		size_t m_RowCount;
+
+	public:
+		explicit cCsvColumnTable(std::shared_ptr<cStringInterner> pInterner = nullptr);
+		virtual ~cCsvColumnTable() = default;
+
+	public:
+		auto Load(const char* fileName, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask()) -> bool;
+		auto Build(const cCsvMappedFile& file, const cCsvColumnMask& mask = cCsvColumnMask()) -> void;
+		auto Destroy() -> void;
+
+		auto FindColumn(std::string_view name) const -> int;
+		auto AsInt64(size_t row, size_t col) const -> int64_t;
+		auto AsString(size_t row, size_t col) const -> std::string;
+		auto MemoryUsage() const -> size_t;
+
+		auto GetRowCount() const -> size_t
+		{
+			return m_RowCount;
+		}
+
+		auto GetColCount() const -> size_t
+		{
+			return m_vecColumn.size();
+		}
+
+		auto GetColumn(size_t col) const -> const SColumn&
+		{
+			return m_vecColumn[col];
+		}
+
+		auto GetLine(size_t row) const -> uint32_t
+		{
+			return m_vecRowLine[row];
+		}
+
+		auto GetInterner() const -> const std::shared_ptr<cStringInterner>&
+		{
+			return m_pInterner;
+		}
+
+		/**
+		 * \brief
+		 * Interned value of a token column, the view stays valid as long as the interner.
+		 */
+		auto AsToken(size_t row, size_t col) const -> std::string_view
+		{
+			const auto & column = m_vecColumn[col];
+			return column.type == COLUMN_TOKEN ? m_pInterner->Get(column.tokenIds[row]) : std::string_view();
+		}
+
+	private:
+		auto BuildColumn(const cCsvMappedFile& file, size_t col) -> void;
+
+		cCsvColumnTable(const cCsvColumnTable&) {}
+
+		auto operator =(const cCsvColumnTable&) const -> const cCsvColumnTable&
+		{
+			return *this;
+		}
+};
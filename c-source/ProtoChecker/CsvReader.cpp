@@ -1,7 +1,11 @@
 #include "pch.h"
 #include "CsvReader.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
 #include <fstream>
 #include <algorithm>
+#include <cstring>
+#include <array>
 
 #ifndef Assert
     #include <assert.h>
@@ -29,17 +33,37 @@ namespace
         std::transform(original.begin(), original.end(), original.begin(), tolower);
         return original;
     }
+
+    bool IsTrimChar(const char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    int ToInt(std::string_view text)
+    {
+        size_t cur = 0;
+        while (cur < text.size() && isspace(static_cast<unsigned char>(text[cur])))
+            ++cur;
+
+        bool negative = false;
+        if (cur < text.size() && (text[cur] == '-' || text[cur] == '+'))
+            negative = text[cur++] == '-';
+
+        int value = 0;
+        for (; cur < text.size() && text[cur] >= '0' && text[cur] <= '9'; ++cur)
+            value = value * 10 + (text[cur] - '0');
+
+        return negative ? -value : value;
+    }
 }
 
-auto cCsvAlias::AddAlias(const char* name, size_t index) -> void
+auto cCsvAlias::AddAlias(std::string_view name, size_t index) -> void
 {
-	const auto & converted(Lower(name));
-
-    Assert(m_Name2Index.find(converted) == m_Name2Index.end());
+    Assert(m_Name2Index.find(name) == m_Name2Index.end());
     Assert(m_Index2Name.find(index) == m_Index2Name.end());
 
-    m_Name2Index.insert(NAME2INDEX_MAP::value_type(converted, index));
-    m_Index2Name.insert(INDEX2NAME_MAP::value_type(index, name));
+    m_Name2Index.emplace(std::string(name), index);
+    m_Index2Name.emplace(index, std::string(name));
 }
 
 auto cCsvAlias::Destroy() -> void
@@ -48,6 +72,16 @@ auto cCsvAlias::Destroy() -> void
     m_Index2Name.clear();
 }
 
+auto cCsvAlias::Find(std::string_view name, size_t& index) const -> bool
+{
+    const auto & it = m_Name2Index.find(name);
+    if (it == m_Name2Index.end())
+        return false;
+
+    index = it->second;
+    return true;
+}
+
 auto cCsvAlias::operator [](size_t index) const -> const char*
 {
 	const auto & it = m_Index2Name.find(index);
@@ -60,22 +94,59 @@ auto cCsvAlias::operator [](size_t index) const -> const char*
     return it->second.c_str();
 }
 
-auto cCsvAlias::operator [](const char* name) const -> size_t
+auto cCsvAlias::operator [](std::string_view name) const -> size_t
 {
-	const auto & it = m_Name2Index.find(Lower(name));
-    if (it == m_Name2Index.end())
-    {
+    size_t index = 0;
+    if (!Find(name, index))
         Assert(false && "cannot find suitable conversion");
-        return 0;
+
+    return index;
+}
+
+cCsvColumnMask::cCsvColumnMask(std::initializer_list<size_t> columns)
+: m_bAll(false)
+{
+    for (const auto index : columns)
+        AddColumn(index);
+}
+
+auto cCsvColumnMask::AddColumn(size_t index) -> void
+{
+    m_bAll = false;
+    if (index >= m_vecWanted.size())
+        m_vecWanted.resize(index + 1, false);
+
+    m_vecWanted[index] = true;
+}
+
+auto cCsvColumnMask::AddName(const char* name) -> void
+{
+    m_bAll = false;
+    m_vecName.emplace_back(Lower(name));
+}
+
+/**
+ * \brief
+ * Turn the wanted names into column indices, names missing from the header are ignored.
+ * \param: header: vector
+ */
+auto cCsvColumnMask::Resolve(const std::vector<std::string_view>& header) -> void
+{
+    for (const auto & name : m_vecName)
+    {
+        const auto & it = std::find_if(header.begin(), header.end(), [&name](std::string_view column) { return Lower(std::string(column)) == name; });
+        if (it != header.end())
+            AddColumn(static_cast<size_t>(it - header.begin()));
     }
 
-    return it->second;
+    m_vecName.clear();
 }
 
-auto cCsvFile::Load(const char* fileName, const char seperator, const char quote) -> bool
+auto cCsvFile::Load(const char* fileName, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
 {
     Assert(seperator != quote);
 
+    cProfileScope profile("csv_load");
     std::ifstream file(fileName, std::ios::in);
     if (!file) 
 		return false;
@@ -85,23 +156,48 @@ auto cCsvFile::Load(const char* fileName, const char seperator, const char quote
     cCsvRow * row = nullptr;
     ParseState state = STATE_NORMAL;
     std::string token;
+
+    // The header row is read in full, the mask applies from the next row on.
+    cCsvColumnMask columns;
+    size_t col = 0;
+    const char stops[] = { seperator, quote, '\0' };
 	
     char buf[2048+1] = {0,};
 
+    // Rows with a non-ASCII byte on one of their lines, only their fields can need transcoding.
+    std::vector<size_t> vecNonAsciiRow;
+    auto bNonAscii = false;
+
     while (file.good())
     {
         file.getline(buf, 2048);
         buf[sizeof(buf)-1] = 0;
+        profile.AddBytes(static_cast<uint64_t>(file.gcount()));
 
         std::string line(Trim(buf));
         if (line.empty() || (state == STATE_NORMAL && line[0] == '#'))
 			continue;
 
+        bNonAscii = bNonAscii || cTextEncoding::FindNonAscii(line) != line.size();
+
 		const auto & text  = std::string(line) + "  ";
         size_t cur = 0;
 
+        if (row == nullptr)
+            row = new cCsvRow();
+
         while (cur < text.size())
         {
+            // Unwanted fields are jumped over, past the last wanted column only quotes still matter.
+            if (!columns.Wants(col))
+            {
+                const auto next = state == STATE_QUOTE || col >= columns.GetColumnLimit() ? text.find(quote, cur) : text.find_first_of(stops, cur);
+                if (next == std::string::npos)
+                    break;
+
+                cur = next;
+            }
+
             if (state == STATE_QUOTE)
             {
                 if (text[cur] == quote)
@@ -123,12 +219,12 @@ auto cCsvFile::Load(const char* fileName, const char seperator, const char quote
             }
             else if (state == STATE_NORMAL)
             {
-                if (row == nullptr)
-                    row = new cCsvRow();
                 if (text[cur] == seperator)
                 {
-                    row->push_back(token);
+                    if (col < columns.GetColumnLimit())
+                        row->push_back(columns.Wants(col) ? token : std::string());
                     token.clear();
+                    ++col;
                 }
                 else if (text[cur] == quote)
                 {
@@ -146,67 +242,205 @@ auto cCsvFile::Load(const char* fileName, const char seperator, const char quote
         if (state == STATE_NORMAL)
         {
             Assert(row != NULL);
-            row->push_back(token.substr(0, token.size()-2));
+            if (col < columns.GetColumnLimit())
+                row->push_back(columns.Wants(col) ? token.substr(0, token.size()-2) : std::string());
+            if (bNonAscii)
+                vecNonAsciiRow.push_back(m_Rows.size());
             m_Rows.push_back(row);
             token.clear();
             row = nullptr;
+            col = 0;
+            bNonAscii = false;
+
+            if (m_Rows.size() == 1)
+            {
+                columns = mask;
+                columns.Resolve(std::vector<std::string_view>(m_Rows[0]->begin(), m_Rows[0]->end()));
+            }
         }
-        else
+        else if (columns.Wants(col))
         {
             token = token.substr(0, token.size()-2) + "\r\n";
         }
     }
 
 	file.close();
+    TranscodeFields(vecNonAsciiRow);
+    profile.AddRows(m_Rows.size());
     return true;
 }
 
+/**
+ * \brief
+ * Detect the encoding of the loaded fields and transcode the non-ASCII ones to UTF-8.
+ * \param: vecRow: vector, rows with a non-ASCII byte
+ */
+auto cCsvFile::TranscodeFields(const std::vector<size_t>& vecRow) -> void
+{
+    m_Encoding = cTextEncoding::ENCODING_ASCII;
+
+    // A byte order mark would stick to the first header name.
+    if (!m_Rows.empty() && !m_Rows[0]->empty() && m_Rows[0]->front().compare(0, 3, "\xEF\xBB\xBF") == 0)
+        m_Rows[0]->front().erase(0, 3);
+
+    std::vector<std::string*> vecField;
+    for (const auto index : vecRow)
+    {
+        for (auto & field : *m_Rows[index])
+        {
+            if (cTextEncoding::FindNonAscii(field) != field.size())
+                vecField.push_back(&field);
+        }
+    }
+
+    std::vector<std::string_view> vecText(vecField.size());
+    std::transform(vecField.begin(), vecField.end(), vecText.begin(), [](const std::string* field) { return std::string_view(*field); });
+
+    m_Encoding = cTextEncoding::Detect(vecText);
+    if (!cTextEncoding::NeedsTranscoding(m_Encoding))
+        return;
+
+    std::string text;
+    for (const auto field : vecField)
+    {
+        text.clear();
+        cTextEncoding::ToUtf8(*field, m_Encoding, text);
+        field->swap(text);
+    }
+}
+
 auto cCsvFile::Save(const char* fileName, bool append, char seperator, char quote) const -> bool
 {
     Assert(seperator != quote);
-    std::ofstream file;
-	file.open(fileName, std::ios::out | (append ? std::ios::app : std::ios::trunc));
+    cCsvWriter writer(seperator, quote);
+    if (!writer.Open(fileName, append))
+        return false;
 
-    if (!file) 
-		return false;
-
-    char special_chars[5] = { seperator, quote, '\r', '\n', 0 };
-    char quote_escape_string[3] = { quote, quote, 0 };
+#ifdef _WIN32
+    // Same line breaks as the text mode stream which used to write the file.
+    writer.SetLineEnd("\r\n");
+#endif
 
     for (size_t i = 0; i < m_Rows.size(); i++)
     {
-        const auto & row = *((*this)[i]);
+        for (const auto & token : *((*this)[i]))
+            writer.WriteField(token);
 
-        std::string line;
-        for (size_t j = 0; j < row.size(); j++)
-        {
-            const auto & token = row[j];
-            if (token.find_first_of(special_chars) == std::string::npos)
-            {
-                line += token;
-            }
-            else
-            {
-                line += quote;
-                for (auto k : token)
-                {
-                    if (k == quote) 
-						line += quote_escape_string;
-                    else 
-						line += k;
-                }
+        writer.EndRow();
+    }
 
-                line += quote;
-            }
+    return writer.Close();
+}
+
+/**
+ * \brief
+ * Open the file in binary mode, the stdio buffer is disabled as every write is already a large block.
+ * \param: fileName: string
+ * \param: append: bool
+ * \return: bool
+ */
+auto cCsvWriter::Open(const char* fileName, bool append) -> bool
+{
+    Close();
+
+    m_pFile = fopen(fileName, append ? "ab" : "wb");
+    if (!m_pFile)
+        return false;
+
+    setvbuf(m_pFile, nullptr, _IONBF, 0);
+    m_Buffer.reserve(BUFFER_SIZE);
+    m_bFirstField = true;
+    m_bError = false;
+    return true;
+}
+
+/**
+ * \brief
+ * Write what is buffered and close the file.
+ * \return: bool, false if any write failed
+ */
+auto cCsvWriter::Close() -> bool
+{
+    if (!m_pFile)
+        return !m_bError;
+
+    FlushBuffer();
+    if (fclose(m_pFile) != 0)
+        m_bError = true;
+
+    m_pFile = nullptr;
+    return !m_bError;
+}
+
+auto cCsvWriter::WriteField(std::string_view field) -> void
+{
+    if (!m_bFirstField)
+        m_Buffer += m_Seperator;
+
+    m_bFirstField = false;
 
-            if (j != row.size() - 1)
-				line += seperator;
+    const char special_chars[] = { m_Seperator, m_Quote, '\r', '\n' };
+    if (field.find_first_of(special_chars, 0, sizeof(special_chars)) == std::string_view::npos)
+    {
+        m_Buffer.append(field);
+    }
+    else
+    {
+        m_Buffer += m_Quote;
+        for (size_t begin = 0;;)
+        {
+            const auto end = field.find(m_Quote, begin);
+            m_Buffer.append(field.substr(begin, end - begin));
+            if (end == std::string_view::npos)
+                break;
+
+            m_Buffer += m_Quote;
+            m_Buffer += m_Quote;
+            begin = end + 1;
         }
 
-        file << line << std::endl;
+        m_Buffer += m_Quote;
     }
 
-    return true;
+    if (m_Buffer.size() >= BUFFER_SIZE)
+        FlushBuffer();
+}
+
+/**
+ * \brief
+ * Write bytes as they are, e.g. a row copied from the source file.
+ * \param: text: string_view
+ */
+auto cCsvWriter::WriteRaw(std::string_view text) -> void
+{
+    if (text.size() >= BUFFER_SIZE)
+    {
+        FlushBuffer();
+        if (m_pFile && fwrite(text.data(), 1, text.size(), m_pFile) != text.size())
+            m_bError = true;
+        return;
+    }
+
+    m_Buffer.append(text);
+    if (m_Buffer.size() >= BUFFER_SIZE)
+        FlushBuffer();
+}
+
+auto cCsvWriter::EndRow() -> void
+{
+    m_Buffer.append(m_LineEnd);
+    m_bFirstField = true;
+
+    if (m_Buffer.size() >= BUFFER_SIZE)
+        FlushBuffer();
+}
+
+auto cCsvWriter::FlushBuffer() -> void
+{
+    if (m_pFile && !m_Buffer.empty() && fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_pFile) != m_Buffer.size())
+        m_bError = true;
+
+    m_Buffer.clear();
 }
 
 auto cCsvFile::Destroy() -> void
@@ -229,8 +463,508 @@ auto cCsvFile::operator [](size_t index) const -> const cCsvRow *
     return m_Rows[index];
 }
 
+auto cCsvMappedFile::Load(const char* fileName, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
+{
+    Destroy();
+    if (!m_Mapping.Open(fileName))
+        return false;
+
+    return Parse(seperator, quote, mask);
+}
+
+/**
+ * \brief
+ * Load the contents of a file held in memory (e.g. an unsaved editor buffer), the fields are views into the kept data.
+ */
+auto cCsvMappedFile::LoadBuffer(std::string data, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
+{
+    Destroy();
+    m_Mapping.Assign(std::move(data));
+    return Parse(seperator, quote, mask);
+}
+
+auto cCsvMappedFile::Parse(const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
+{
+    cProfileScope profile("csv_load_mapped");
+    profile.AddBytes(m_Mapping.Size());
+
+    Assert(seperator != quote);
+    Assert(seperator != '\n' && quote != '\n');
+
+    // With a mask the names are resolved against the header row first, the header row is then kept in full.
+    auto columns = mask;
+    if (!columns.IsAll())
+    {
+        SChunk header;
+        header.end = m_Mapping.Size();
+        ParseChunk(header, seperator, quote, cCsvColumnMask(), 0, 1);
+        columns.Resolve(header.fields);
+    }
+
+    auto chunks = SplitChunks(0, quote);
+    if (chunks.size() == 1)
+    {
+        auto & chunk = chunks[0];
+        ParseChunk(chunk, seperator, quote, columns, 1);
+
+        m_Fields = std::move(chunk.fields);
+        m_RowOffsets = std::move(chunk.rowOffsets);
+        m_RowLines = std::move(chunk.rowLines);
+        m_Unescaped = std::move(chunk.unescaped);
+        TranscodeFields(columns.IsAll());
+        profile.AddRows(GetRowCount());
+        return true;
+    }
+
+    auto & pool = CThreadPool::Instance();
+    pool.ParallelFor(chunks.size(), [&](size_t index) { ParseChunk(chunks[index], seperator, quote, columns, index == 0 ? 1 : 0); });
+
+    // Stitch the chunks back in order, every chunk copies itself to its final position in parallel.
+    std::vector<size_t> fieldBase(chunks.size() + 1, 0);
+    std::vector<size_t> rowBase(chunks.size() + 1, 0);
+    std::vector<uint32_t> lineBase(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        fieldBase[i + 1] = fieldBase[i] + chunks[i].fields.size();
+        rowBase[i + 1] = rowBase[i] + chunks[i].rowLines.size();
+        lineBase[i + 1] = lineBase[i] + chunks[i].lineCount;
+    }
+
+    m_Fields.resize(fieldBase.back());
+    m_RowOffsets.resize(rowBase.back() + 1, 0);
+    m_RowLines.resize(rowBase.back());
+
+    pool.ParallelFor(chunks.size(), [&](size_t index)
+    {
+        const auto & chunk = chunks[index];
+        std::copy(chunk.fields.begin(), chunk.fields.end(), m_Fields.begin() + fieldBase[index]);
+
+        for (size_t row = 0; row < chunk.rowLines.size(); ++row)
+        {
+            m_RowOffsets[rowBase[index] + row + 1] = static_cast<uint32_t>(fieldBase[index]) + chunk.rowOffsets[row + 1];
+            m_RowLines[rowBase[index] + row] = lineBase[index] + chunk.rowLines[row];
+        }
+    });
+
+    for (auto & chunk : chunks)
+        std::move(chunk.unescaped.begin(), chunk.unescaped.end(), std::back_inserter(m_Unescaped));
+
+    TranscodeFields(columns.IsAll());
+    profile.AddRows(GetRowCount());
+    return true;
+}
+
+/**
+ * \brief
+ * Detect the encoding of the loaded fields and transcode the ones which hold non-ASCII bytes to UTF-8.
+ * When every column was loaded the fields are matched against the non-ASCII bytes found in the mapping,
+ * an ASCII file costs one pass. With a column mask only the loaded fields are looked at (the skipped ones are empty),
+ * a vnum column never pays for the names next to it.
+ * Transcoded fields of a block share one buffer, ASCII and UTF-8 fields stay views into the mapping.
+ * \param: bAllColumns: bool
+ */
+auto cCsvMappedFile::TranscodeFields(bool bAllColumns) -> void
+{
+    const auto & data = GetData();
+    m_Encoding = cTextEncoding::ENCODING_ASCII;
+
+    // A byte order mark would stick to the first header name.
+    if (!m_Fields.empty() && m_Fields[0].data() == data.data() && m_Fields[0].compare(0, 3, "\xEF\xBB\xBF") == 0)
+        m_Fields[0].remove_prefix(3);
+
+    std::vector<uint32_t> vecIndex;
+    if (bAllColumns)
+    {
+        // Fields are views in file order, walk them along with the non-ASCII bytes of the mapping.
+        auto next = cTextEncoding::FindNonAscii(data);
+        for (uint32_t index = 0; index < m_Fields.size() && next < data.size(); ++index)
+        {
+            const auto & field = m_Fields[index];
+            const auto begin = static_cast<size_t>(field.data() - data.data());
+            if (field.data() < data.data() || begin >= data.size())
+            {
+                if (cTextEncoding::FindNonAscii(field) != field.size())
+                    vecIndex.push_back(index);
+                continue;
+            }
+
+            if (next < begin)
+                next = cTextEncoding::FindNonAscii(data, begin);
+
+            if (next < begin + field.size())
+            {
+                vecIndex.push_back(index);
+                next = cTextEncoding::FindNonAscii(data, begin + field.size());
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t index = 0; index < m_Fields.size(); ++index)
+        {
+            if (!m_Fields[index].empty() && cTextEncoding::FindNonAscii(m_Fields[index]) != m_Fields[index].size())
+                vecIndex.push_back(index);
+        }
+    }
+
+    std::vector<std::string_view> vecText(vecIndex.size());
+    std::transform(vecIndex.begin(), vecIndex.end(), vecText.begin(), [this](uint32_t index) { return m_Fields[index]; });
+
+    m_Encoding = cTextEncoding::Detect(vecText);
+    if (!cTextEncoding::NeedsTranscoding(m_Encoding))
+        return;
+
+    const auto blockCount = (vecIndex.size() + TRANSCODE_BLOCK_SIZE - 1) / TRANSCODE_BLOCK_SIZE;
+    std::vector<std::unique_ptr<std::string>> vecBuffer(blockCount);
+
+    CThreadPool::Instance().ParallelFor(blockCount, [&](size_t block)
+    {
+        const auto begin = block * TRANSCODE_BLOCK_SIZE;
+        const auto end = std::min(vecIndex.size(), begin + TRANSCODE_BLOCK_SIZE);
+
+        size_t bytes = 0;
+        for (auto i = begin; i < end; ++i)
+            bytes += vecText[i].size();
+
+        // The buffer may grow while it's filled, the views are taken once it's complete.
+        auto & buffer = vecBuffer[block] = std::make_unique<std::string>();
+        std::vector<size_t> vecOffset{ 0 };
+        buffer->reserve(bytes * 2);
+        for (auto i = begin; i < end; ++i)
+        {
+            cTextEncoding::ToUtf8(vecText[i], m_Encoding, *buffer);
+            vecOffset.push_back(buffer->size());
+        }
+
+        for (auto i = begin; i < end; ++i)
+            m_Fields[vecIndex[i]] = std::string_view(buffer->data() + vecOffset[i - begin], vecOffset[i - begin + 1] - vecOffset[i - begin]);
+    });
+
+    std::move(vecBuffer.begin(), vecBuffer.end(), std::back_inserter(m_Unescaped));
+}
+
+/**
+ * \brief
+ * Cut the mapping from a line boundary to its end into chunks at line boundaries.
+ * A multi-line quoted field must not be split, so every chunk first works out the quote state it leaves behind
+ * for both possible entry states; chunks which would start inside a quoted field are merged into the previous one.
+ * \param: begin: size_t
+ * \param: quote: char
+ * \return: vector
+ */
+auto cCsvMappedFile::SplitChunks(size_t begin, const char quote) const -> std::vector<SChunk>
+{
+    const char* const data = m_Mapping.Data();
+    const size_t size = m_Mapping.Size();
+
+    auto & pool = CThreadPool::Instance();
+    auto chunkCount = pool.GetThreadCount() > 1 ? std::min(pool.GetThreadCount() * 4, (size - begin) / PARALLEL_CHUNK_SIZE) : 1;
+    if (m_ChunkCount)
+        chunkCount = std::min(m_ChunkCount, size - begin);
+
+    std::vector<SChunk> chunks(1);
+    chunks[0].begin = begin;
+    chunks[0].end = size;
+    if (chunkCount < 2)
+        return chunks;
+
+    std::vector<size_t> boundaries{ begin };
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+        const auto nominal = std::max(begin + (size - begin) * i / chunkCount, boundaries.back());
+        const auto newLine = static_cast<const char*>(memchr(data + nominal, '\n', size - nominal));
+        if (!newLine)
+            break;
+
+        const auto boundary = static_cast<size_t>(newLine - data) + 1;
+        if (boundary > boundaries.back() && boundary < size)
+            boundaries.push_back(boundary);
+    }
+    boundaries.push_back(size);
+
+    // transfer[i][state] is the quote state at the end of chunk i when it is entered in the given state.
+    std::vector<std::array<ParseState, 2>> transfer(boundaries.size() - 1);
+    pool.ParallelFor(transfer.size(), [&](size_t index)
+    {
+        const auto begin = boundaries[index];
+        const auto end = boundaries[index + 1];
+        std::array<ParseState, 2> states{ STATE_NORMAL, STATE_QUOTE };
+
+        for (auto pos = begin; pos < end && memchr(data + pos, quote, end - pos);)
+        {
+            const auto newLine = static_cast<const char*>(memchr(data + pos, '\n', end - pos));
+            const auto lineEnd = newLine ? static_cast<size_t>(newLine - data) : end;
+
+            size_t lineBegin = pos;
+            while (lineBegin < lineEnd && IsTrimChar(data[lineBegin]))
+                ++lineBegin;
+
+            if (lineBegin < lineEnd)
+            {
+                const auto quoteCount = std::count(data + lineBegin, data + lineEnd, quote);
+                for (auto & state : states)
+                {
+                    if (state == STATE_NORMAL && data[lineBegin] == '#')
+                        continue;
+                    if (quoteCount & 1)
+                        state = state == STATE_NORMAL ? STATE_QUOTE : STATE_NORMAL;
+                }
+            }
+
+            pos = lineEnd + 1;
+        }
+
+        transfer[index] = states;
+    });
+
+    chunks.clear();
+    auto state = STATE_NORMAL;
+    for (size_t i = 0; i < transfer.size(); ++i)
+    {
+        if (state == STATE_NORMAL)
+        {
+            chunks.emplace_back();
+            chunks.back().begin = boundaries[i];
+        }
+
+        chunks.back().end = boundaries[i + 1];
+        state = transfer[i][state];
+    }
+
+    return chunks;
+}
+
+/**
+ * \brief
+ * Tokenize the rows of one chunk, stopping early once rowLimit rows are read.
+ * \param: chunk: SChunk
+ * \param: seperator: char
+ * \param: quote: char
+ * \param: mask: cCsvColumnMask, resolved
+ * \param: fullRows: size_t, leading rows kept in full whatever the mask (the header row)
+ * \param: rowLimit: size_t
+ */
+auto cCsvMappedFile::ParseChunk(SChunk& chunk, const char seperator, const char quote, const cCsvColumnMask& mask, size_t fullRows, size_t rowLimit) const -> void
+{
+    const char* const data = m_Mapping.Data();
+    const auto columnLimit = mask.GetColumnLimit();
+
+    // A projection of the leading columns finds its few separators per line, a deeper one cuts them from the index.
+    const auto scanSeperators = mask.IsAll() || columnLimit > PROJECTION_MEMCHR_COLUMNS;
+    std::vector<char> vecWanted(mask.IsAll() ? 0 : columnLimit);
+    for (size_t col = 0; col < vecWanted.size(); ++col)
+        vecWanted[col] = mask.Wants(col);
+
+    ParseState state = STATE_NORMAL;
+    std::vector<std::string> tokens;
+    std::string token;
+    uint32_t rowLine = 0;
+
+    chunk.rowOffsets.push_back(0);
+
+    const auto ParseLine = [&](size_t begin, size_t end, uint32_t line, const std::vector<size_t>& seperators, bool hasQuote)
+    {
+        while (begin < end && IsTrimChar(data[end - 1]))
+            --end;
+        while (begin < end && IsTrimChar(data[begin]))
+            ++begin;
+
+        if (begin == end || (state == STATE_NORMAL && data[begin] == '#'))
+            return;
+
+        // A projected row only cuts its leading fields up to the last wanted one, the others stay empty.
+        const auto projected = !mask.IsAll() && chunk.rowLines.size() >= fullRows;
+        const auto limit = projected ? columnLimit : SIZE_MAX;
+
+        // A line without quotes is a complete row, every field is a plain view into the mapping.
+        if (state == STATE_NORMAL && !hasQuote)
+        {
+            size_t fieldBegin = begin;
+            size_t col = 0;
+            const auto AddField = [&](size_t fieldEnd)
+            {
+                chunk.fields.emplace_back(!projected || vecWanted[col] ? std::string_view(data + fieldBegin, fieldEnd - fieldBegin) : std::string_view());
+                fieldBegin = fieldEnd + 1;
+                ++col;
+            };
+
+            if (scanSeperators)
+            {
+                for (const auto sep : seperators)
+                {
+                    if (sep < begin)
+                        continue;
+                    if (sep >= end || col == limit)
+                        break;
+
+                    AddField(sep);
+                }
+            }
+            else
+            {
+                while (col < limit)
+                {
+                    const auto sep = static_cast<const char*>(memchr(data + fieldBegin, seperator, end - fieldBegin));
+                    if (!sep)
+                        break;
+
+                    AddField(static_cast<size_t>(sep - data));
+                }
+            }
+
+            if (col < limit)
+                AddField(end);
+
+            chunk.rowOffsets.push_back(static_cast<uint32_t>(chunk.fields.size()));
+            chunk.rowLines.push_back(line);
+            return;
+        }
+
+        // Quoted rows go through the same state machine as cCsvFile::Load, including the two padding characters.
+        if (state == STATE_NORMAL)
+            rowLine = line;
+
+        const size_t length = end - begin;
+        const auto text = [&](size_t cur) { return cur < length ? data[begin + cur] : ' '; };
+
+        for (size_t cur = 0; cur < length + 2; ++cur)
+        {
+            const char c = text(cur);
+            if (state == STATE_QUOTE)
+            {
+                if (c == quote)
+                {
+                    if (text(cur + 1) == quote)
+                    {
+                        token += quote;
+                        ++cur;
+                    }
+                    else
+                    {
+                        state = STATE_NORMAL;
+                    }
+                }
+                else
+                {
+                    token += c;
+                }
+            }
+            else if (c == seperator)
+            {
+                tokens.push_back(token);
+                token.clear();
+            }
+            else if (c == quote)
+            {
+                state = STATE_QUOTE;
+            }
+            else
+            {
+                token += c;
+            }
+        }
+
+        if (state == STATE_QUOTE)
+        {
+            token.resize(token.size() - 2);
+            token += "\r\n";
+            return;
+        }
+
+        token.resize(token.size() - 2);
+        tokens.push_back(token);
+        token.clear();
+
+        if (tokens.size() > limit)
+            tokens.resize(limit);
+        for (size_t col = 0; projected && col < tokens.size(); ++col)
+        {
+            if (!vecWanted[col])
+                tokens[col].clear();
+        }
+
+        chunk.unescaped.emplace_back(std::make_unique<std::string>());
+        auto & arena = *chunk.unescaped.back();
+        for (const auto & it : tokens)
+            arena += it;
+
+        size_t offset = 0;
+        for (const auto & it : tokens)
+        {
+            chunk.fields.emplace_back(arena.data() + offset, it.size());
+            offset += it.size();
+        }
+
+        tokens.clear();
+        chunk.rowOffsets.push_back(static_cast<uint32_t>(chunk.fields.size()));
+        chunk.rowLines.push_back(rowLine);
+    };
+
+    // The structural index is built one block at a time so it stays in cache while the tokenizer consumes it.
+    // A projection of the leading columns doesn't need the separators of the index, the few it uses are found per line.
+    const cCsvScanner scanner(scanSeperators ? seperator : '\n', quote, m_ScannerImplementation);
+    const auto size = chunk.end - chunk.begin;
+    const auto blockCapacity = static_cast<uint32_t>(std::min<size_t>(size, SCAN_BLOCK_SIZE));
+    std::unique_ptr<uint32_t[]> index(new uint32_t[blockCapacity + 1]);
+
+    std::vector<size_t> seperators;
+    bool hasQuote = false;
+    size_t lineBegin = chunk.begin;
+    uint32_t line = 0;
+
+    for (size_t base = chunk.begin; base < chunk.end; base += SCAN_BLOCK_SIZE)
+    {
+        const auto blockSize = static_cast<uint32_t>(std::min<size_t>(SCAN_BLOCK_SIZE, chunk.end - base));
+        const auto count = scanner.Scan(data + base, blockSize, index.get());
+        if (base == chunk.begin)
+            chunk.fields.reserve(static_cast<size_t>(count) * (size / blockSize) + count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const auto pos = base + index[i];
+            const auto c = data[pos];
+            if (c == '\n')
+            {
+                ParseLine(lineBegin, pos, ++line, seperators, hasQuote);
+                seperators.clear();
+                hasQuote = false;
+                lineBegin = pos + 1;
+
+                if (chunk.rowLines.size() >= rowLimit)
+                {
+                    chunk.end = lineBegin;
+                    chunk.lineCount = line;
+                    return;
+                }
+            }
+            else if (c == quote)
+            {
+                hasQuote = true;
+            }
+            else
+            {
+                seperators.push_back(pos);
+            }
+        }
+    }
+
+    if (lineBegin < chunk.end)
+        ParseLine(lineBegin, chunk.end, ++line, seperators, hasQuote);
+
+    chunk.lineCount = line;
+}
+
+auto cCsvMappedFile::Destroy() -> void
+{
+    m_Fields.clear();
+    m_RowOffsets.clear();
+    m_RowLines.clear();
+    m_Unescaped.clear();
+    m_Mapping.Close();
+}
+
 cCsvTable::cCsvTable()
-: m_CurRow(-1)
+: m_CurRow(-1), m_bMapped(false)
 {
 }
 
@@ -238,24 +972,63 @@ cCsvTable::~cCsvTable()
 {
 }
 
-auto cCsvTable::Load(const char* fileName, const char seperator, const char quote) -> bool
+auto cCsvTable::Load(const char* fileName, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
 {
     Destroy();
-    return m_File.Load(fileName, seperator, quote);
+    m_bMapped = false;
+    return m_File.Load(fileName, seperator, quote, mask);
+}
+
+auto cCsvTable::LoadMapped(const char* fileName, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
+{
+    Destroy();
+    m_bMapped = true;
+    return m_MappedFile.Load(fileName, seperator, quote, mask);
+}
+
+auto cCsvTable::LoadBuffer(std::string data, const char seperator, const char quote, const cCsvColumnMask& mask) -> bool
+{
+    Destroy();
+    m_bMapped = true;
+    return m_MappedFile.LoadBuffer(std::move(data), seperator, quote, mask);
 }
 
 auto cCsvTable::Next() -> bool
 {
-    return ++m_CurRow < static_cast<int>(m_File.GetRowCount());
+    return ++m_CurRow < static_cast<int>(RowCount());
+}
+
+auto cCsvTable::RowCount() const -> size_t
+{
+    return m_bMapped ? m_MappedFile.GetRowCount() : m_File.GetRowCount();
 }
 
 auto cCsvTable::ColCount() const -> size_t
 {
+    if (m_bMapped)
+        return HasCurRow() ? m_MappedFile.GetColCount(m_CurRow) : 0;
+
     return CurRow()->size();
 }
 
+auto cCsvTable::GetEncoding() const -> cTextEncoding::EEncoding
+{
+    return m_bMapped ? m_MappedFile.GetEncoding() : m_File.GetEncoding();
+}
+
+auto cCsvTable::CurLine() const -> uint32_t
+{
+    if (m_bMapped)
+        return HasCurRow() ? m_MappedFile.GetLine(m_CurRow) : 0;
+
+    return static_cast<uint32_t>(m_CurRow + 1);
+}
+
 auto cCsvTable::AsInt(size_t index) const -> int
 {
+    if (m_bMapped)
+        return ToInt(AsStringViewByIndex(index));
+
     const cCsvRow* const row = CurRow();
     Assert(row);
     Assert(index < row->size());
@@ -264,6 +1037,9 @@ auto cCsvTable::AsInt(size_t index) const -> int
 
 auto cCsvTable::AsDouble(size_t index) const -> double
 {
+    if (m_bMapped)
+        return atof(std::string(AsStringViewByIndex(index)).c_str());
+
     const auto row = CurRow();
     Assert(row);
     Assert(index < row->size());
@@ -272,31 +1048,101 @@ auto cCsvTable::AsDouble(size_t index) const -> double
 
 auto cCsvTable::AsStringByIndex(size_t index) const -> std::string
 {
+    if (m_bMapped)
+        return std::string(AsStringViewByIndex(index));
+
     const auto row = CurRow();
     Assert(row);
     Assert(index < row->size());
     return row->AsString(index);
 }
 
+auto cCsvTable::AsStringViewByIndex(size_t index) const -> std::string_view
+{
+    if (m_bMapped)
+    {
+        if (!HasCurRow())
+            return {};
+
+        Assert(index < m_MappedFile.GetColCount(m_CurRow));
+        return m_MappedFile.GetField(m_CurRow, index);
+    }
+
+    const auto row = CurRow();
+    Assert(row);
+    Assert(index < row->size());
+    return row->at(index);
+}
+
+/**
+ * \brief
+ * Fields of the first row of the file, its header.
+ * \return: vector, views into the loaded file
+ */
+auto cCsvTable::GetHeader() const -> std::vector<std::string_view>
+{
+    std::vector<std::string_view> vecHeader;
+    if (m_bMapped)
+    {
+        if (m_MappedFile.GetRowCount() == 0)
+            return vecHeader;
+
+        for (size_t col = 0; col < m_MappedFile.GetColCount(0); ++col)
+            vecHeader.emplace_back(m_MappedFile.GetField(0, col));
+        return vecHeader;
+    }
+
+    if (m_File.GetRowCount() == 0)
+        return vecHeader;
+
+    for (const auto & field : *m_File[0])
+        vecHeader.emplace_back(field);
+    return vecHeader;
+}
+
+/**
+ * \brief
+ * Alias every header field to its index so fields can be read by name, a repeated name keeps its first index.
+ */
+auto cCsvTable::AddHeaderAliases() -> void
+{
+    const auto vecHeader = GetHeader();
+    for (size_t col = 0; col < vecHeader.size(); ++col)
+    {
+        size_t index;
+        if (!m_Alias.Find(vecHeader[col], index))
+            m_Alias.AddAlias(vecHeader[col], col);
+    }
+}
+
 auto cCsvTable::Destroy() -> void
 {
     m_File.Destroy();
+    m_MappedFile.Destroy();
     m_Alias.Destroy();
     m_CurRow = -1;
 }
 
-auto cCsvTable::CurRow() const -> const cCsvRow*
+auto cCsvTable::HasCurRow() const -> bool
 {
     if (m_CurRow < 0)
     {
         Assert(false && "call Next() first!");
-        return nullptr;
+        return false;
     }
-    else if (m_CurRow >= static_cast<int>(m_File.GetRowCount()))
+    else if (m_CurRow >= static_cast<int>(RowCount()))
     {
         Assert(false && "no more rows!");
-        return nullptr;
+        return false;
     }
 
+    return true;
+}
+
+auto cCsvTable::CurRow() const -> const cCsvRow*
+{
+    if (!HasCurRow())
+        return nullptr;
+
     return m_File[m_CurRow];
 }
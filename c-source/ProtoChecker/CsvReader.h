@@ -2,12 +2,55 @@
 #define __CSVFILE_H__
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
+#include <initializer_list>
+#include "MappedFile.h"
+#include "CsvScanner.h"
+#include "TextEncoding.h"
+
+/**
+ * \brief
+ * Type a schema column is read as by cCsvTable::Get.
+ */
+enum ECsvFieldType
+{
+	CSV_FIELD_INT,
+	CSV_FIELD_STRING,
+};
 
+struct SCsvSchemaColumn
+{
+	std::string_view name;
+	ECsvFieldType type;
+};
+
+template <typename TSchema>
+class cCsvSchema;
+
+/**
+ * \brief
+ * Runtime map between the header names and the indices of a file, names match case insensitively.
+ * Lookups compare in place, so finding a name never allocates.
+ */
 class cCsvAlias
 {
 	private:
-		using NAME2INDEX_MAP = std::map<std::string, size_t>;
+		struct SNameLess
+		{
+			using is_transparent = void;
+
+			auto operator ()(std::string_view left, std::string_view right) const -> bool
+			{
+				return std::lexicographical_compare(left.begin(), left.end(), right.begin(), right.end(), [](char a, char b)
+				{
+					return tolower(static_cast<unsigned char>(a)) < tolower(static_cast<unsigned char>(b));
+				});
+			}
+		};
+
+		using NAME2INDEX_MAP = std::map<std::string, size_t, SNameLess>;
 		using INDEX2NAME_MAP = std::map<size_t, std::string>;
 
 		NAME2INDEX_MAP m_Name2Index;
@@ -18,10 +61,11 @@ class cCsvAlias
 		virtual ~cCsvAlias() = default;
 
 	public:
-		auto AddAlias(const char* name, size_t index) -> void;
+		auto AddAlias(std::string_view name, size_t index) -> void;
 		auto Destroy() -> void;
+		auto Find(std::string_view name, size_t& index) const -> bool;
 		auto operator [](size_t index) const -> const char*;
-		auto operator [](const char* name) const -> size_t;
+		auto operator [](std::string_view name) const -> size_t;
 
 	private:
 		cCsvAlias(const cCsvAlias&) {}
@@ -77,18 +121,66 @@ class cCsvRow : public std::vector<std::string>
 		}
 };
 
+/**
+ * \brief
+ * Columns a loader has to materialize, by index and/or by header name.
+ * A default mask keeps every column. The first row of a file is the header and is always read in full,
+ * names are resolved against it; every following row only stores fields up to the last wanted column,
+ * unwanted fields before it are left empty and never copied.
+ */
+class cCsvColumnMask
+{
+	private:
+		bool m_bAll;
+		std::vector<bool> m_vecWanted;
+		std::vector<std::string> m_vecName;
+
+	public:
+		cCsvColumnMask() : m_bAll(true) {}
+		cCsvColumnMask(std::initializer_list<size_t> columns);
+
+	public:
+		auto AddColumn(size_t index) -> void;
+		auto AddName(const char* name) -> void;
+		auto Resolve(const std::vector<std::string_view>& header) -> void;
+
+		auto IsAll() const -> bool
+		{
+			return m_bAll;
+		}
+
+		auto Wants(size_t index) const -> bool
+		{
+			return m_bAll || (index < m_vecWanted.size() && m_vecWanted[index]);
+		}
+
+		/**
+		 * \brief
+		 * Number of leading columns a row has to keep, SIZE_MAX when every column is wanted.
+		 */
+		auto GetColumnLimit() const -> size_t
+		{
+			return m_bAll ? SIZE_MAX : m_vecWanted.size();
+		}
+};
+
+/**
+ * \brief
+ * Line based csv loader, the loaded fields are transcoded to UTF-8 (see cTextEncoding).
+ */
 class cCsvFile
 {
 	private:
 		typedef std::vector<cCsvRow*> ROWS;
 		ROWS m_Rows;
+		cTextEncoding::EEncoding m_Encoding = cTextEncoding::ENCODING_ASCII;
 
 	public:
 		cCsvFile() = default;
 		virtual ~cCsvFile() { Destroy(); }
 
 	public:
-		auto Load(const char* fileName, const char seperator = ',', const char quote = '"') -> bool;
+		auto Load(const char* fileName, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask()) -> bool;
 		auto Save(const char* fileName, bool append = false, char seperator = ',', char quote = '"') const -> bool;
 		auto Destroy() -> void;
 
@@ -100,7 +192,18 @@ class cCsvFile
 			return m_Rows.size();
 		}
 
+		/**
+		 * \brief
+		 * Encoding the loaded fields had in the file.
+		 */
+		auto GetEncoding() const -> cTextEncoding::EEncoding
+		{
+			return m_Encoding;
+		}
+
 	private:
+		auto TranscodeFields(const std::vector<size_t>& vecRow) -> void;
+
 		cCsvFile(const cCsvFile &) {}
 
 		auto operator =(const cCsvFile&) const -> const cCsvFile&
@@ -109,13 +212,186 @@ class cCsvFile
 		}
 };
 
+/**
+ * \brief
+ * Buffered csv writer.
+ * Rows are built in one large buffer which is handed to the file in big blocks (large raw blocks go straight through),
+ * so writing costs one copy per byte and a system call per megabyte instead of a flush per line.
+ * A field is quoted only when it contains the seperator, the quote or a line break.
+ */
+class cCsvWriter
+{
+	private:
+		static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+		FILE * m_pFile = nullptr;
+		std::string m_Buffer;
+		std::string m_LineEnd = "\n";
+		char m_Seperator;
+		char m_Quote;
+		bool m_bFirstField = true;
+		bool m_bError = false;
+
+	public:
+		explicit cCsvWriter(const char seperator = ',', const char quote = '"') : m_Seperator(seperator), m_Quote(quote) {}
+		virtual ~cCsvWriter() { Close(); }
+
+	public:
+		auto Open(const char* fileName, bool append = false) -> bool;
+		auto Close() -> bool;
+
+		auto WriteField(std::string_view field) -> void;
+		auto WriteRaw(std::string_view text) -> void;
+		auto EndRow() -> void;
+
+		auto SetLineEnd(std::string_view lineEnd) -> void
+		{
+			m_LineEnd = lineEnd;
+		}
+
+	private:
+		auto FlushBuffer() -> void;
+
+		cCsvWriter(const cCsvWriter&) {}
+
+		auto operator =(const cCsvWriter&) const -> const cCsvWriter&
+		{
+			return *this;
+		}
+};
+
+/**
+ * \brief
+ * Zero-copy csv loader, the file is memory mapped and every field is a view into the mapping.
+ * Fields of all rows live in one contiguous array, m_RowOffsets[row] is the index of the first field of a row.
+ * Quoted fields which need unescaping (or span several lines) are materialized once into m_Unescaped.
+ * Lines are found through the structural index of cCsvScanner, quote-free lines are split without touching other bytes.
+ * Big files are cut into chunks at line boundaries which are parsed in parallel and stitched back in order.
+ * With a column mask rows are only cut up to their last wanted field, a mask of the leading few columns cuts them with memchr.
+ * Loaded fields of a CP949 or windows-1252 file which hold non-ASCII bytes are transcoded to UTF-8,
+ * so names are compared and reported as UTF-8.
+ */
+class cCsvMappedFile
+{
+	private:
+		static constexpr size_t SCAN_BLOCK_SIZE = 1 << 20;
+		static constexpr size_t PARALLEL_CHUNK_SIZE = 1 << 20;
+		static constexpr size_t TRANSCODE_BLOCK_SIZE = 1 << 16;
+		static constexpr size_t PROJECTION_MEMCHR_COLUMNS = 4;
+
+		/**
+		 * \brief
+		 * Rows parsed from a byte range of the mapping which starts at a line boundary outside of a quoted field.
+		 * Row offsets are field indices and lines are counted from the start of the chunk.
+		 */
+		struct SChunk
+		{
+			size_t begin = 0;
+			size_t end = 0;
+			uint32_t lineCount = 0;
+			std::vector<std::string_view> fields;
+			std::vector<uint32_t> rowOffsets;
+			std::vector<uint32_t> rowLines;
+			std::vector<std::unique_ptr<std::string>> unescaped;
+		};
+
+		cMappedFile m_Mapping;
+		std::vector<std::string_view> m_Fields;
+		std::vector<uint32_t> m_RowOffsets;
+		std::vector<uint32_t> m_RowLines;
+		std::vector<std::unique_ptr<std::string>> m_Unescaped;
+		cCsvScanner::EImplementation m_ScannerImplementation = cCsvScanner::IMPL_AVX512;
+		size_t m_ChunkCount = 0;
+		cTextEncoding::EEncoding m_Encoding = cTextEncoding::ENCODING_ASCII;
+
+	public:
+		cCsvMappedFile() = default;
+		virtual ~cCsvMappedFile() { Destroy(); }
+
+	public:
+		auto Load(const char* fileName, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask()) -> bool;
+		auto LoadBuffer(std::string data, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask()) -> bool;
+		auto Destroy() -> void;
+
+		auto GetRowCount() const -> size_t
+		{
+			return m_RowLines.size();
+		}
+
+		auto GetColCount(size_t row) const -> size_t
+		{
+			return m_RowOffsets[row + 1] - m_RowOffsets[row];
+		}
+
+		auto GetField(size_t row, size_t col) const -> std::string_view
+		{
+			return m_Fields[m_RowOffsets[row] + col];
+		}
+
+		auto GetLine(size_t row) const -> uint32_t
+		{
+			return m_RowLines[row];
+		}
+
+		/**
+		 * \brief
+		 * Raw bytes of the loaded file, valid until Destroy().
+		 */
+		auto GetData() const -> std::string_view
+		{
+			return m_Mapping.Size() ? std::string_view(m_Mapping.Data(), m_Mapping.Size()) : std::string_view();
+		}
+
+		/**
+		 * \brief
+		 * Encoding the loaded fields had in the file, ASCII when none of them holds a non-ASCII byte.
+		 */
+		auto GetEncoding() const -> cTextEncoding::EEncoding
+		{
+			return m_Encoding;
+		}
+
+		/**
+		 * \brief
+		 * Cap the instruction set used by the structural scanner, the best supported one is used by default.
+		 */
+		auto SetScannerImplementation(cCsvScanner::EImplementation implementation) -> void
+		{
+			m_ScannerImplementation = implementation;
+		}
+
+		/**
+		 * \brief
+		 * Cut the file into this many chunks whatever its size and the thread count, 0 (default) leaves it to the loader.
+		 */
+		auto SetChunkCount(size_t count) -> void
+		{
+			m_ChunkCount = count;
+		}
+
+	private:
+		auto Parse(const char seperator, const char quote, const cCsvColumnMask& mask) -> bool;
+		auto SplitChunks(size_t begin, const char quote) const -> std::vector<SChunk>;
+		auto ParseChunk(SChunk& chunk, const char seperator, const char quote, const cCsvColumnMask& mask, size_t fullRows, size_t rowLimit = SIZE_MAX) const -> void;
+		auto TranscodeFields(bool bAllColumns) -> void;
+
+		cCsvMappedFile(const cCsvMappedFile&) {}
+
+		auto operator =(const cCsvMappedFile&) const -> const cCsvMappedFile&
+		{
+			return *this;
+		}
+};
+
 class cCsvTable
 {
 	public:
 		cCsvFile  m_File;
+		cCsvMappedFile m_MappedFile;
 	private:
 		cCsvAlias m_Alias;
 		int       m_CurRow;
+		bool      m_bMapped;
 
 	public:
 		cCsvTable();
@@ -123,14 +399,25 @@ class cCsvTable
 
 
 	public:
-		bool Load(const char* fileName, const char seperator = ',', const char quote = '"');
+		bool Load(const char* fileName, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask());
+		bool LoadMapped(const char* fileName, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask());
+		bool LoadBuffer(std::string data, const char seperator = ',', const char quote = '"', const cCsvColumnMask& mask = cCsvColumnMask());
 		auto Destroy() -> void;
 
 		auto Next() -> bool;
+		auto Rewind() -> void
+		{
+			m_CurRow = -1;
+		}
+
+		auto RowCount() const -> size_t;
 		auto ColCount() const -> size_t;
+		auto CurLine() const -> uint32_t;
 		auto AsInt(size_t index) const -> int;
 		auto AsDouble(size_t index) const -> double;
 		auto AsStringByIndex(size_t index) const -> std::string;
+		auto AsStringViewByIndex(size_t index) const -> std::string_view;
+		auto GetEncoding() const -> cTextEncoding::EEncoding;
 
 		auto AsInt(const char* name) const -> int
 		{
@@ -142,9 +429,14 @@ class cCsvTable
 			return AsDouble(m_Alias[name]);
 		}
 
-		auto AsString(const char* name) const -> const char*
+		auto AsString(const char* name) const -> std::string
+		{
+			return AsStringByIndex(m_Alias[name]);
+		}
+
+		auto AsStringView(const char* name) const -> std::string_view
 		{
-			return AsStringByIndex(m_Alias[name]).c_str();
+			return AsStringViewByIndex(m_Alias[name]);
 		}
 
 		auto AddAlias(const char* name, size_t index) -> void
@@ -152,7 +444,25 @@ class cCsvTable
 			m_Alias.AddAlias(name, index);
 		}
 
+		auto GetHeader() const -> std::vector<std::string_view>;
+		auto AddHeaderAliases() -> void;
+
+		/**
+		 * \brief
+		 * Field of the current row by a bound schema column, an int or a string_view as the schema declares it.
+		 * A column the schema couldn't bind reads as 0 or an empty string_view.
+		 */
+		template <auto Column, typename TSchema>
+		auto Get(const cCsvSchema<TSchema>& schema) const
+		{
+			if constexpr (TSchema::COLUMNS[Column].type == CSV_FIELD_INT)
+				return schema.Has(Column) ? AsInt(schema[Column]) : 0;
+			else
+				return schema.Has(Column) ? AsStringViewByIndex(schema[Column]) : std::string_view();
+		}
+
 	private:
+		auto HasCurRow() const -> bool;
 		auto CurRow() const -> const cCsvRow*;
 		cCsvTable(const cCsvTable&)
 		{
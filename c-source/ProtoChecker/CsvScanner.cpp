@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "CsvScanner.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define CSV_SCANNER_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#define CSV_TARGET_AVX2
+		#define CSV_TARGET_AVX512
+	#else
+		#define CSV_TARGET_AVX2 __attribute__((target("avx2")))
+		#define CSV_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+	#endif
+#endif
+
+namespace
+{
+	/**
+	 * \brief
+	 * Write the offset of every set bit of a comparison mask.
+	 */
+	inline auto FlattenMask(uint64_t mask, uint32_t base, uint32_t* index) -> uint32_t*
+	{
+		while (mask)
+		{
+			*index++ = base + count_trailing_zeros(mask);
+			mask &= mask - 1;
+		}
+		return index;
+	}
+
+	auto ScanScalar(const char* data, uint32_t begin, uint32_t size, char seperator, char quote, uint32_t* index) -> uint32_t*
+	{
+		for (auto cur = begin; cur < size; ++cur)
+		{
+			const auto c = data[cur];
+			if (c == seperator || c == quote || c == '\n')
+				*index++ = cur;
+		}
+		return index;
+	}
+
+#ifdef CSV_SCANNER_X86
+	auto ScanSSE2(const char* data, uint32_t size, char seperator, char quote, uint32_t*& index) -> uint32_t
+	{
+		const auto vecSeperator = _mm_set1_epi8(seperator);
+		const auto vecQuote = _mm_set1_epi8(quote);
+		const auto vecNewLine = _mm_set1_epi8('\n');
+
+		uint32_t cur = 0;
+		for (; cur + 16 <= size; cur += 16)
+		{
+			const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + cur));
+			const auto match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, vecSeperator), _mm_cmpeq_epi8(block, vecQuote)), _mm_cmpeq_epi8(block, vecNewLine));
+			index = FlattenMask(static_cast<uint32_t>(_mm_movemask_epi8(match)), cur, index);
+		}
+
+		return cur;
+	}
+
+	CSV_TARGET_AVX2 auto ScanAVX2(const char* data, uint32_t size, char seperator, char quote, uint32_t*& index) -> uint32_t
+	{
+		const auto vecSeperator = _mm256_set1_epi8(seperator);
+		const auto vecQuote = _mm256_set1_epi8(quote);
+		const auto vecNewLine = _mm256_set1_epi8('\n');
+
+		uint32_t cur = 0;
+		for (; cur + 32 <= size; cur += 32)
+		{
+			const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + cur));
+			const auto match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, vecSeperator), _mm256_cmpeq_epi8(block, vecQuote)), _mm256_cmpeq_epi8(block, vecNewLine));
+			index = FlattenMask(static_cast<uint32_t>(_mm256_movemask_epi8(match)), cur, index);
+		}
+
+		return cur;
+	}
+
+	CSV_TARGET_AVX512 auto ScanAVX512(const char* data, uint32_t size, char seperator, char quote, uint32_t*& index) -> uint32_t
+	{
+		const auto vecSeperator = _mm512_set1_epi8(seperator);
+		const auto vecQuote = _mm512_set1_epi8(quote);
+		const auto vecNewLine = _mm512_set1_epi8('\n');
+
+		uint32_t cur = 0;
+		for (; cur + 64 <= size; cur += 64)
+		{
+			const auto block = _mm512_loadu_si512(data + cur);
+			const auto match = _mm512_cmpeq_epi8_mask(block, vecSeperator) | _mm512_cmpeq_epi8_mask(block, vecQuote) | _mm512_cmpeq_epi8_mask(block, vecNewLine);
+			index = FlattenMask(match, cur, index);
+		}
+
+		return cur;
+	}
+#endif
+}
+
+cCsvScanner::cCsvScanner(char seperator, char quote)
+: m_Seperator(seperator), m_Quote(quote), m_Implementation(GetBestImplementation())
+{
+}
+
+cCsvScanner::cCsvScanner(char seperator, char quote, EImplementation implementation)
+: m_Seperator(seperator), m_Quote(quote), m_Implementation(std::min(implementation, GetBestImplementation()))
+{
+}
+
+/**
+ * \brief
+ * Write the offsets of all separators, quotes and line breaks of a block into the structural index.
+ * The index must have room for one entry per byte of the block.
+ * A scanner built with '\n' as separator only indexes quotes and line breaks, which is all a projected load needs.
+ * \param: data: const char*
+ * \param: size: uint32_t
+ * \param: index: uint32_t*
+ * \return: uint32_t, number of structural characters found
+ */
+auto cCsvScanner::Scan(const char* data, uint32_t size, uint32_t* index) const -> uint32_t
+{
+	const auto begin = index;
+	uint32_t cur = 0;
+
+#ifdef CSV_SCANNER_X86
+	switch (m_Implementation)
+	{
+		case IMPL_AVX512:
+			cur = ScanAVX512(data, size, m_Seperator, m_Quote, index);
+			break;
+		case IMPL_AVX2:
+			cur = ScanAVX2(data, size, m_Seperator, m_Quote, index);
+			break;
+		case IMPL_SSE2:
+			cur = ScanSSE2(data, size, m_Seperator, m_Quote, index);
+			break;
+		default:
+			break;
+	}
+#endif
+
+	index = ScanScalar(data, cur, size, m_Seperator, m_Quote, index);
+	return static_cast<uint32_t>(index - begin);
+}
+
+/**
+ * \brief
+ * Detect the widest instruction set supported by both the cpu and the operating system.
+ * \return: EImplementation
+ */
+auto cCsvScanner::GetBestImplementation() -> EImplementation
+{
+	static const auto implementation = []
+	{
+#if defined(CSV_SCANNER_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		const auto maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const auto bSSE2 = (info[3] & (1 << 26)) != 0;
+		const auto bOSXSave = (info[2] & (1 << 27)) != 0;
+		if (!bOSXSave || maxLeaf < 7)
+			return bSSE2 ? IMPL_SSE2 : IMPL_SCALAR;
+
+		const auto xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 16)) && (info[1] & (1 << 30)) && (xcr0 & 0xE6) == 0xE6)
+			return IMPL_AVX512;
+		if ((info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6)
+			return IMPL_AVX2;
+		return bSSE2 ? IMPL_SSE2 : IMPL_SCALAR;
+#elif defined(CSV_SCANNER_X86)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+			return IMPL_AVX512;
+		if (__builtin_cpu_supports("avx2"))
+			return IMPL_AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return IMPL_SSE2;
+		return IMPL_SCALAR;
+#else
+		return IMPL_SCALAR;
+#endif
+	}();
+
+	return implementation;
+}
+
+auto cCsvScanner::GetImplementationName(EImplementation implementation) -> const char*
+{
+	switch (implementation)
+	{
+		case IMPL_AVX512:
+			return "avx512";
+		case IMPL_AVX2:
+			return "avx2";
+		case IMPL_SSE2:
+			return "sse2";
+		default:
+			return "scalar";
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+ * \brief
+ * Structural scanner of the mapped csv loader.
+ * Finds every separator, quote and line break of a block and stores their offsets into a structural index,
+ * the tokenizer then only visits those positions instead of every byte.
+ * The widest instruction set supported by the cpu is picked at runtime, the scalar scanner is kept as fallback.
+ */
+class cCsvScanner
+{
+	public:
+		enum EImplementation
+		{
+			IMPL_SCALAR,
+			IMPL_SSE2,
+			IMPL_AVX2,
+			IMPL_AVX512,
+		};
+
+	private:
+		char m_Seperator;
+		char m_Quote;
+		EImplementation m_Implementation;
+
+	public:
+		cCsvScanner(char seperator, char quote);
+		cCsvScanner(char seperator, char quote, EImplementation implementation);
+
+	public:
+		auto Scan(const char* data, uint32_t size, uint32_t* index) const -> uint32_t;
+
+		auto GetImplementation() const -> EImplementation
+		{
+			return m_Implementation;
+		}
+
+		static auto GetBestImplementation() -> EImplementation;
+		static auto GetImplementationName(EImplementation implementation) -> const char*;
+};
@@ -0,0 +1,240 @@
+#pragma once
+#include "CsvReader.h"
+#include <array>
+
+/**
+ * \brief
+ * FNV-1a hash of a header name with ASCII letters folded to lower case, the same name matching as cCsvAlias.
+ * \param name: string_view
+ * \return: uint64_t
+ */
+constexpr auto hash_column_name(std::string_view name) -> uint64_t
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (const auto c : name)
+	{
+		hash ^= static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+constexpr auto is_same_column_name(std::string_view left, std::string_view right) -> bool
+{
+	if (left.size() != right.size())
+		return false;
+
+	for (size_t i = 0; i < left.size(); ++i)
+	{
+		const auto a = left[i] >= 'A' && left[i] <= 'Z' ? left[i] - 'A' + 'a' : left[i];
+		const auto b = right[i] >= 'A' && right[i] <= 'Z' ? right[i] - 'A' + 'a' : right[i];
+		if (a != b)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * \brief
+ * Known layout of item_proto.txt, the columns in the order of the file.
+ */
+struct SItemProtoSchema
+{
+	enum EColumn : size_t
+	{
+		VNUM, NAME, TYPE, SUB_TYPE, SIZE, ANTI_FLAG, FLAG, WEAR, IMMUNE, GOLD, SHOP_BUY_PRICE, REFINE, REFINESET, MAGIC_PCT,
+		LIMIT_TYPE0, LIMIT_VALUE0, LIMIT_TYPE1, LIMIT_VALUE1,
+		ADDON_TYPE0, ADDON_VALUE0, ADDON_TYPE1, ADDON_VALUE1, ADDON_TYPE2, ADDON_VALUE2,
+		VALUE0, VALUE1, VALUE2, VALUE3, VALUE4, VALUE5, SPECULAR, SOCKET, ATTU_ADDON,
+		COLUMN_COUNT,
+	};
+
+	static constexpr std::array<SCsvSchemaColumn, COLUMN_COUNT> COLUMNS =
+	{{
+		{"ITEM_VNUM~RANGE", CSV_FIELD_STRING}, {"ITEM_NAME(K)", CSV_FIELD_STRING}, {"ITEM_TYPE", CSV_FIELD_STRING},
+		{"SUB_TYPE", CSV_FIELD_STRING}, {"SIZE", CSV_FIELD_INT}, {"ANTI_FLAG", CSV_FIELD_STRING}, {"FLAG", CSV_FIELD_STRING},
+		{"ITEM_WEAR", CSV_FIELD_STRING}, {"IMMUNE", CSV_FIELD_STRING}, {"GOLD", CSV_FIELD_INT}, {"SHOP_BUY_PRICE", CSV_FIELD_INT},
+		{"REFINE", CSV_FIELD_INT}, {"REFINESET", CSV_FIELD_INT}, {"MAGIC_PCT", CSV_FIELD_INT},
+		{"LIMIT_TYPE0", CSV_FIELD_STRING}, {"LIMIT_VALUE0", CSV_FIELD_INT}, {"LIMIT_TYPE1", CSV_FIELD_STRING}, {"LIMIT_VALUE1", CSV_FIELD_INT},
+		{"ADDON_TYPE0", CSV_FIELD_STRING}, {"ADDON_VALUE0", CSV_FIELD_INT}, {"ADDON_TYPE1", CSV_FIELD_STRING}, {"ADDON_VALUE1", CSV_FIELD_INT},
+		{"ADDON_TYPE2", CSV_FIELD_STRING}, {"ADDON_VALUE2", CSV_FIELD_INT},
+		{"VALUE0", CSV_FIELD_INT}, {"VALUE1", CSV_FIELD_INT}, {"VALUE2", CSV_FIELD_INT}, {"VALUE3", CSV_FIELD_INT},
+		{"VALUE4", CSV_FIELD_INT}, {"VALUE5", CSV_FIELD_INT}, {"Specular", CSV_FIELD_INT}, {"SOCKET", CSV_FIELD_INT},
+		{"ATTU_ADDON", CSV_FIELD_INT},
+	}};
+};
+
+/**
+ * \brief
+ * Known layout of mob_proto.txt, the columns in the order of the file.
+ */
+struct SMobProtoSchema
+{
+	enum EColumn : size_t
+	{
+		VNUM, NAME, RANK, TYPE, BATTLE_TYPE, LEVEL, SIZE, AI_FLAG, MOUNT_CAPACITY, RACE_FLAG, IMMUNE_FLAG, EMPIRE, FOLDER, ON_CLICK,
+		ST, DX, HT, IQ, DAMAGE_MIN, DAMAGE_MAX, MAX_HP, REGEN_CYCLE, REGEN_PERCENT, GOLD_MIN, GOLD_MAX, EXP, DEF, ATTACK_SPEED, MOVE_SPEED,
+		AGGRESSIVE_HP_PCT, AGGRESSIVE_SIGHT, ATTACK_RANGE, DROP_ITEM, RESURRECTION_VNUM,
+		ENCHANT_CURSE, ENCHANT_SLOW, ENCHANT_POISON, ENCHANT_STUN, ENCHANT_CRITICAL, ENCHANT_PENETRATE,
+		RESIST_SWORD, RESIST_TWOHAND, RESIST_DAGGER, RESIST_BELL, RESIST_FAN, RESIST_BOW, RESIST_FIRE, RESIST_ELECT, RESIST_MAGIC,
+		RESIST_WIND, RESIST_POISON, DAM_MULTIPLY, SUMMON, DRAIN_SP, MOB_COLOR, POLYMORPH_ITEM,
+		SKILL_LEVEL0, SKILL_VNUM0, SKILL_LEVEL1, SKILL_VNUM1, SKILL_LEVEL2, SKILL_VNUM2, SKILL_LEVEL3, SKILL_VNUM3, SKILL_LEVEL4, SKILL_VNUM4,
+		SP_BERSERK, SP_STONESKIN, SP_GODSPEED, SP_DEATHBLOW, SP_REVIVE,
+		COLUMN_COUNT,
+	};
+
+	static constexpr std::array<SCsvSchemaColumn, COLUMN_COUNT> COLUMNS =
+	{{
+		{"VNUM", CSV_FIELD_INT}, {"NAME", CSV_FIELD_STRING}, {"RANK", CSV_FIELD_STRING}, {"TYPE", CSV_FIELD_STRING},
+		{"BATTLE_TYPE", CSV_FIELD_STRING}, {"LEVEL", CSV_FIELD_INT}, {"SIZE", CSV_FIELD_STRING}, {"AI_FLAG", CSV_FIELD_STRING},
+		{"MOUNT_CAPACITY", CSV_FIELD_INT}, {"RACE_FLAG", CSV_FIELD_STRING}, {"IMMUNE_FLAG", CSV_FIELD_STRING}, {"EMPIRE", CSV_FIELD_INT},
+		{"FOLDER", CSV_FIELD_STRING}, {"ON_CLICK", CSV_FIELD_INT},
+		{"ST", CSV_FIELD_INT}, {"DX", CSV_FIELD_INT}, {"HT", CSV_FIELD_INT}, {"IQ", CSV_FIELD_INT},
+		{"DAMAGE_MIN", CSV_FIELD_INT}, {"DAMAGE_MAX", CSV_FIELD_INT}, {"MAX_HP", CSV_FIELD_INT}, {"REGEN_CYCLE", CSV_FIELD_INT},
+		{"REGEN_PERCENT", CSV_FIELD_INT}, {"GOLD_MIN", CSV_FIELD_INT}, {"GOLD_MAX", CSV_FIELD_INT}, {"EXP", CSV_FIELD_INT},
+		{"DEF", CSV_FIELD_INT}, {"ATTACK_SPEED", CSV_FIELD_INT}, {"MOVE_SPEED", CSV_FIELD_INT},
+		{"AGGRESSIVE_HP_PCT", CSV_FIELD_INT}, {"AGGRESSIVE_SIGHT", CSV_FIELD_INT}, {"ATTACK_RANGE", CSV_FIELD_INT},
+		{"DROP_ITEM", CSV_FIELD_INT}, {"RESURRECTION_VNUM", CSV_FIELD_INT},
+		{"ENCHANT_CURSE", CSV_FIELD_INT}, {"ENCHANT_SLOW", CSV_FIELD_INT}, {"ENCHANT_POISON", CSV_FIELD_INT},
+		{"ENCHANT_STUN", CSV_FIELD_INT}, {"ENCHANT_CRITICAL", CSV_FIELD_INT}, {"ENCHANT_PENETRATE", CSV_FIELD_INT},
+		{"RESIST_SWORD", CSV_FIELD_INT}, {"RESIST_TWOHAND", CSV_FIELD_INT}, {"RESIST_DAGGER", CSV_FIELD_INT},
+		{"RESIST_BELL", CSV_FIELD_INT}, {"RESIST_FAN", CSV_FIELD_INT}, {"RESIST_BOW", CSV_FIELD_INT}, {"RESIST_FIRE", CSV_FIELD_INT},
+		{"RESIST_ELECT", CSV_FIELD_INT}, {"RESIST_MAGIC", CSV_FIELD_INT}, {"RESIST_WIND", CSV_FIELD_INT}, {"RESIST_POISON", CSV_FIELD_INT},
+		{"DAM_MULTIPLY", CSV_FIELD_STRING}, {"SUMMON", CSV_FIELD_INT}, {"DRAIN_SP", CSV_FIELD_INT}, {"MOB_COLOR", CSV_FIELD_INT},
+		{"POLYMORPH_ITEM", CSV_FIELD_INT},
+		{"SKILL_LEVEL0", CSV_FIELD_INT}, {"SKILL_VNUM0", CSV_FIELD_INT}, {"SKILL_LEVEL1", CSV_FIELD_INT}, {"SKILL_VNUM1", CSV_FIELD_INT},
+		{"SKILL_LEVEL2", CSV_FIELD_INT}, {"SKILL_VNUM2", CSV_FIELD_INT}, {"SKILL_LEVEL3", CSV_FIELD_INT}, {"SKILL_VNUM3", CSV_FIELD_INT},
+		{"SKILL_LEVEL4", CSV_FIELD_INT}, {"SKILL_VNUM4", CSV_FIELD_INT},
+		{"SP_BERSERK", CSV_FIELD_INT}, {"SP_STONESKIN", CSV_FIELD_INT}, {"SP_GODSPEED", CSV_FIELD_INT}, {"SP_DEATHBLOW", CSV_FIELD_INT},
+		{"SP_REVIVE", CSV_FIELD_INT},
+	}};
+};
+
+template <typename TSchema>
+constexpr auto make_column_hashes() -> std::array<uint64_t, TSchema::COLUMN_COUNT>
+{
+	std::array<uint64_t, TSchema::COLUMN_COUNT> hashes {};
+	for (size_t col = 0; col < TSchema::COLUMN_COUNT; ++col)
+		hashes[col] = hash_column_name(TSchema::COLUMNS[col].name);
+	return hashes;
+}
+
+/**
+ * \brief
+ * Every column of a schema has a name and no two names match.
+ */
+template <typename TSchema>
+constexpr auto is_valid_schema() -> bool
+{
+	for (size_t col = 0; col < TSchema::COLUMN_COUNT; ++col)
+	{
+		if (TSchema::COLUMNS[col].name.empty())
+			return false;
+
+		for (size_t other = 0; other < col; ++other)
+		{
+			if (is_same_column_name(TSchema::COLUMNS[col].name, TSchema::COLUMNS[other].name))
+				return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * \brief
+ * A schema bound to the header of a loaded file: the index of every schema column in that file.
+ * The header hashes of the schema are computed at compile time. A header in the known layout is recognised with one
+ * hash per field and binds every column to its own position; any other layout (reordered, extra or missing columns)
+ * falls back to the runtime alias map of the header. Once bound, a named field is a plain indexed load.
+ */
+template <typename TSchema>
+class cCsvSchema
+{
+	public:
+		using EColumn = typename TSchema::EColumn;
+
+		static constexpr size_t COLUMN_COUNT = TSchema::COLUMN_COUNT;
+		static constexpr size_t NO_COLUMN = SIZE_MAX;
+
+	private:
+		static constexpr std::array<uint64_t, COLUMN_COUNT> HASHES = make_column_hashes<TSchema>();
+		static_assert(is_valid_schema<TSchema>(), "every schema column needs a distinct name");
+
+		std::array<size_t, COLUMN_COUNT> m_Index;
+		bool m_bExact;
+
+	public:
+		cCsvSchema() : m_bExact(false)
+		{
+			m_Index.fill(NO_COLUMN);
+		}
+
+		virtual ~cCsvSchema() = default;
+
+	public:
+		/**
+		 * \brief
+		 * Bind the schema to a header row.
+		 * \param: vecHeader: vector, the header fields
+		 * \return: bool, false if a schema column isn't in the header (it isn't bound, see Has)
+		 */
+		auto Bind(const std::vector<std::string_view>& vecHeader) -> bool
+		{
+			m_Index.fill(NO_COLUMN);
+
+			m_bExact = vecHeader.size() >= COLUMN_COUNT;
+			for (size_t col = 0; col < COLUMN_COUNT && m_bExact; ++col)
+				m_bExact = hash_column_name(vecHeader[col]) == HASHES[col] && is_same_column_name(vecHeader[col], TSchema::COLUMNS[col].name);
+
+			if (m_bExact)
+			{
+				for (size_t col = 0; col < COLUMN_COUNT; ++col)
+					m_Index[col] = col;
+				return true;
+			}
+
+			cCsvAlias alias;
+			for (size_t col = 0; col < vecHeader.size(); ++col)
+			{
+				size_t index;
+				if (!alias.Find(vecHeader[col], index))
+					alias.AddAlias(vecHeader[col], col);
+			}
+
+			auto bComplete = true;
+			for (size_t col = 0; col < COLUMN_COUNT; ++col)
+			{
+				size_t index;
+				if (alias.Find(TSchema::COLUMNS[col].name, index))
+					m_Index[col] = index;
+				else
+					bComplete = false;
+			}
+
+			return bComplete;
+		}
+
+		auto Bind(const cCsvTable& table) -> bool
+		{
+			return Bind(table.GetHeader());
+		}
+
+		auto operator [](EColumn column) const -> size_t
+		{
+			return m_Index[column];
+		}
+
+		auto Has(EColumn column) const -> bool
+		{
+			return m_Index[column] != NO_COLUMN;
+		}
+
+		/**
+		 * \brief
+		 * Whether the header had the known layout, every column at its own position.
+		 */
+		auto IsExact() const -> bool
+		{
+			return m_bExact;
+		}
+};
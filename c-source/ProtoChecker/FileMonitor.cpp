@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "FileMonitor.h"
+#include <thread>
+#include <chrono>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+cFileMonitor::cFileMonitor()
+{
+#if defined(__linux__)
+	m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#elif !defined(_WIN32)
+	m_Notify = -1;
+#endif
+}
+
+cFileMonitor::~cFileMonitor()
+{
+#ifdef _WIN32
+	for (const auto handle : m_vecNotify)
+		FindCloseChangeNotification(handle);
+#else
+	if (m_Notify >= 0)
+		close(m_Notify);
+#endif
+}
+
+/**
+ * \brief
+ * Start watching a file, its directory is watched once for all the files it contains.
+ * \param: path: string
+ * \return: size_t, the index reported by Wait() when the file changes
+ */
+auto cFileMonitor::Add(const std::string& path) -> size_t
+{
+	m_vecEntry.push_back({ path, TakeSnapshot(path) });
+
+	auto directory = std::filesystem::path(path).parent_path().string();
+	if (directory.empty())
+		directory = ".";
+
+	if (std::find(m_vecDirectory.begin(), m_vecDirectory.end(), directory) == m_vecDirectory.end())
+	{
+		m_vecDirectory.push_back(directory);
+#ifdef _WIN32
+		const auto handle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+		if (handle != INVALID_HANDLE_VALUE)
+			m_vecNotify.push_back(handle);
+#elif defined(__linux__)
+		if (m_Notify >= 0)
+			inotify_add_watch(m_Notify, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+#endif
+	}
+
+	return m_vecEntry.size() - 1;
+}
+
+/**
+ * \brief
+ * Block until at least one of the files changed.
+ * Editors save in several steps, so a burst of events is let to settle before the files are compared.
+ * \return: vector, indices of the changed files
+ */
+auto cFileMonitor::Wait() -> std::vector<size_t>
+{
+	for (;;)
+	{
+		if (WaitForEvent(POLL_INTERVAL_MS))
+		{
+			while (WaitForEvent(SETTLE_INTERVAL_MS))
+				;
+		}
+
+		std::vector<size_t> vecChanged;
+		for (size_t i = 0; i < m_vecEntry.size(); ++i)
+		{
+			auto & entry = m_vecEntry[i];
+			const auto & snapshot = TakeSnapshot(entry.path);
+			if (snapshot == entry.snapshot)
+				continue;
+
+			entry.snapshot = snapshot;
+			vecChanged.push_back(i);
+		}
+
+		if (!vecChanged.empty())
+			return vecChanged;
+	}
+}
+
+/**
+ * \brief
+ * Wait for a change notification of any watched directory.
+ * \param: timeout: uint32_t, milliseconds
+ * \return: bool, false on timeout or when notifications aren't available
+ */
+auto cFileMonitor::WaitForEvent(uint32_t timeout) -> bool
+{
+#ifdef _WIN32
+	if (!m_vecNotify.empty())
+	{
+		const auto result = WaitForMultipleObjects(static_cast<DWORD>(m_vecNotify.size()), m_vecNotify.data(), FALSE, timeout);
+		if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + m_vecNotify.size())
+		{
+			FindNextChangeNotification(m_vecNotify[result - WAIT_OBJECT_0]);
+			return true;
+		}
+
+		return false;
+	}
+#elif defined(__linux__)
+	if (m_Notify >= 0)
+	{
+		pollfd descriptor = { m_Notify, POLLIN, 0 };
+		if (poll(&descriptor, 1, static_cast<int>(timeout)) <= 0)
+			return false;
+
+		alignas(inotify_event) char buffer[4096];
+		while (read(m_Notify, buffer, sizeof(buffer)) > 0)
+			;
+
+		return true;
+	}
+#endif
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+	return false;
+}
+
+auto cFileMonitor::TakeSnapshot(const std::string& path) -> SSnapshot
+{
+	SSnapshot snapshot;
+	std::error_code error;
+
+	const auto size = std::filesystem::file_size(path, error);
+	if (error)
+		return snapshot;
+
+	snapshot.writeTime = std::filesystem::last_write_time(path, error);
+	snapshot.exists = !error;
+	snapshot.size = size;
+	return snapshot;
+}
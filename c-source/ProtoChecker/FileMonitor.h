@@ -0,0 +1,61 @@
+#pragma once
+#include <filesystem>
+
+/**
+ * \brief
+ * Watches a set of files and reports which of them changed.
+ * The directories of the files are watched through inotify (linux) or change notifications (windows),
+ * a change is then confirmed by comparing the size and write time of every file.
+ * Without notifications the files are simply polled, so a missing directory or platform support only costs latency.
+ */
+class cFileMonitor
+{
+	private:
+		static constexpr uint32_t POLL_INTERVAL_MS = 500;
+		static constexpr uint32_t SETTLE_INTERVAL_MS = 10;
+
+		struct SSnapshot
+		{
+			bool exists = false;
+			uintmax_t size = 0;
+			std::filesystem::file_time_type writeTime;
+
+			auto operator ==(const SSnapshot& other) const -> bool
+			{
+				return exists == other.exists && size == other.size && writeTime == other.writeTime;
+			}
+		};
+
+		struct SEntry
+		{
+			std::string path;
+			SSnapshot snapshot;
+		};
+
+		std::vector<SEntry> m_vecEntry;
+		std::vector<std::string> m_vecDirectory;
+#ifdef _WIN32
+		std::vector<void*> m_vecNotify;
+#else
+		int m_Notify;
+#endif
+
+	public:
+		cFileMonitor();
+		virtual ~cFileMonitor();
+
+	public:
+		auto Add(const std::string& path) -> size_t;
+		auto Wait() -> std::vector<size_t>;
+
+	private:
+		auto WaitForEvent(uint32_t timeout) -> bool;
+		static auto TakeSnapshot(const std::string& path) -> SSnapshot;
+
+		cFileMonitor(const cFileMonitor&) {}
+
+		auto operator =(const cFileMonitor&) const -> const cFileMonitor&
+		{
+			return *this;
+		}
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstring>
+
+/**
+ * \brief
+ * 64 bit rotate left.
+ * \param value: uint64_t
+ * \param count: uint32_t, 1..63
+ * \return: uint64_t
+ */
+inline auto rotate_left(const uint64_t value, const uint32_t count) -> uint64_t
+{
+	return (value << count) | (value >> (64 - count));
+}
+
+namespace xxh64_detail
+{
+	static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+	static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+	static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+	static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+	static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+	inline auto read64(const unsigned char* data) -> uint64_t
+	{
+		uint64_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline auto read32(const unsigned char* data) -> uint32_t
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline auto round(uint64_t accumulator, const uint64_t input) -> uint64_t
+	{
+		accumulator += input * PRIME2;
+		accumulator = rotate_left(accumulator, 31);
+		return accumulator * PRIME1;
+	}
+
+	inline auto merge_round(uint64_t accumulator, const uint64_t value) -> uint64_t
+	{
+		accumulator ^= round(0, value);
+		return accumulator * PRIME1 + PRIME4;
+	}
+}
+
+/**
+ * \brief
+ * XXH64 of a buffer, the reference algorithm for little endian hosts.
+ * Used to fingerprint file contents and binary payloads, it's not a cryptographic hash.
+ * \param data: const void*
+ * \param size: size_t
+ * \param seed: uint64_t
+ * \return: uint64_t
+ */
+inline auto hash_xxh64(const void* data, const size_t size, const uint64_t seed = 0) -> uint64_t
+{
+	using namespace xxh64_detail;
+
+	auto p = static_cast<const unsigned char*>(data);
+	const auto end = p + size;
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		auto v1 = seed + PRIME1 + PRIME2;
+		auto v2 = seed + PRIME2;
+		auto v3 = seed;
+		auto v4 = seed - PRIME1;
+
+		const auto limit = end - 32;
+		do
+		{
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+		hash = merge_round(hash, v1);
+		hash = merge_round(hash, v2);
+		hash = merge_round(hash, v3);
+		hash = merge_round(hash, v4);
+	}
+	else
+	{
+		hash = seed + PRIME5;
+	}
+
+	hash += static_cast<uint64_t>(size);
+
+	for (; p + 8 <= end; p += 8)
+	{
+		hash ^= round(0, read64(p));
+		hash = rotate_left(hash, 27) * PRIME1 + PRIME4;
+	}
+
+	if (p + 4 <= end)
+	{
+		hash ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+		hash = rotate_left(hash, 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+
+	for (; p < end; ++p)
+	{
+		hash ^= (*p) * PRIME5;
+		hash = rotate_left(hash, 11) * PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
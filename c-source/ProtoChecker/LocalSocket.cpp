@@ -0,0 +1,308 @@
+#include "pch.h"
+#include "LocalSocket.h"
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <winsock2.h>
+	#include <afunix.h>
+	#ifdef _MSC_VER
+		#pragma comment(lib, "ws2_32.lib")
+	#endif
+#else
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	static constexpr intptr_t INVALID_LOCAL_SOCKET = -1;
+
+#ifdef _WIN32
+	using TSocket = SOCKET;
+#else
+	using TSocket = int;
+
+	#ifdef MSG_NOSIGNAL
+		static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+	#else
+		static constexpr int SEND_FLAGS = 0;
+	#endif
+#endif
+
+	auto CloseSocket(intptr_t socket) -> void
+	{
+#ifdef _WIN32
+		closesocket(static_cast<TSocket>(socket));
+#else
+		close(static_cast<TSocket>(socket));
+#endif
+	}
+
+	auto RemoveSocketFile(const std::string& path) -> void
+	{
+#ifdef _WIN32
+		DeleteFileA(path.c_str());
+#else
+		unlink(path.c_str());
+#endif
+	}
+
+	/**
+	 * \brief
+	 * Remove the socket file a server which is gone left at the address.
+	 * \param: address: sockaddr_un
+	 * \return: bool, false if the path is something else than a socket or a server still accepts on it
+	 */
+	auto RemoveStaleSocket(const sockaddr_un& address) -> bool
+	{
+#ifdef _WIN32
+		// A Unix domain socket file is a reparse point on Windows.
+		const auto attributes = GetFileAttributesA(address.sun_path);
+		if (attributes == INVALID_FILE_ATTRIBUTES)
+			return true;
+
+		if (!(attributes & FILE_ATTRIBUTE_REPARSE_POINT))
+			return false;
+#else
+		struct stat status;
+		if (lstat(address.sun_path, &status) != 0)
+			return errno == ENOENT;
+
+		if (!S_ISSOCK(status.st_mode))
+			return false;
+#endif
+
+		const auto socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+#ifdef _WIN32
+		if (socket == INVALID_SOCKET)
+			return false;
+#else
+		if (socket < 0)
+			return false;
+#endif
+
+		const auto bLive = connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+		CloseSocket(static_cast<intptr_t>(socket));
+		if (bLive)
+			return false;
+
+		RemoveSocketFile(address.sun_path);
+		return true;
+	}
+}
+
+/**
+ * \brief
+ * Read the next line, without its line break ("\n" or "\r\n").
+ * \param: line: string
+ * \param: limit: size_t, longest accepted line
+ * \return: bool, false when the connection is closed first or the line is longer than the limit
+ */
+auto cLocalSocket::ReadLine(std::string& line, size_t limit) -> bool
+{
+	line.clear();
+	for (;;)
+	{
+		const auto end = m_Buffer.find('\n', m_BufferPos);
+		const auto available = (end == std::string::npos ? m_Buffer.size() : end) - m_BufferPos;
+		if (line.size() + available > limit)
+			return false;
+
+		line.append(m_Buffer, m_BufferPos, available);
+		if (end != std::string::npos)
+		{
+			m_BufferPos = end + 1;
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			return true;
+		}
+
+		m_BufferPos = m_Buffer.size();
+		if (!Fill())
+			return false;
+	}
+}
+
+/**
+ * \brief
+ * Read exactly size bytes.
+ * \param: data: string
+ * \param: size: size_t
+ * \return: bool, false when the connection is closed first
+ */
+auto cLocalSocket::Read(std::string& data, size_t size) -> bool
+{
+	data.clear();
+	data.reserve(size);
+	while (data.size() < size)
+	{
+		if (m_BufferPos == m_Buffer.size() && !Fill())
+			return false;
+
+		const auto count = std::min(size - data.size(), m_Buffer.size() - m_BufferPos);
+		data.append(m_Buffer, m_BufferPos, count);
+		m_BufferPos += count;
+	}
+	return true;
+}
+
+/**
+ * \brief
+ * Write every byte of data, a peer which went away fails the write instead of raising SIGPIPE.
+ * \param: data: string_view
+ * \return: bool
+ */
+auto cLocalSocket::Write(std::string_view data) -> bool
+{
+	while (!data.empty())
+	{
+#ifdef _WIN32
+		const auto iSent = send(static_cast<TSocket>(m_Socket), data.data(), static_cast<int>(std::min<size_t>(data.size(), INT32_MAX)), 0);
+#else
+		const auto iSent = send(static_cast<TSocket>(m_Socket), data.data(), data.size(), SEND_FLAGS);
+#endif
+		if (iSent <= 0)
+			return false;
+
+		data.remove_prefix(static_cast<size_t>(iSent));
+	}
+	return true;
+}
+
+auto cLocalSocket::Close() -> void
+{
+	if (m_Socket == INVALID_LOCAL_SOCKET)
+		return;
+
+	CloseSocket(m_Socket);
+	m_Socket = INVALID_LOCAL_SOCKET;
+}
+
+/**
+ * \brief
+ * Replace the consumed buffer with the next bytes received.
+ * \return: bool, false when the connection is closed
+ */
+auto cLocalSocket::Fill() -> bool
+{
+	m_Buffer.resize(READ_BUFFER_SIZE);
+	m_BufferPos = 0;
+
+	const auto iReceived = recv(static_cast<TSocket>(m_Socket), &m_Buffer[0], static_cast<int>(m_Buffer.size()), 0);
+	m_Buffer.resize(iReceived > 0 ? static_cast<size_t>(iReceived) : 0);
+	return iReceived > 0;
+}
+
+cLocalServer::cLocalServer() : m_Socket(INVALID_LOCAL_SOCKET), m_LastError(0)
+{
+}
+
+cLocalServer::~cLocalServer()
+{
+	Close();
+}
+
+/**
+ * \brief
+ * Bind the socket file and start listening, a socket file left behind by a previous server is replaced.
+ * \param: path: string
+ * \return: bool, false if the path holds another file or a server which still accepts clients
+ */
+auto cLocalServer::Listen(const std::string& path) -> bool
+{
+	Close();
+
+#ifdef _WIN32
+	static const auto bStarted = []
+	{
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+
+	if (!bStarted)
+		return false;
+#endif
+
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path))
+		return false;
+
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	if (!RemoveStaleSocket(address))
+		return false;
+
+	const auto socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+#ifdef _WIN32
+	if (socket == INVALID_SOCKET)
+		return false;
+#else
+	if (socket < 0)
+		return false;
+#endif
+
+	m_Socket = static_cast<intptr_t>(socket);
+	if (bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(socket, SOMAXCONN) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_stPath = path;
+	return true;
+}
+
+/**
+ * \brief
+ * Wait for the next client.
+ * \return: cLocalSocket, nullptr if the server is closed or accepting failed (see GetError)
+ */
+auto cLocalServer::Accept() -> std::unique_ptr<cLocalSocket>
+{
+	if (m_Socket == INVALID_LOCAL_SOCKET)
+		return nullptr;
+
+	const auto socket = accept(static_cast<TSocket>(m_Socket), nullptr, nullptr);
+#ifdef _WIN32
+	if (socket == INVALID_SOCKET)
+	{
+		m_LastError = WSAGetLastError();
+		return nullptr;
+	}
+#else
+	if (socket < 0)
+	{
+		m_LastError = errno;
+		return nullptr;
+	}
+#endif
+
+	return std::make_unique<cLocalSocket>(static_cast<intptr_t>(socket));
+}
+
+auto cLocalServer::Close() -> void
+{
+	if (m_Socket == INVALID_LOCAL_SOCKET)
+		return;
+
+	CloseSocket(m_Socket);
+	m_Socket = INVALID_LOCAL_SOCKET;
+
+	if (!m_stPath.empty())
+		RemoveSocketFile(m_stPath);
+	m_stPath.clear();
+}
+
+auto cLocalServer::IsOpen() const -> bool
+{
+	return m_Socket != INVALID_LOCAL_SOCKET;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <memory>
+
+/**
+ * \brief
+ * Stream connection over a Unix domain socket (AF_UNIX, on windows from windows 10 1803 on).
+ * Reads are buffered, so a request line and the raw bytes which follow it can be read one after the other.
+ */
+class cLocalSocket
+{
+	private:
+		static constexpr size_t READ_BUFFER_SIZE = 1 << 16;
+
+		intptr_t m_Socket;
+		std::string m_Buffer;
+		size_t m_BufferPos = 0;
+
+	public:
+		explicit cLocalSocket(intptr_t socket) : m_Socket(socket) {}
+		virtual ~cLocalSocket() { Close(); }
+
+	public:
+		auto ReadLine(std::string& line, size_t limit) -> bool;
+		auto Read(std::string& data, size_t size) -> bool;
+		auto Write(std::string_view data) -> bool;
+		auto Close() -> void;
+
+	private:
+		auto Fill() -> bool;
+
+		cLocalSocket(const cLocalSocket&) {}
+
+		auto operator =(const cLocalSocket&) const -> const cLocalSocket&
+		{
+			return *this;
+		}
+};
+
+/**
+ * \brief
+ * Listening Unix domain socket, the socket file is removed when the server is closed.
+ * Only a socket file left behind by a server which is gone is replaced when binding, any other file is kept.
+ */
+class cLocalServer
+{
+	private:
+		intptr_t m_Socket;
+		std::string m_stPath;
+		int m_LastError;
+
+	public:
+		cLocalServer();
+		virtual ~cLocalServer();
+
+	public:
+		auto Listen(const std::string& path) -> bool;
+		auto Accept() -> std::unique_ptr<cLocalSocket>;
+		auto Close() -> void;
+		auto IsOpen() const -> bool;
+
+		/**
+		 * \brief
+		 * Error code of the last failed Accept, an errno value (a winsock one on windows).
+		 */
+		auto GetError() const -> int
+		{
+			return m_LastError;
+		}
+
+	private:
+		cLocalServer(const cLocalServer&) {}
+
+		auto operator =(const cLocalServer&) const -> const cLocalServer&
+		{
+			return *this;
+		}
+};
@@ -0,0 +1,253 @@
+#include "pch.h"
+#include "LogSink.h"
+#include "Profiler.h"
+
+#ifdef _WIN32
+	#include <io.h>
+	#define isatty _isatty
+	#define fileno _fileno
+#else
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	/**
+	 * \brief
+	 * Console color of every level, plain records are printed as they are.
+	 */
+	const char* const LEVEL_COLOR[] = { "", "\033[37m", "\033[92m", "\033[91m" };
+	const char* const COLOR_RESET = "\033[00m";
+
+	const char* const LEVEL_NAME[] = { "plain", "info", "ok", "error" };
+
+	auto AppendJsonString(std::string& output, const std::string& text) -> void
+	{
+		output += '"';
+		for (const auto c : text)
+		{
+			switch (c)
+			{
+				case '"':
+					output += "\\\"";
+					break;
+				case '\\':
+					output += "\\\\";
+					break;
+				case '\n':
+					output += "\\n";
+					break;
+				case '\r':
+					output += "\\r";
+					break;
+				case '\t':
+					output += "\\t";
+					break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+						output += format("\\u%04x", c);
+					else
+						output += c;
+					break;
+			}
+		}
+		output += '"';
+	}
+}
+
+cConsoleLogWriter::cConsoleLogWriter()
+: m_bColor(isatty(fileno(stdout)) != 0)
+{
+}
+
+auto cConsoleLogWriter::Write(const SLogRecord& record) -> void
+{
+	const auto bColor = m_bColor && record.level != LOG_PLAIN;
+	if (bColor)
+		m_Buffer += LEVEL_COLOR[record.level];
+
+	m_Buffer += record.text;
+
+	if (bColor)
+		m_Buffer += COLOR_RESET;
+
+	m_Buffer += '\n';
+}
+
+auto cConsoleLogWriter::Flush() -> void
+{
+	fwrite(m_Buffer.data(), 1, m_Buffer.size(), stdout);
+	fflush(stdout);
+	m_Buffer.clear();
+}
+
+auto cTextLogWriter::Write(const SLogRecord& record) -> void
+{
+	m_File << record.text << '\n';
+}
+
+auto cJsonLogWriter::Write(const SLogRecord& record) -> void
+{
+	m_File << Format(record);
+}
+
+/**
+ * \brief
+ * One record as a JSON object on its own line, the daemon answers with the same objects.
+ * \param: record: SLogRecord
+ * \return: string
+ */
+auto cJsonLogWriter::Format(const SLogRecord& record) -> std::string
+{
+	std::string stLine("{\"level\":\"");
+	stLine += LEVEL_NAME[record.level];
+	stLine += "\",\"id\":";
+	AppendJsonString(stLine, record.id);
+	stLine += ",\"message\":";
+	AppendJsonString(stLine, record.text);
+
+	if (!record.file.empty())
+	{
+		stLine += ",\"file\":";
+		AppendJsonString(stLine, record.file);
+		stLine += format(",\"line\":%u", record.line);
+	}
+
+	stLine += "}\n";
+	return stLine;
+}
+
+cSarifLogWriter::cSarifLogWriter(const std::string& fileName)
+: cFileLogWriter(fileName), m_bFirstResult(true)
+{
+	m_File << "{\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",\"version\":\"2.1.0\","
+		"\"runs\":[{\"tool\":{\"driver\":{\"name\":\"ProtoChecker\",\"version\":\"0.0.1\"}},\"results\":[\n";
+}
+
+cSarifLogWriter::~cSarifLogWriter()
+{
+	m_File << "\n]}]}\n";
+}
+
+/**
+ * \brief
+ * Only findings (records with a file) are results, the console chatter is left out of the report.
+ * \param: record: SLogRecord
+ */
+auto cSarifLogWriter::Write(const SLogRecord& record) -> void
+{
+	if (record.file.empty())
+		return;
+
+	std::string stResult(m_bFirstResult ? "" : ",\n");
+	stResult += "{\"ruleId\":";
+	AppendJsonString(stResult, record.id);
+	stResult += record.level == LOG_ERROR ? ",\"level\":\"error\"" : ",\"level\":\"note\"";
+	stResult += ",\"message\":{\"text\":";
+
+	// The console text is indented with tabs, a report reads better without them.
+	AppendJsonString(stResult, record.text.substr(std::min(record.text.find_first_not_of('\t'), record.text.size())));
+	stResult += "},\"locations\":[{\"physicalLocation\":{\"artifactLocation\":{\"uri\":";
+	AppendJsonString(stResult, record.file);
+	stResult += "}";
+
+	if (record.line)
+		stResult += format(",\"region\":{\"startLine\":%u}", record.line);
+
+	stResult += "}}]}";
+	m_File << stResult;
+	m_bFirstResult = false;
+}
+
+cLogSink::cLogSink()
+: m_PushCount(0), m_WriteCount(0), m_bStop(false)
+{
+	m_Thread = std::thread(&cLogSink::WriterLoop, this);
+}
+
+/**
+ * \brief
+ * Write out what is still queued, then stop the writer thread and close the writers.
+ */
+cLogSink::~cLogSink()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+
+	m_Condition.notify_one();
+	m_Thread.join();
+}
+
+auto cLogSink::AddWriter(std::unique_ptr<cLogWriter> writer) -> void
+{
+	std::lock_guard<std::mutex> lock(m_WriterMutex);
+	m_vecWriter.emplace_back(std::move(writer));
+}
+
+/**
+ * \brief
+ * Queue a record, it is written by the background thread.
+ * \param: record: SLogRecord
+ */
+auto cLogSink::Push(SLogRecord record) -> void
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_vecQueue.emplace_back(std::move(record));
+		++m_PushCount;
+	}
+
+	m_Condition.notify_one();
+}
+
+/**
+ * \brief
+ * Block until every record pushed so far has been written and flushed.
+ */
+auto cLogSink::Flush() -> void
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	const auto iTarget = m_PushCount;
+	m_Drained.wait(lock, [this, iTarget] { return m_WriteCount >= iTarget; });
+}
+
+auto cLogSink::WriterLoop() -> void
+{
+	std::vector<SLogRecord> vecBatch;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this] { return m_bStop || !m_vecQueue.empty(); });
+			if (m_vecQueue.empty())
+				return;
+
+			vecBatch.swap(m_vecQueue);
+		}
+
+		{
+			cProfileScope profile("write_log");
+			profile.AddRows(vecBatch.size());
+
+			std::lock_guard<std::mutex> lock(m_WriterMutex);
+			for (const auto & record : vecBatch)
+			{
+				for (const auto & writer : m_vecWriter)
+					writer->Write(record);
+			}
+
+			for (const auto & writer : m_vecWriter)
+				writer->Flush();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_WriteCount += vecBatch.size();
+		}
+
+		m_Drained.notify_all();
+		vecBatch.clear();
+	}
+}
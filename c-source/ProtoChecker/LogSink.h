@@ -0,0 +1,168 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+/**
+ * \brief
+ * Severity of a log record, it picks the console color and whether the record is a finding.
+ */
+enum ELogLevel : uint8_t
+{
+	LOG_PLAIN,
+	LOG_INFO,
+	LOG_OK,
+	LOG_ERROR,
+};
+
+/**
+ * \brief
+ * One log line, kept structured until a writer renders it.
+ * id: key of the message in the translation map.
+ * file/line: location of a finding, empty/0 for plain messages.
+ */
+struct SLogRecord
+{
+	ELogLevel level;
+	std::string id;
+	std::string text;
+	std::string file;
+	uint32_t line;
+};
+
+class cLogWriter
+{
+	public:
+		virtual ~cLogWriter() = default;
+
+	public:
+		virtual auto Write(const SLogRecord& record) -> void = 0;
+		virtual auto Flush() -> void = 0;
+};
+
+/**
+ * \brief
+ * Console writer, records are buffered and colored only when the output is a terminal.
+ */
+class cConsoleLogWriter : public cLogWriter
+{
+	private:
+		std::string m_Buffer;
+		bool m_bColor;
+
+	public:
+		cConsoleLogWriter();
+
+	public:
+		auto Write(const SLogRecord& record) -> void override;
+		auto Flush() -> void override;
+};
+
+/**
+ * \brief
+ * Base of the writers which stream to a file.
+ */
+class cFileLogWriter : public cLogWriter
+{
+	protected:
+		std::ofstream m_File;
+
+	public:
+		explicit cFileLogWriter(const std::string& fileName) : m_File(fileName, std::ios::out | std::ios::trunc) {}
+
+	public:
+		auto Flush() -> void override
+		{
+			m_File.flush();
+		}
+
+		auto IsOpen() const -> bool
+		{
+			return m_File.is_open();
+		}
+};
+
+/**
+ * \brief
+ * Plain text writer, the syslog.
+ */
+class cTextLogWriter : public cFileLogWriter
+{
+	public:
+		using cFileLogWriter::cFileLogWriter;
+
+	public:
+		auto Write(const SLogRecord& record) -> void override;
+};
+
+/**
+ * \brief
+ * JSON lines writer, one object per record.
+ */
+class cJsonLogWriter : public cFileLogWriter
+{
+	public:
+		using cFileLogWriter::cFileLogWriter;
+
+	public:
+		auto Write(const SLogRecord& record) -> void override;
+		static auto Format(const SLogRecord& record) -> std::string;
+};
+
+/**
+ * \brief
+ * SARIF 2.1.0 writer, every finding becomes a result; the document is closed when the writer is destroyed.
+ */
+class cSarifLogWriter : public cFileLogWriter
+{
+	private:
+		bool m_bFirstResult;
+
+	public:
+		explicit cSarifLogWriter(const std::string& fileName);
+		virtual ~cSarifLogWriter();
+
+	public:
+		auto Write(const SLogRecord& record) -> void override;
+};
+
+/**
+ * \brief
+ * Asynchronous log sink.
+ * Push only queues a record, a background thread hands the queued records to every writer in batches
+ * and flushes the writers once the batch is written, so output streams out while the checks are still running.
+ */
+class cLogSink
+{
+	private:
+		std::vector<std::unique_ptr<cLogWriter>> m_vecWriter;
+		std::vector<SLogRecord> m_vecQueue;
+		std::mutex m_Mutex;
+		std::mutex m_WriterMutex;
+		std::condition_variable m_Condition;
+		std::condition_variable m_Drained;
+		uint64_t m_PushCount;
+		uint64_t m_WriteCount;
+		bool m_bStop;
+		std::thread m_Thread;
+
+	public:
+		cLogSink();
+		virtual ~cLogSink();
+
+	public:
+		auto AddWriter(std::unique_ptr<cLogWriter> writer) -> void;
+		auto Push(SLogRecord record) -> void;
+		auto Flush() -> void;
+
+	private:
+		auto WriterLoop() -> void;
+
+		cLogSink(const cLogSink&) {}
+
+		auto operator =(const cLogSink&) const -> const cLogSink&
+		{
+			return *this;
+		}
+};
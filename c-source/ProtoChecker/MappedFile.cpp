@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+/**
+ * \brief
+ * Map a file into memory as read-only.
+ * An empty file is opened successfully with a null data pointer and a size of 0.
+ * \param: fileName: string
+ * \return: bool
+ */
+auto cMappedFile::Open(const char* fileName) -> bool
+{
+	Close();
+
+#ifdef _WIN32
+	const auto hFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER liSize;
+	if (!GetFileSizeEx(hFile, &liSize))
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	m_hFile = hFile;
+	m_Size = static_cast<size_t>(liSize.QuadPart);
+	m_bOpen = true;
+	if (m_Size == 0)
+		return true;
+
+	const auto hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!hMapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_hMapping = hMapping;
+	m_pData = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+#else
+	const auto iFd = open(fileName, O_RDONLY);
+	if (iFd < 0)
+		return false;
+
+	struct stat st {};
+	if (fstat(iFd, &st) != 0)
+	{
+		close(iFd);
+		return false;
+	}
+
+	m_Size = static_cast<size_t>(st.st_size);
+	m_bOpen = true;
+	if (m_Size == 0)
+	{
+		close(iFd);
+		return true;
+	}
+
+	auto pData = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, iFd, 0);
+	close(iFd);
+	if (pData == MAP_FAILED)
+	{
+		m_Size = 0;
+		m_bOpen = false;
+		return false;
+	}
+
+	madvise(pData, m_Size, MADV_SEQUENTIAL);
+	m_pData = static_cast<const char*>(pData);
+#endif
+
+	return true;
+}
+
+/**
+ * \brief
+ * Take the contents of a file from memory instead of mapping it.
+ * \param: data: string
+ */
+auto cMappedFile::Assign(std::string data) -> void
+{
+	Close();
+
+	m_Buffer = std::move(data);
+	m_pData = m_Buffer.empty() ? nullptr : m_Buffer.data();
+	m_Size = m_Buffer.size();
+	m_bOpen = true;
+}
+
+/**
+ * \brief
+ * Unmap the file and release every handle.
+ */
+auto cMappedFile::Close() -> void
+{
+	if (!m_Buffer.empty())
+	{
+		m_Buffer.clear();
+		m_Buffer.shrink_to_fit();
+		m_pData = nullptr;
+	}
+
+#ifdef _WIN32
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile)
+		CloseHandle(m_hFile);
+
+	m_hMapping = nullptr;
+	m_hFile = nullptr;
+#else
+	if (m_pData)
+		munmap(const_cast<char*>(m_pData), m_Size);
+#endif
+
+	m_pData = nullptr;
+	m_Size = 0;
+	m_bOpen = false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * \brief
+ * Read-only memory mapping of a whole file.
+ * The mapping stays valid until Close() or destruction, views handed out from Data() must not outlive it.
+ * Assign() holds an in-memory copy instead (e.g. an unsaved editor buffer), which is served the same way.
+ */
+class cMappedFile
+{
+	private:
+		const char * m_pData = nullptr;
+		size_t m_Size = 0;
+		bool m_bOpen = false;
+		std::string m_Buffer;
+#ifdef _WIN32
+		void * m_hFile = nullptr;
+		void * m_hMapping = nullptr;
+#endif
+
+	public:
+		cMappedFile() = default;
+		virtual ~cMappedFile() { Close(); }
+
+	public:
+		auto Open(const char* fileName) -> bool;
+		auto Assign(std::string data) -> void;
+		auto Close() -> void;
+
+		auto Data() const -> const char*
+		{
+			return m_pData;
+		}
+
+		auto Size() const -> size_t
+		{
+			return m_Size;
+		}
+
+		auto IsOpen() const -> bool
+		{
+			return m_bOpen;
+		}
+
+	private:
+		cMappedFile(const cMappedFile&) {}
+
+		auto operator =(const cMappedFile&) const -> const cMappedFile&
+		{
+			return *this;
+		}
+};
@@ -0,0 +1,243 @@
+#include "pch.h"
+#include "MinHashIndex.h"
+#include "Hash.h"
+#include <array>
+#include <numeric>
+
+namespace
+{
+	/**
+	 * \brief
+	 * Multipliers and increments of the multiply-shift hash functions, drawn once with splitmix64.
+	 */
+	struct SHashFunctions
+	{
+		std::array<uint64_t, CMinHashIndex::HASH_COUNT> multiplier;
+		std::array<uint64_t, CMinHashIndex::HASH_COUNT> increment;
+
+		SHashFunctions()
+		{
+			uint64_t state = 0x5DEECE66DULL;
+			const auto Next = [&state]
+			{
+				auto value = (state += 0x9E3779B97F4A7C15ULL);
+				value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+				return value ^ (value >> 31);
+			};
+
+			for (uint32_t i = 0; i < CMinHashIndex::HASH_COUNT; ++i)
+			{
+				multiplier[i] = Next() | 1;
+				increment[i] = Next();
+			}
+		}
+	};
+
+	const SHashFunctions HASH_FUNCTIONS;
+
+	/**
+	 * \brief
+	 * Append the code points of a UTF-8 text, ASCII letters lowered and runs of spaces collapsed.
+	 * A byte which doesn't start a valid sequence is taken as a code point of its own.
+	 */
+	auto GetCodePoints(std::string_view text, std::vector<uint32_t>& vecCodePoint) -> void
+	{
+		vecCodePoint.clear();
+
+		const auto data = reinterpret_cast<const unsigned char*>(text.data());
+		for (size_t pos = 0; pos < text.size();)
+		{
+			uint32_t codePoint = data[pos];
+			size_t length = 1;
+			if (codePoint >= 0xC0)
+			{
+				length = codePoint >= 0xF0 ? 4 : codePoint >= 0xE0 ? 3 : 2;
+				if (pos + length > text.size() || !std::all_of(data + pos + 1, data + pos + length, [](unsigned char c) { return (c & 0xC0) == 0x80; }))
+				{
+					length = 1;
+				}
+				else
+				{
+					codePoint &= 0x3F >> (length - 1);
+					for (size_t i = 1; i < length; ++i)
+						codePoint = (codePoint << 6) | (data[pos + i] & 0x3F);
+				}
+			}
+			else if (codePoint >= 'A' && codePoint <= 'Z')
+			{
+				codePoint += 'a' - 'A';
+			}
+
+			pos += length;
+			if (codePoint == ' ' && (vecCodePoint.empty() || vecCodePoint.back() == ' '))
+				continue;
+
+			vecCodePoint.push_back(codePoint);
+		}
+
+		while (!vecCodePoint.empty() && vecCodePoint.back() == ' ')
+			vecCodePoint.pop_back();
+	}
+
+	auto FindRoot(std::vector<uint32_t>& vecParent, uint32_t id) -> uint32_t
+	{
+		while (vecParent[id] != id)
+		{
+			vecParent[id] = vecParent[vecParent[id]];
+			id = vecParent[id];
+		}
+		return id;
+	}
+}
+
+/**
+ * \brief
+ * Add the signature of a text.
+ * \param: text: string_view, UTF-8
+ * \return: uint32_t, id of the text, ids are given in order from 0
+ */
+auto CMinHashIndex::Add(std::string_view text) -> uint32_t
+{
+	const auto id = static_cast<uint32_t>(GetSize());
+
+	// Texts shorter than an n-gram still get one, the padding marks where the text starts and ends.
+	auto & vecCodePoint = m_vecCodePoint;
+	vecCodePoint.assign(1, 0);
+	GetCodePoints(text, vecCodePoint);
+	vecCodePoint.push_back(0);
+	while (vecCodePoint.size() < NGRAM_SIZE)
+		vecCodePoint.push_back(0);
+
+	std::array<uint32_t, HASH_COUNT> signature;
+	signature.fill(UINT32_MAX);
+
+	const auto ngramBegin = m_vecNgram.size();
+	for (size_t pos = 0; pos + NGRAM_SIZE <= vecCodePoint.size(); ++pos)
+	{
+		const auto ngram = hash_xxh64(vecCodePoint.data() + pos, NGRAM_SIZE * sizeof(uint32_t));
+		for (uint32_t i = 0; i < HASH_COUNT; ++i)
+			signature[i] = std::min(signature[i], static_cast<uint32_t>((ngram * HASH_FUNCTIONS.multiplier[i] + HASH_FUNCTIONS.increment[i]) >> 32));
+
+		m_vecNgram.push_back(static_cast<uint32_t>(ngram));
+	}
+
+	// The n-grams are a set, repeated ones count once.
+	std::sort(m_vecNgram.begin() + ngramBegin, m_vecNgram.end());
+	m_vecNgram.erase(std::unique(m_vecNgram.begin() + ngramBegin, m_vecNgram.end()), m_vecNgram.end());
+	m_vecNgramOffset.push_back(m_vecNgram.size());
+
+	m_vecSignature.insert(m_vecSignature.end(), signature.begin(), signature.end());
+	return id;
+}
+
+/**
+ * \brief
+ * Jaccard similarity of the n-gram sets of two texts.
+ * \param: first: uint32_t
+ * \param: second: uint32_t
+ * \return: double, 0..1
+ */
+auto CMinHashIndex::GetSimilarity(uint32_t first, uint32_t second) const -> double
+{
+	auto itFirst = m_vecNgram.begin() + m_vecNgramOffset[first];
+	const auto itFirstEnd = m_vecNgram.begin() + m_vecNgramOffset[first + 1];
+	auto itSecond = m_vecNgram.begin() + m_vecNgramOffset[second];
+	const auto itSecondEnd = m_vecNgram.begin() + m_vecNgramOffset[second + 1];
+
+	const auto iUnion = static_cast<size_t>((itFirstEnd - itFirst) + (itSecondEnd - itSecond));
+	size_t iShared = 0;
+	while (itFirst != itFirstEnd && itSecond != itSecondEnd)
+	{
+		if (*itFirst < *itSecond)
+		{
+			++itFirst;
+		}
+		else if (*itSecond < *itFirst)
+		{
+			++itSecond;
+		}
+		else
+		{
+			++iShared;
+			++itFirst;
+			++itSecond;
+		}
+	}
+
+	return static_cast<double>(iShared) / static_cast<double>(iUnion - iShared);
+}
+
+/**
+ * \brief
+ * Group the texts whose similarity reaches the threshold.
+ * Every bucket of a band keeps the first text which fell in it and every later text is compared with it only,
+ * so a bucket of n equal texts costs n comparisons; clusters are joined across the bands with a union-find.
+ * \param: threshold: double, Jaccard similarity
+ * \param: canPair: function, false to keep two texts apart even if they're similar
+ * \return: vector, clusters of at least two ids, ids and clusters in ascending order
+ */
+auto CMinHashIndex::FindClusters(double threshold, const std::function<bool(uint32_t, uint32_t)>& canPair) const -> std::vector<std::vector<uint32_t>>
+{
+	const auto iSize = static_cast<uint32_t>(GetSize());
+	std::vector<uint32_t> vecParent(iSize);
+	std::iota(vecParent.begin(), vecParent.end(), 0);
+
+	// Buckets live in an open addressing table, the band keys are hashes already and index it directly.
+	static constexpr auto NO_ANCHOR = UINT32_MAX;
+	size_t tableSize = 16;
+	while (tableSize < size_t(iSize) * 2)
+		tableSize *= 2;
+
+	std::vector<uint64_t> vecBucketKey(tableSize);
+	std::vector<uint32_t> vecBucketAnchor(tableSize);
+
+	for (uint32_t band = 0; band < BAND_COUNT; ++band)
+	{
+		std::fill(vecBucketAnchor.begin(), vecBucketAnchor.end(), NO_ANCHOR);
+		for (uint32_t id = 0; id < iSize; ++id)
+		{
+			const auto pBand = m_vecSignature.data() + size_t(id) * HASH_COUNT + band * BAND_ROWS;
+			const auto key = hash_xxh64(pBand, BAND_ROWS * sizeof(uint32_t), band);
+
+			auto slot = key & (tableSize - 1);
+			while (vecBucketAnchor[slot] != NO_ANCHOR && vecBucketKey[slot] != key)
+				slot = (slot + 1) & (tableSize - 1);
+
+			if (vecBucketAnchor[slot] == NO_ANCHOR)
+			{
+				vecBucketKey[slot] = key;
+				vecBucketAnchor[slot] = id;
+				continue;
+			}
+
+			const auto anchor = vecBucketAnchor[slot];
+			const auto anchorRoot = FindRoot(vecParent, anchor);
+			const auto root = FindRoot(vecParent, id);
+			if (anchorRoot != root && canPair(anchor, id) && GetSimilarity(anchor, id) >= threshold)
+				vecParent[std::max(anchorRoot, root)] = std::min(anchorRoot, root);
+		}
+	}
+
+	// The smallest id is the root of its cluster, so clusters come out ordered by their first id.
+	std::vector<uint32_t> vecClusterSize(iSize, 0);
+	for (uint32_t id = 0; id < iSize; ++id)
+		++vecClusterSize[FindRoot(vecParent, id)];
+
+	std::unordered_map<uint32_t, size_t> mapCluster;
+	std::vector<std::vector<uint32_t>> vecCluster;
+	for (uint32_t id = 0; id < iSize; ++id)
+	{
+		const auto root = FindRoot(vecParent, id);
+		if (vecClusterSize[root] < 2)
+			continue;
+
+		const auto it = mapCluster.try_emplace(root, vecCluster.size());
+		if (it.second)
+			vecCluster.emplace_back();
+
+		vecCluster[it.first->second].push_back(id);
+	}
+
+	return vecCluster;
+}
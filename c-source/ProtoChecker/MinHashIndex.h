@@ -0,0 +1,49 @@
+#pragma once
+#include <functional>
+
+/**
+ * \brief
+ * MinHash signatures of short texts with a locality-sensitive hashing index over them.
+ * A text is cut into character n-grams (code points, padded at both ends), its signature keeps the minimum
+ * of HASH_COUNT hash functions over its n-grams, so two signatures agree on a share of their values
+ * which estimates the Jaccard similarity of the n-gram sets.
+ * The signature is split into BAND_COUNT bands of BAND_ROWS values; texts with an identical band land in the same bucket,
+ * only those pairs are compared, which finds pairs above ~(1 / BAND_COUNT) ^ (1 / BAND_ROWS) in linear time.
+ * The sorted n-gram hashes are kept as well, a candidate pair is confirmed with its exact Jaccard similarity.
+ */
+class CMinHashIndex
+{
+	public:
+		static constexpr uint32_t NGRAM_SIZE = 3;
+		static constexpr uint32_t BAND_COUNT = 8;
+		static constexpr uint32_t BAND_ROWS = 4;
+		static constexpr uint32_t HASH_COUNT = BAND_COUNT * BAND_ROWS;
+
+	private:
+		std::vector<uint32_t> m_vecSignature;
+		std::vector<uint32_t> m_vecNgram;
+		std::vector<size_t> m_vecNgramOffset{ 0 };
+		std::vector<uint32_t> m_vecCodePoint;
+
+	public:
+		CMinHashIndex() = default;
+		virtual ~CMinHashIndex() = default;
+
+	public:
+		auto Add(std::string_view text) -> uint32_t;
+		auto GetSimilarity(uint32_t first, uint32_t second) const -> double;
+		auto FindClusters(double threshold, const std::function<bool(uint32_t, uint32_t)>& canPair) const -> std::vector<std::vector<uint32_t>>;
+
+		auto GetSize() const -> size_t
+		{
+			return m_vecSignature.size() / HASH_COUNT;
+		}
+
+	private:
+		CMinHashIndex(const CMinHashIndex&) {}
+
+		auto operator =(const CMinHashIndex&) const -> const CMinHashIndex&
+		{
+			return *this;
+		}
+};
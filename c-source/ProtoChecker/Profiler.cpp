@@ -0,0 +1,364 @@
+#include "pch.h"
+#include "Profiler.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <psapi.h>
+	#ifdef _MSC_VER
+		#pragma comment(lib, "psapi.lib")
+	#endif
+#else
+	#include <sys/resource.h>
+	#include <time.h>
+#endif
+
+namespace
+{
+	thread_local uint64_t t_AllocationCount = 0;
+	thread_local uint64_t t_AllocatedBytes = 0;
+	thread_local uint64_t t_FindingCount = 0;
+	thread_local double t_PausedCpuTime = 0;
+
+	/**
+	 * \brief
+	 * Exported metrics of a phase, the name is the JSON key and the suffix of the Prometheus metric.
+	 */
+	struct SProfileMetric
+	{
+		const char* name;
+		const char* help;
+		double (*get)(const SProfilePhase&);
+	};
+
+	const SProfileMetric PROFILE_METRICS[] =
+	{
+		{ "calls",              "Times the phase ran.",                         [](const SProfilePhase& phase) { return double(phase.calls); } },
+		{ "wall_seconds",       "Wall time spent in the phase.",                [](const SProfilePhase& phase) { return phase.wallTime; } },
+		{ "cpu_seconds",        "Cpu time of the thread which ran the phase.",  [](const SProfilePhase& phase) { return phase.cpuTime; } },
+		{ "rows",               "Rows handled by the phase.",                   [](const SProfilePhase& phase) { return double(phase.rows); } },
+		{ "bytes",              "Bytes read by the phase.",                     [](const SProfilePhase& phase) { return double(phase.bytes); } },
+		{ "rows_per_second",    "Rows handled per second of wall time.",        [](const SProfilePhase& phase) { return phase.wallTime > 0 ? double(phase.rows) / phase.wallTime : 0; } },
+		{ "bytes_per_second",   "Bytes read per second of wall time.",          [](const SProfilePhase& phase) { return phase.wallTime > 0 ? double(phase.bytes) / phase.wallTime : 0; } },
+		{ "allocations",        "Allocations made by the phase.",               [](const SProfilePhase& phase) { return double(phase.allocations); } },
+		{ "allocated_bytes",    "Bytes allocated by the phase.",                [](const SProfilePhase& phase) { return double(phase.allocatedBytes); } },
+		{ "findings",           "Findings reported by the phase.",              [](const SProfilePhase& phase) { return double(phase.findings); } },
+		{ "peak_memory_bytes",  "Peak resident size of the process after the phase.", [](const SProfilePhase& phase) { return double(phase.peakMemory); } },
+	};
+
+	auto CountAllocation(std::size_t size) -> void
+	{
+		++t_AllocationCount;
+		t_AllocatedBytes += size;
+	}
+
+	auto Allocate(std::size_t size) -> void*
+	{
+		CountAllocation(size);
+		for (;;)
+		{
+			if (const auto p = std::malloc(size ? size : 1))
+				return p;
+
+			const auto handler = std::get_new_handler();
+			if (!handler)
+				throw std::bad_alloc();
+			handler();
+		}
+	}
+}
+
+/**
+ * \brief
+ * Replaced global allocation functions, they only count the allocations of the calling thread.
+ */
+auto operator new(std::size_t size) -> void*
+{
+	return Allocate(size);
+}
+
+auto operator new[](std::size_t size) -> void*
+{
+	return Allocate(size);
+}
+
+auto operator new(std::size_t size, const std::nothrow_t&) noexcept -> void*
+{
+	CountAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+auto operator new[](std::size_t size, const std::nothrow_t&) noexcept -> void*
+{
+	CountAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+auto operator delete(void* p) noexcept -> void
+{
+	std::free(p);
+}
+
+auto operator delete[](void* p) noexcept -> void
+{
+	std::free(p);
+}
+
+auto operator delete(void* p, std::size_t) noexcept -> void
+{
+	std::free(p);
+}
+
+auto operator delete[](void* p, std::size_t) noexcept -> void
+{
+	std::free(p);
+}
+
+auto operator delete(void* p, const std::nothrow_t&) noexcept -> void
+{
+	std::free(p);
+}
+
+auto operator delete[](void* p, const std::nothrow_t&) noexcept -> void
+{
+	std::free(p);
+}
+
+std::atomic<bool> cProfiler::s_bEnabled{ false };
+
+auto cProfiler::Instance() -> cProfiler&
+{
+	static cProfiler profiler;
+	return profiler;
+}
+
+/**
+ * \brief
+ * Start measuring, the run time of the export is counted from here.
+ */
+auto cProfiler::Enable() -> void
+{
+	m_Start = std::chrono::steady_clock::now();
+	s_bEnabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * \brief
+ * Add a measured run of a phase to its totals.
+ * \param: name: string
+ * \param: phase: SProfilePhase
+ */
+auto cProfiler::AddPhase(const std::string& name, const SProfilePhase& phase) -> void
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto & total = m_mapPhase[name];
+	total.calls += phase.calls;
+	total.wallTime += phase.wallTime;
+	total.cpuTime += phase.cpuTime;
+	total.rows += phase.rows;
+	total.bytes += phase.bytes;
+	total.allocations += phase.allocations;
+	total.allocatedBytes += phase.allocatedBytes;
+	total.findings += phase.findings;
+	total.peakMemory = std::max(total.peakMemory, phase.peakMemory);
+}
+
+auto cProfiler::GetPhases() -> std::map<std::string, SProfilePhase>
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_mapPhase;
+}
+
+/**
+ * \brief
+ * Write the phases as one JSON document, phases in name order.
+ * \param: fileName: string
+ * \return: bool
+ */
+auto cProfiler::WriteJson(const std::string& fileName) -> bool
+{
+	std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+	if (!file)
+		return false;
+
+	const auto runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+	file << format("{\"wall_seconds\":%.9g,\"peak_memory_bytes\":%llu,\"phases\":[", runTime, static_cast<unsigned long long>(GetPeakMemory()));
+
+	auto bFirst = true;
+	for (const auto & it : GetPhases())
+	{
+		file << (bFirst ? "\n" : ",\n") << "{\"name\":\"" << it.first << '"';
+		for (const auto & metric : PROFILE_METRICS)
+			file << format(",\"%s\":%.15g", metric.name, metric.get(it.second));
+		file << '}';
+		bFirst = false;
+	}
+
+	file << "\n]}\n";
+	return file.good();
+}
+
+/**
+ * \brief
+ * Write the phases in the Prometheus text exposition format, every metric is a gauge labelled with the phase.
+ * \param: fileName: string
+ * \return: bool
+ */
+auto cProfiler::WritePrometheus(const std::string& fileName) -> bool
+{
+	std::ofstream file(fileName, std::ios::out | std::ios::trunc);
+	if (!file)
+		return false;
+
+	const auto & mapPhase = GetPhases();
+	const auto runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+
+	file << "# HELP protochecker_run_wall_seconds Wall time of the whole run.\n# TYPE protochecker_run_wall_seconds gauge\n";
+	file << format("protochecker_run_wall_seconds %.9g\n", runTime);
+	file << "# HELP protochecker_peak_memory_bytes Peak resident size of the process.\n# TYPE protochecker_peak_memory_bytes gauge\n";
+	file << format("protochecker_peak_memory_bytes %llu\n", static_cast<unsigned long long>(GetPeakMemory()));
+
+	for (const auto & metric : PROFILE_METRICS)
+	{
+		file << format("# HELP protochecker_phase_%s %s\n# TYPE protochecker_phase_%s gauge\n", metric.name, metric.help, metric.name);
+		for (const auto & it : mapPhase)
+			file << format("protochecker_phase_%s{phase=\"%s\"} %.15g\n", metric.name, it.first.c_str(), metric.get(it.second));
+	}
+
+	return file.good();
+}
+
+/**
+ * \brief
+ * Count a finding of the calling thread, it's attributed to the phase the thread is in.
+ */
+auto cProfiler::CountFinding() -> void
+{
+	++t_FindingCount;
+}
+
+auto cProfiler::GetFindingCount() -> uint64_t
+{
+	return t_FindingCount;
+}
+
+auto cProfiler::GetAllocationCount() -> uint64_t
+{
+	return t_AllocationCount;
+}
+
+auto cProfiler::GetAllocatedBytes() -> uint64_t
+{
+	return t_AllocatedBytes;
+}
+
+/**
+ * \brief
+ * Cpu time (user and kernel) used by the calling thread so far.
+ * \return: double, seconds
+ */
+auto cProfiler::GetThreadCpuTime() -> double
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+		return 0;
+
+	const auto ToTicks = [](const FILETIME& time) { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+	return static_cast<double>(ToTicks(kernel) + ToTicks(user)) * 1e-7;
+#else
+	timespec time {};
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+		return 0;
+
+	return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+}
+
+/**
+ * \brief
+ * Peak resident size of the process so far.
+ * \return: uint64_t, bytes
+ */
+auto cProfiler::GetPeakMemory() -> uint64_t
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters {};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss);
+	#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+	#endif
+#endif
+}
+
+cProfileScope::cProfileScope(const char* name) : m_Name(name), m_bActive(cProfiler::IsEnabled())
+{
+	if (!m_bActive)
+		return;
+
+	m_AllocationStart = cProfiler::GetAllocationCount();
+	m_AllocatedBytesStart = cProfiler::GetAllocatedBytes();
+	m_FindingStart = cProfiler::GetFindingCount();
+	m_CpuStart = cProfiler::GetThreadCpuTime() - t_PausedCpuTime;
+	m_Start = std::chrono::steady_clock::now();
+}
+
+cProfileScope::~cProfileScope()
+{
+	if (!m_bActive)
+		return;
+
+	m_Phase.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+	m_Phase.cpuTime = cProfiler::GetThreadCpuTime() - t_PausedCpuTime - m_CpuStart;
+	m_Phase.calls = 1;
+	m_Phase.allocations = cProfiler::GetAllocationCount() - m_AllocationStart;
+	m_Phase.allocatedBytes = cProfiler::GetAllocatedBytes() - m_AllocatedBytesStart;
+	m_Phase.findings = cProfiler::GetFindingCount() - m_FindingStart;
+	m_Phase.peakMemory = cProfiler::GetPeakMemory();
+
+	cProfiler::Instance().AddPhase(m_Name, m_Phase);
+}
+
+cProfilePause::cProfilePause() : m_bActive(cProfiler::IsEnabled())
+{
+	if (!m_bActive)
+		return;
+
+	m_AllocationStart = t_AllocationCount;
+	m_AllocatedBytesStart = t_AllocatedBytes;
+	m_FindingStart = t_FindingCount;
+	m_CpuStart = cProfiler::GetThreadCpuTime();
+}
+
+/**
+ * \brief
+ * The counters go back to where they were, so the scopes still open on the thread don't see the paused work;
+ * the scopes opened and closed meanwhile already took their share.
+ */
+cProfilePause::~cProfilePause()
+{
+	if (!m_bActive)
+		return;
+
+	t_AllocationCount = m_AllocationStart;
+	t_AllocatedBytes = m_AllocatedBytesStart;
+	t_FindingCount = m_FindingStart;
+	t_PausedCpuTime += cProfiler::GetThreadCpuTime() - m_CpuStart;
+}
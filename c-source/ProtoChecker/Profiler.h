@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+/**
+ * \brief
+ * Totals of one phase over every time it ran.
+ * wallTime/cpuTime: seconds, the cpu time is the one of the thread which ran the phase.
+ * allocations/allocatedBytes: operator new calls of that thread during the phase.
+ * findings: records logged with a location (write_finding) during the phase.
+ * A task the thread runs for the pool while the phase waits (see cProfilePause) only adds to the wall time.
+ * peakMemory: peak resident size of the process when the phase ended, in bytes.
+ */
+struct SProfilePhase
+{
+	uint64_t calls = 0;
+	double wallTime = 0;
+	double cpuTime = 0;
+	uint64_t rows = 0;
+	uint64_t bytes = 0;
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+	uint64_t findings = 0;
+	uint64_t peakMemory = 0;
+};
+
+/**
+ * \brief
+ * Phase metrics of a run, exported by --profile as JSON and in the Prometheus text format.
+ * Phases are measured by cProfileScope objects; while the profiler is disabled a scope costs one relaxed atomic load.
+ * Allocations are counted by the replaced global operator new in thread local counters, so the count never contends.
+ */
+class cProfiler
+{
+	private:
+		static std::atomic<bool> s_bEnabled;
+
+		std::map<std::string, SProfilePhase> m_mapPhase;
+		std::mutex m_Mutex;
+		std::chrono::steady_clock::time_point m_Start;
+
+	public:
+		cProfiler() = default;
+		virtual ~cProfiler() = default;
+
+	public:
+		static auto Instance() -> cProfiler&;
+
+		static auto IsEnabled() -> bool
+		{
+			return s_bEnabled.load(std::memory_order_relaxed);
+		}
+
+		auto Enable() -> void;
+		auto AddPhase(const std::string& name, const SProfilePhase& phase) -> void;
+		auto GetPhases() -> std::map<std::string, SProfilePhase>;
+
+		auto WriteJson(const std::string& fileName) -> bool;
+		auto WritePrometheus(const std::string& fileName) -> bool;
+
+		static auto CountFinding() -> void;
+		static auto GetFindingCount() -> uint64_t;
+		static auto GetAllocationCount() -> uint64_t;
+		static auto GetAllocatedBytes() -> uint64_t;
+		static auto GetThreadCpuTime() -> double;
+		static auto GetPeakMemory() -> uint64_t;
+
+	private:
+		cProfiler(const cProfiler&) {}
+
+		auto operator =(const cProfiler&) const -> const cProfiler&
+		{
+			return *this;
+		}
+};
+
+/**
+ * \brief
+ * Measure a phase from construction to destruction, rows and bytes are added by the phase as it learns them.
+ */
+class cProfileScope
+{
+	private:
+		const char* m_Name;
+		bool m_bActive;
+		SProfilePhase m_Phase;
+		std::chrono::steady_clock::time_point m_Start;
+		double m_CpuStart = 0;
+		uint64_t m_AllocationStart = 0;
+		uint64_t m_AllocatedBytesStart = 0;
+		uint64_t m_FindingStart = 0;
+
+	public:
+		explicit cProfileScope(const char* name);
+		virtual ~cProfileScope();
+
+	public:
+		auto IsActive() const -> bool
+		{
+			return m_bActive;
+		}
+
+		auto AddRows(uint64_t rows) -> void
+		{
+			m_Phase.rows += rows;
+		}
+
+		auto AddBytes(uint64_t bytes) -> void
+		{
+			m_Phase.bytes += bytes;
+		}
+
+	private:
+		cProfileScope(const cProfileScope&) {}
+
+		auto operator =(const cProfileScope&) const -> const cProfileScope&
+		{
+			return *this;
+		}
+};
+
+/**
+ * \brief
+ * Leave out of the phases of the calling thread what it runs from construction to destruction.
+ * A thread waiting on the pool runs other queued tasks, their allocations, findings and cpu time belong to their own phases.
+ */
+class cProfilePause
+{
+	private:
+		bool m_bActive;
+		double m_CpuStart = 0;
+		uint64_t m_AllocationStart = 0;
+		uint64_t m_AllocatedBytesStart = 0;
+		uint64_t m_FindingStart = 0;
+
+	public:
+		cProfilePause();
+		virtual ~cProfilePause();
+
+	private:
+		cProfilePause(const cProfilePause&) {}
+
+		auto operator =(const cProfilePause&) const -> const cProfilePause&
+		{
+			return *this;
+		}
+};
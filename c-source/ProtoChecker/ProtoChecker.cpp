@@ -7,6 +7,23 @@ __version__ = "0.0.1"
 #include "pch.h"
 #include "ProtoChecker.h"
 #include "CsvReader.h"
+#include "CsvColumnTable.h"
+#include "ThreadPool.h"
+#include "FileMonitor.h"
+#include "ProtoSnapshot.h"
+#include "Hash.h"
+#include "MinHashIndex.h"
+#include "LocalSocket.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
+#include "TokenTables.h"
+#include "VnumRangeIndex.h"
+#include <chrono>
+#include <filesystem>
+#include <unordered_set>
+#include <deque>
+#include <sstream>
+#include <system_error>
 
 /**
  * \brief
@@ -20,7 +37,7 @@ enum EDelimiter : char
 
 /**
  * \brief
- * Vnum range config.
+ * Vnum range convention of item_proto: a row keyed from VNUM_RANGE_START to VNUM_RANGE_END is the range X~X+VNUM_RANGE.
  */
 enum EVnumRangeConfig : uint32_t
 {
@@ -31,272 +48,3282 @@ enum EVnumRangeConfig : uint32_t
 
 /**
  * \brief
- * Path configuration.
+ * Builtin translation.
+ */
+using TLocaleStringMap = std::map<std::string, std::pair<ELogLevel, std::string>>;
+const TLocaleStringMap TRANSLATE_MAP =
+{
+	{"DUPLICATE_START",     {LOG_PLAIN, "###### START_CHECKING_FOR_DUPLICATE ######"}},
+	{"DUPLICATE_END",       {LOG_PLAIN, "###### END_CHECKING_FOR_DUPLICATE ######"}},
+	{"COMPARE_START",       {LOG_PLAIN, "###### START_COMPARING ######"}},
+	{"COMPARE_END",         {LOG_PLAIN, "###### END_COMPARING ######"}},
+	{"FILE_EMPTY",          {LOG_OK,    "File %s is empty."}},
+	{"FILE_OK",             {LOG_OK,    "\tOK"}},
+	{"FILE_NAME",           {LOG_INFO,  "Reading file: %s"}},
+	{"FILE_TOTAL_LINES",    {LOG_ERROR, "\tTotal lines: %u"}},
+	{"FILE_DUPLICATE_LINE", {LOG_ERROR, "\tDuplicated itemVnum: %s at lines: %s"}},
+	{"FILE_COMPARING_LINE", {LOG_ERROR, "\tMissing itemVnum: %s"}},
+	{"REFERENCE_START",     {LOG_PLAIN, "###### START_CHECKING_REFERENCES ######"}},
+	{"REFERENCE_END",       {LOG_PLAIN, "###### END_CHECKING_REFERENCES ######"}},
+	{"REFERENCE_RULE",      {LOG_INFO,  "Checking references: %s %s -> %s"}},
+	{"REFERENCE_SKIPPED",   {LOG_INFO,  "\tSkipped, %s not found"}},
+	{"REFERENCE_BROKEN",    {LOG_ERROR, "\tBroken reference at line %u, %s: %s not found in %s"}},
+	{"SIMILAR_START",       {LOG_PLAIN, "###### START_CHECKING_FOR_SIMILAR_NAMES ######"}},
+	{"SIMILAR_END",         {LOG_PLAIN, "###### END_CHECKING_FOR_SIMILAR_NAMES ######"}},
+	{"SIMILAR_CLUSTER",     {LOG_INFO,  "\tSimilar names, %u rows:"}},
+	{"SIMILAR_NAME",        {LOG_ERROR, "\t\tvnum: %s, name: %s"}},
+	{"CLONE_START",         {LOG_PLAIN, "###### START_CHECKING_FOR_CLONES ######"}},
+	{"CLONE_END",           {LOG_PLAIN, "###### END_CHECKING_FOR_CLONES ######"}},
+	{"CLONE_SKIPPED",       {LOG_INFO,  "\tSkipped, %s"}},
+	{"CLONE_CLUSTER",       {LOG_INFO,  "\tSame content, %u rows:"}},
+	{"CLONE_ROW",           {LOG_ERROR, "\t\tvnum: %s, name: %s at line %u"}},
+	{"FIX_START",           {LOG_PLAIN, "###### START_FIXING ######"}},
+	{"FIX_END",             {LOG_PLAIN, "###### END_FIXING ######"}},
+	{"FIX_WRITTEN",         {LOG_OK,    "\tRewritten, %u duplicated rows removed, %u names added, backup in %s"}},
+	{"FIX_FAILED",          {LOG_ERROR, "\tCannot write %s"}},
+	{"FIX_SORTED",          {LOG_OK,    "\tRewritten in vnum order, backup in %s"}},
+	{"DIFF_START",          {LOG_PLAIN, "###### START_DIFF ######"}},
+	{"DIFF_END",            {LOG_PLAIN, "###### END_DIFF ######"}},
+	{"DIFF_FILES",          {LOG_INFO,  "Comparing revisions: %s -> %s"}},
+	{"DIFF_LOAD_FAILED",    {LOG_ERROR, "\tCannot load %s"}},
+	{"DIFF_ENCODING",       {LOG_INFO,  "\tEncoding changed: %s -> %s"}},
+	{"DIFF_COLUMN_ADDED",   {LOG_OK,    "\tAdded column: %s"}},
+	{"DIFF_COLUMN_REMOVED", {LOG_ERROR, "\tRemoved column: %s"}},
+	{"DIFF_ROW_ADDED",      {LOG_OK,    "\tAdded vnum: %s"}},
+	{"DIFF_ROW_REMOVED",    {LOG_ERROR, "\tRemoved vnum: %s"}},
+	{"DIFF_ROW_MODIFIED",   {LOG_INFO,  "\tModified vnum: %s"}},
+	{"DIFF_FIELD",          {LOG_PLAIN, "\t\t%s: %s -> %s"}},
+	{"DIFF_SUMMARY",        {LOG_INFO,  "\t%u rows added, %u removed, %u modified, %u unchanged"}},
+	{"LOCALE_NAME",         {LOG_INFO,  "Locale: %s"}},
+	{"COVERAGE_START",      {LOG_PLAIN, "###### START_COVERAGE_MATRIX ######"}},
+	{"COVERAGE_END",        {LOG_PLAIN, "###### END_COVERAGE_MATRIX ######"}},
+	{"COVERAGE_HEADER",     {LOG_INFO,  "\tvnum\t%s"}},
+	{"COVERAGE_ROW",        {LOG_ERROR, "\t%s\t%s"}},
+	{"WATCH_START",         {LOG_INFO,  "Watching %s for changes..."}},
+	{"WATCH_FILE_CHANGED",  {LOG_INFO,  "Changed file: %s (%u rows removed, %u rows added)"}},
+	{"WATCH_DUPLICATE_OK",  {LOG_OK,    "\tNo longer duplicated vnum: %s"}},
+	{"WATCH_MISSING_LINE",  {LOG_ERROR, "\tMissing vnum: %s in %s"}},
+	{"WATCH_FOUND_LINE",    {LOG_OK,    "\tNo longer missing vnum: %s in %s"}},
+	{"WATCH_NO_CHANGE",     {LOG_OK,    "\tNo result changed"}},
+	{"WATCH_DONE",          {LOG_INFO,  "\tChecked in %.2f ms"}},
+	{"DAEMON_START",        {LOG_INFO,  "Serving %s on %s"}},
+	{"DAEMON_NO_SOCKET",    {LOG_ERROR, "Cannot listen on %s"}},
+	{"DAEMON_NO_ACCEPT",    {LOG_ERROR, "Cannot accept a client on %s: %s"}},
+	{"DAEMON_STOPPED",      {LOG_ERROR, "Stopped serving %s after %u failures in a row"}},
+	{"DAEMON_RELOADED",     {LOG_INFO,  "Reloaded file: %s (%u rows) in %.2f ms"}},
+	{"DAEMON_BAD_REQUEST",  {LOG_ERROR, "Bad request: %s"}},
+	{"DAEMON_UNKNOWN_FILE", {LOG_ERROR, "Unknown file: %s"}},
+	{"DAEMON_VNUM_DEFINED", {LOG_OK,    "\tvnum: %s defined in %s"}},
+	{"DAEMON_VNUM_RANGE",   {LOG_OK,    "\tvnum: %s in range %u~%u of %s"}},
+	{"DAEMON_VNUM_MISSING", {LOG_ERROR, "\tvnum: %s not found in %s"}},
+	{"COLUMN_START",        {LOG_PLAIN, "###### START_CHECKING_COLUMNS ######"}},
+	{"COLUMN_END",          {LOG_PLAIN, "###### END_CHECKING_COLUMNS ######"}},
+	{"COLUMN_RULE",         {LOG_INFO,  "Checking columns: %s %s"}},
+	{"COLUMN_SKIPPED",      {LOG_INFO,  "\tSkipped, %s"}},
+	{"COLUMN_BROKEN",       {LOG_ERROR, "\tBroken rule at line %u, %s"}},
+	{"TOKEN_START",         {LOG_PLAIN, "###### START_CHECKING_TOKENS ######"}},
+	{"TOKEN_END",           {LOG_PLAIN, "###### END_CHECKING_TOKENS ######"}},
+	{"TOKEN_COLUMN",        {LOG_INFO,  "Checking tokens: %s %s"}},
+	{"TOKEN_UNKNOWN",       {LOG_ERROR, "\tUnknown token at line %u, column %u: %s"}},
+	{"TOKEN_MISSPELLED",    {LOG_ERROR, "\tUnknown token at line %u, column %u: %s, did you mean %s?"}},
+	{"RANGE_START",         {LOG_PLAIN, "###### START_CHECKING_RANGES ######"}},
+	{"RANGE_END",           {LOG_PLAIN, "###### END_CHECKING_RANGES ######"}},
+	{"RANGE_OVERLAP",       {LOG_ERROR, "\tOverlapping ranges at lines %u and %u: %s and %s"}},
+	{"RANGE_INSIDE",        {LOG_ERROR, "\tVnum at line %u inside the range at line %u: %s in %s"}},
+	{"RANGE_REVERSED",      {LOG_ERROR, "\tReversed range at line %u: %s"}},
+	{"RANGE_MALFORMED",     {LOG_ERROR, "\tMalformed range at line %u: %s"}},
+	{"RANGE_CONVENTION",    {LOG_ERROR, "\tRange at line %u: %s, expected %u~%u"}},
+	{"FREE_START",          {LOG_PLAIN, "###### START_FINDING_FREE_VNUMS ######"}},
+	{"FREE_END",            {LOG_PLAIN, "###### END_FINDING_FREE_VNUMS ######"}},
+	{"FREE_BLOCK",          {LOG_OK,    "\t%u free vnums from %u in %s: %u~%u"}},
+	{"FREE_NONE",           {LOG_ERROR, "\tNo %u free vnums from %u in %s"}},
+	{"PIPELINE_BAD_CHECK",  {LOG_ERROR, "Invalid pipeline check: %s %s %s"}},
+};
+
+/**
+ * \brief
+ * Builtin references, a value of 0 (or an empty field) is no reference.
+ */
+const std::vector<SReferenceRule> REFERENCE_RULES =
+{
+	{MOB_PROTO_FILE_NAME,  "DROP_ITEM",         ITEM_PROTO_FILE_NAME,   "", {}},
+	{MOB_PROTO_FILE_NAME,  "RESURRECTION_VNUM", MOB_PROTO_FILE_NAME,    "", {}},
+	{MOB_PROTO_FILE_NAME,  "POLYMORPH_ITEM",    ITEM_PROTO_FILE_NAME,   "", {}},
+	{ITEM_PROTO_FILE_NAME, "REFINE",            ITEM_PROTO_FILE_NAME,   "", {}},
+	{ITEM_PROTO_FILE_NAME, "REFINESET",         REFINE_PROTO_FILE_NAME, "", {}},
+	{ITEM_PROTO_FILE_NAME, "VALUE0",            MOB_PROTO_FILE_NAME,    "ITEM_TYPE", {"ITEM_POLYMORPH"}},
+};
+
+/**
+ * \brief
+ * Builtin column rules.
+ */
+const std::vector<SColumnRule> COLUMN_RULES =
+{
+	{ITEM_PROTO_FILE_NAME, "GOLD",           ">=", "0",          "",            {}},
+	{ITEM_PROTO_FILE_NAME, "SHOP_BUY_PRICE", ">=", "0",          "",            {}},
+	{ITEM_PROTO_FILE_NAME, "LIMIT_VALUE0",   "==", "0",          "LIMIT_TYPE0", {"LIMIT_NONE"}},
+	{ITEM_PROTO_FILE_NAME, "LIMIT_VALUE1",   "==", "0",          "LIMIT_TYPE1", {"LIMIT_NONE"}},
+	{MOB_PROTO_FILE_NAME,  "LEVEL",          ">",  "0",          "",            {}},
+	{MOB_PROTO_FILE_NAME,  "DAMAGE_MIN",     "<=", "DAMAGE_MAX", "",            {}},
+	{MOB_PROTO_FILE_NAME,  "GOLD_MIN",       "<=", "GOLD_MAX",   "",            {}},
+	{MOB_PROTO_FILE_NAME,  "MAX_HP",         ">",  "0",          "",            {}},
+};
+
+/**
+ * \brief
+ * Columns holding a closed set of tokens. SUB_TYPE isn't checked, its tokens depend on ITEM_TYPE.
+ */
+const std::vector<STokenColumn> TOKEN_COLUMNS =
+{
+	{ITEM_PROTO_FILE_NAME, "ITEM_TYPE",   &ITEM_TYPE_TOKENS},
+	{ITEM_PROTO_FILE_NAME, "LIMIT_TYPE0", &LIMIT_TYPE_TOKENS},
+	{ITEM_PROTO_FILE_NAME, "LIMIT_TYPE1", &LIMIT_TYPE_TOKENS},
+	{ITEM_PROTO_FILE_NAME, "ADDON_TYPE0", &APPLY_TYPE_TOKENS},
+	{ITEM_PROTO_FILE_NAME, "ADDON_TYPE1", &APPLY_TYPE_TOKENS},
+	{ITEM_PROTO_FILE_NAME, "ADDON_TYPE2", &APPLY_TYPE_TOKENS},
+	{MOB_PROTO_FILE_NAME,  "RANK",        &MOB_RANK_TOKENS},
+	{MOB_PROTO_FILE_NAME,  "TYPE",        &MOB_TYPE_TOKENS},
+	{MOB_PROTO_FILE_NAME,  "BATTLE_TYPE", &BATTLE_TYPE_TOKENS},
+};
+
+/**
+ * \brief
+ * Edit distance up to which an unknown token is reported along with the token it's likely a misspelling of.
+ */
+static constexpr size_t TOKEN_SUGGEST_DISTANCE = 2;
+
+/**
+ * \brief
+ * Builtin pipeline, used when there's no pipeline file.
+ */
+const std::vector<SPipelineCheck> PIPELINE =
+{
+	{PIPELINE_DUPLICATE,  ITEM_PROTO_FILE_NAME, ""},
+	{PIPELINE_DUPLICATE,  ITEM_NAMES_FILE_NAME, ""},
+	{PIPELINE_DUPLICATE,  MOB_PROTO_FILE_NAME,  ""},
+	{PIPELINE_DUPLICATE,  MOB_NAMES_FILE_NAME,  ""},
+	{PIPELINE_COMPARE,    ITEM_PROTO_FILE_NAME, ITEM_NAMES_FILE_NAME},
+	{PIPELINE_COMPARE,    ITEM_NAMES_FILE_NAME, ITEM_PROTO_FILE_NAME},
+	{PIPELINE_COMPARE,    MOB_PROTO_FILE_NAME,  MOB_NAMES_FILE_NAME},
+	{PIPELINE_COMPARE,    MOB_NAMES_FILE_NAME,  MOB_PROTO_FILE_NAME},
+	{PIPELINE_REFERENCES, "", ""},
+	{PIPELINE_COLUMNS,    "", ""},
+	{PIPELINE_TOKENS,     "", ""},
+	{PIPELINE_RANGES,     "", ""},
+};
+
+/**
+ * \brief
+ * Name of each check in the pipeline file and the banners of its log section, the rule checks log their own.
+ */
+const std::tuple<EPipelineCheck, const char*, const char*, const char*> PIPELINE_SECTIONS[] =
+{
+	{PIPELINE_DUPLICATE,  "duplicate",  "DUPLICATE_START", "DUPLICATE_END"},
+	{PIPELINE_COMPARE,    "compare",    "COMPARE_START",   "COMPARE_END"},
+	{PIPELINE_REFERENCES, "references", nullptr,           nullptr},
+	{PIPELINE_COLUMNS,    "columns",    nullptr,           nullptr},
+	{PIPELINE_TOKENS,     "tokens",     nullptr,           nullptr},
+	{PIPELINE_RANGES,     "ranges",     "RANGE_START",     "RANGE_END"},
+};
+
+/**
+ * \brief
+ * Builtin clone rules, rows differing only in their key and name are clones.
+ */
+const std::vector<SCloneRule> CLONE_RULES =
+{
+	{ITEM_PROTO_FILE_NAME, {"ITEM_VNUM~RANGE", "ITEM_NAME(K)"}},
+	{MOB_PROTO_FILE_NAME,  {"VNUM", "NAME"}},
+};
+
+/**
+ * \brief
+ * Jaccard similarity of the name n-grams from which two names are reported as near duplicates.
+ */
+static constexpr double SIMILAR_NAME_THRESHOLD = 0.8;
+
+/**
+ * \brief
+ * Daemon limits, a request line and the buffer sent along with a diff.
+ */
+static constexpr size_t DAEMON_FILE_COUNT = 4;
+static constexpr size_t NO_DAEMON_FILE = SIZE_MAX;
+static constexpr uint32_t MAX_ACCEPT_FAILURES = 100;
+static constexpr size_t MAX_REQUEST_LINE = 4096;
+static constexpr size_t MAX_DIFF_BUFFER = 1 << 28;
+
+/**
+ * \brief
+ * While set, the records logged by the current thread are collected here instead of going to the log sink.
+ */
+thread_local std::vector<SLogRecord>* t_pLogCapture = nullptr;
+
+/**
+ * \brief
+ * Collect the records logged by the current thread during the lifetime of the object.
+ * The daemon answers with them, the pipeline holds them back until the checks before were logged.
+ */
+struct SLogCapture
+{
+	std::vector<SLogRecord> records;
+	std::vector<SLogRecord>* previous;
+
+	SLogCapture() : previous(t_pLogCapture)
+	{
+		t_pLogCapture = &records;
+	}
+
+	~SLogCapture()
+	{
+		t_pLogCapture = previous;
+	}
+
+	auto ToJson() const -> std::string
+	{
+		std::string stJson;
+		for (const auto & record : records)
+			stJson += cJsonLogWriter::Format(record);
+		return stJson;
+	}
+};
+
+/**
+ * \brief
+ * Called the constructor/destructor method.
+ * The files aren't loaded yet: run loads the ones its checks read, load_files the ones still missing.
+ * The log has no writer until add_log_writer is called.
+ * \param: stRootPath: string, directory of the proto files
+ * \param: bSnapshot: bool, load unchanged files from their binary snapshot and write one after parsing
+ */
+CProtoChecker::CProtoChecker(const std::string& stRootPath, bool bSnapshot) : m_stRootPath(stRootPath), m_bSnapshot(bSnapshot)
+{
+	m_ItemProtoFile = std::make_tuple(ITEM_PROTO_FILE_NAME, std::vector<std::string>(), false, std::vector<std::tuple<uint32_t, uint32_t>>(), std::vector<uint32_t>());
+	m_ItemNamesFile = std::make_tuple(ITEM_NAMES_FILE_NAME, std::vector<std::string>(), false, std::vector<std::tuple<uint32_t, uint32_t>>(), std::vector<uint32_t>());
+	m_MobProtoFile = std::make_tuple(MOB_PROTO_FILE_NAME, std::vector<std::string>(), false, std::vector<std::tuple<uint32_t, uint32_t>>(), std::vector<uint32_t>());
+	m_MobNamesFile = std::make_tuple(MOB_NAMES_FILE_NAME, std::vector<std::string>(), false, std::vector<std::tuple<uint32_t, uint32_t>>(), std::vector<uint32_t>());
+	m_vecFileLoaded.assign(4, false);
+}
+
+CProtoChecker::~CProtoChecker()
+{
+}
+
+/**
+ * \brief
+ * Load the files of the checker which aren't loaded yet, concurrently on the thread pool.
+ */
+auto CProtoChecker::load_files() -> void
+{
+	auto & pool = CThreadPool::Instance();
+	std::vector<std::future<void>> vecFuture;
+	for (size_t i = 0; i < m_vecFileLoaded.size(); ++i)
+	{
+		if (m_vecFileLoaded[i])
+			continue;
+
+		vecFuture.emplace_back(pool.Submit([this, i]
+		{
+			auto & file = get_file(i);
+			file = load_file(std::get<NAME>(file));
+		}));
+	}
+
+	for (auto & future : vecFuture)
+		pool.Wait(future);
+
+	m_vecFileLoaded.assign(m_vecFileLoaded.size(), true);
+}
+
+/**
+ * \brief
+ * Load the keys of a file from its snapshot, when snapshots are used and it's up to date with the file.
+ * \param: stFileName: string
+ * \param: file: tuple, set when the snapshot is read
+ * \return: bool
+ */
+auto CProtoChecker::load_snapshot(const std::string& stFileName, TFileTuple& file) const -> bool
+{
+	if (!m_bSnapshot)
+		return false;
+
+	const auto & stFilePath = m_stRootPath + stFileName;
+	cProtoSnapshot snapshot;
+	if (!snapshot.Open(stFilePath))
+		return false;
+
+	cProfileScope profile("load_file");
+	std::vector<std::string> vecFileData;
+	std::vector<std::tuple<uint32_t, uint32_t>> vecRangeVnum;
+	std::vector<uint32_t> vecFileLine;
+
+	const auto iRowCount = snapshot.GetRowCount();
+	vecFileData.reserve(iRowCount);
+	vecFileLine.reserve(iRowCount);
+
+	for (size_t row = 0; row < iRowCount; ++row)
+	{
+		vecFileData.emplace_back(snapshot.GetVnum(row));
+		vecFileLine.emplace_back(snapshot.GetLine(row));
+	}
+
+	for (size_t i = 0; i < snapshot.GetRangeCount(); ++i)
+		vecRangeVnum.emplace_back(snapshot.GetRange(i));
+
+	profile.AddRows(iRowCount);
+	if (profile.IsActive())
+		profile.AddBytes(cProtoSnapshot::GetSource(stFilePath).size);
+
+	file = std::make_tuple(stFileName, std::move(vecFileData), true, std::move(vecRangeVnum), std::move(vecFileLine));
+	return true;
+}
+
+/**
+ * \brief
+ * Parse the rows of a file, only the key column and the asked columns are kept.
+ * \param: stFileName: string
+ * \param: vecColumn: vector, header names of the columns kept besides the key column, missing ones are left out
+ * \return: cCsvMappedFile, nullptr if the file can't be read
+ */
+auto CProtoChecker::load_table(const std::string& stFileName, const std::vector<std::string>& vecColumn) const -> std::shared_ptr<cCsvMappedFile>
+{
+	// The loader skips every field which isn't masked.
+	cCsvColumnMask mask{ 0 };
+	for (const auto & stColumn : vecColumn)
+		mask.AddName(stColumn.c_str());
+
+	auto table = std::make_shared<cCsvMappedFile>();
+	if (!table->Load((m_stRootPath + stFileName).c_str(), DELIMITER_TAB, '"', mask))
+		return nullptr;
+
+	return table;
+}
+
+/**
+ * \brief
+ * Load a specific file and save the data into a tuple.
+ * An unchanged file is read from its snapshot, otherwise it's parsed and the snapshot is rewritten.
+ * \param: stFileName: string
+ * \param: vecColumn: vector, header names of the columns kept in the table besides the key column, missing ones are left out
+ * \param: pTable: cCsvMappedFile, when set the file is always parsed and its rows are kept there (nullptr if it can't be read)
+ * \return: tuple
+ */
+auto CProtoChecker::load_file(const std::string& stFileName, const std::vector<std::string>& vecColumn, std::shared_ptr<const cCsvMappedFile>* pTable) const -> TFileTuple
+{
+	TFileTuple file;
+	if (!pTable && load_snapshot(stFileName, file))
+		return file;
+
+	cProfileScope profile("load_file");
+	std::vector<std::string> vecFileData;
+	std::vector<std::tuple<uint32_t, uint32_t>> vecRangeVnum;
+	std::vector<uint32_t> vecFileLine;
+
+	std::string stFilePath(m_stRootPath);
+	stFilePath.append(stFileName);
+
+	// Taken before parsing, a write during the parse leaves the snapshot stale instead of wrong.
+	const auto source = m_bSnapshot ? cProtoSnapshot::GetSource(stFilePath) : SSnapshotSource();
+
+	const auto table = load_table(stFileName, vecColumn);
+	if (table)
+	{
+		const auto iRowCount = table->GetRowCount();
+		vecFileData.reserve(iRowCount);
+		vecFileLine.reserve(iRowCount);
+
+		for (size_t row = 1; row < iRowCount; ++row)
+		{
+			// A malformed range (`100~`, `100~abc`) is kept as a key but isn't a range.
+			const auto stItemVnum = table->GetField(row, 0);
+			const auto iRangePos = stItemVnum.find(DELIMITER_RANGE);
+			uint32_t first, last;
+			if (iRangePos != std::string_view::npos && parse_vnum(stItemVnum.substr(0, iRangePos), first) && parse_vnum(stItemVnum.substr(iRangePos + 1), last))
+				vecRangeVnum.emplace_back(first, last);
+
+			vecFileData.emplace_back(stItemVnum);
+			vecFileLine.emplace_back(table->GetLine(row));
+		}
+
+		if (m_bSnapshot)
+			cProtoSnapshot::Write(stFilePath, source, table->GetData(), vecFileData, vecFileLine, vecRangeVnum);
+
+		profile.AddRows(vecFileData.size());
+		profile.AddBytes(table->GetData().size());
+	}
+
+	if (pTable)
+		*pTable = table;
+
+	return std::make_tuple(stFileName, vecFileData, table != nullptr, vecRangeVnum, vecFileLine);
+}
+
+/**
+ * \brief
+ * Find a file among the loaded ones by its name.
+ * \param: vecFile: vector
+ * \param: stFileName: string
+ * \return: SLoadedFile, nullptr if it wasn't loaded
+ */
+auto CProtoChecker::find_loaded(const std::vector<const SLoadedFile*>& vecFile, const std::string& stFileName) -> const SLoadedFile*
+{
+	const auto & it = std::find_if(vecFile.begin(), vecFile.end(), [&stFileName](const SLoadedFile* file) { return file->name == stFileName; });
+	return it == vecFile.end() ? nullptr : *it;
+}
+
+/**
+ * \brief
+ * Find columns in the header row (the first row) of a loaded file by their (case insensitive) name.
+ * \param: file: cCsvMappedFile
+ * \param: vecColumn: vector, header names
+ * \return: vector, index of each column, -1 if it's not in the header
+ */
+auto CProtoChecker::find_columns(const cCsvMappedFile& file, const std::vector<std::string>& vecColumn) -> std::vector<int>
+{
+	const auto IsSameName = [](std::string_view left, const std::string& right)
+	{
+		return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(), [](char a, char b) { return tolower(static_cast<unsigned char>(a)) == tolower(static_cast<unsigned char>(b)); });
+	};
+
+	std::vector<int> vecIndex(vecColumn.size(), -1);
+	const auto iColCount = file.GetRowCount() ? file.GetColCount(0) : 0;
+	for (size_t i = 0; i < vecColumn.size(); ++i)
+	{
+		for (size_t col = 0; col < iColCount && vecIndex[i] < 0; ++col)
+		{
+			if (IsSameName(file.GetField(0, col), vecColumn[i]))
+				vecIndex[i] = static_cast<int>(col);
+		}
+	}
+
+	return vecIndex;
+}
+
+/**
+ * \brief
+ * The builtin references followed by the ones of the optional rules file.
+ * The rules file is tab separated with a header row: FILE, COLUMN, TARGET, WHEN_COLUMN, WHEN_VALUES (comma separated),
+ * the last two columns may be empty.
+ * \return: vector
+ */
+auto CProtoChecker::load_reference_rules() const -> std::vector<SReferenceRule>
+{
+	auto vecRule = REFERENCE_RULES;
+
+	cCsvTable csv_reader;
+	const auto & stFilePath = m_stRootPath + REFERENCE_RULES_FILE_NAME;
+	if (!csv_reader.LoadMapped(stFilePath.c_str(), DELIMITER_TAB, '"'))
+		return vecRule;
+
+	csv_reader.Next();
+	while (csv_reader.Next())
+	{
+		const auto iColCount = csv_reader.ColCount();
+		if (iColCount < 3 || csv_reader.AsStringViewByIndex(0).empty() || csv_reader.AsStringViewByIndex(0)[0] == '#')
+			continue;
+
+		SReferenceRule rule;
+		rule.file = csv_reader.AsStringByIndex(0);
+		rule.column = csv_reader.AsStringByIndex(1);
+		rule.target = csv_reader.AsStringByIndex(2);
+
+		if (iColCount > 4 && !csv_reader.AsStringViewByIndex(3).empty())
+		{
+			rule.whenColumn = csv_reader.AsStringByIndex(3);
+			rule.whenValues = split_range(csv_reader.AsStringByIndex(4), ",");
+		}
+
+		vecRule.emplace_back(std::move(rule));
+	}
+
+	return vecRule;
+}
+
+/**
+ * \brief
+ * Check that every reference of the rules points at an existing key.
+ * The files are loaded by the caller, once for every check which reads them: a referencing file with the columns
+ * its rules name, a target with its vnum index. Each reference is resolved with a single lookup.
+ * Findings point at the row, the message names the column.
+ * \param: vecRule: vector
+ * \param: vecFile: vector, the files of the rules and their targets
+ */
+auto CProtoChecker::check_references(const std::vector<SReferenceRule>& vecRule, const std::vector<const SLoadedFile*>& vecFile) -> void
+{
+	cProfileScope profile("check_references");
+
+	write_log("REFERENCE_START");
+	for (const auto & rule : vecRule)
+	{
+		const auto source = find_loaded(vecFile, rule.file);
+		if (!source || !source->table)
+			continue;
+
+		write_log("REFERENCE_RULE", rule.file.c_str(), rule.column.c_str(), rule.target.c_str());
+
+		const auto target = find_loaded(vecFile, rule.target);
+		if (!target || !target->index || !std::get<EXISTS>(*target->keys))
+		{
+			write_log("REFERENCE_SKIPPED", rule.target.c_str());
+			continue;
+		}
+
+		const auto & table = *source->table;
+		const auto & vecIndex = find_columns(table, { rule.column, rule.whenColumn });
+		const auto & stMissingColumn = vecIndex[0] < 0 ? rule.column : (!rule.whenColumn.empty() && vecIndex[1] < 0) ? rule.whenColumn : std::string();
+		if (!stMissingColumn.empty())
+		{
+			write_log("REFERENCE_SKIPPED", stMissingColumn.c_str());
+			continue;
+		}
+
+		const auto GetField = [&table](size_t row, int col)
+		{
+			return static_cast<size_t>(col) < table.GetColCount(row) ? table.GetField(row, static_cast<size_t>(col)) : std::string_view();
+		};
+
+		const auto & stFilePath = m_stRootPath + rule.file;
+		uint32_t iBrokenCount = 0;
+
+		// The header row is skipped.
+		for (size_t row = 1; row < table.GetRowCount(); ++row)
+		{
+			const auto stValue = GetField(row, vecIndex[0]);
+			if (stValue.empty() || stValue == "0")
+				continue;
+
+			if (!rule.whenColumn.empty())
+			{
+				const auto stWhen = GetField(row, vecIndex[1]);
+				if (std::find(rule.whenValues.begin(), rule.whenValues.end(), stWhen) == rule.whenValues.end())
+					continue;
+			}
+
+			uint32_t vnum;
+			if (parse_vnum(stValue, vnum) && target->index->coverage.Contains(vnum))
+				continue;
+
+			const auto line = table.GetLine(row);
+			write_finding("REFERENCE_BROKEN", stFilePath.c_str(), line, line, rule.column.c_str(), std::string(stValue).c_str(), rule.target.c_str());
+			++iBrokenCount;
+		}
+
+		write_log(iBrokenCount == 0 ? "FILE_OK" : "FILE_TOTAL_LINES", iBrokenCount);
+	}
+	write_log("REFERENCE_END");
+}
+
+/**
+ * \brief
+ * The builtin column rules followed by the ones of the optional rules file.
+ * The rules file is tab separated with a header row: FILE, COLUMN, OP, OPERAND, WHEN_COLUMN, WHEN_VALUES (comma separated),
+ * the last two columns may be empty. See SColumnRule for the operators.
+ * \return: vector
+ */
+auto CProtoChecker::load_column_rules() const -> std::vector<SColumnRule>
+{
+	auto vecRule = COLUMN_RULES;
+
+	cCsvTable csv_reader;
+	const auto & stFilePath = m_stRootPath + COLUMN_RULES_FILE_NAME;
+	if (!csv_reader.LoadMapped(stFilePath.c_str(), DELIMITER_TAB, '"'))
+		return vecRule;
+
+	csv_reader.Next();
+	while (csv_reader.Next())
+	{
+		const auto iColCount = csv_reader.ColCount();
+		if (iColCount < 4 || csv_reader.AsStringViewByIndex(0).empty() || csv_reader.AsStringViewByIndex(0)[0] == '#')
+			continue;
+
+		SColumnRule rule;
+		rule.file = csv_reader.AsStringByIndex(0);
+		rule.column = csv_reader.AsStringByIndex(1);
+		rule.op = csv_reader.AsStringByIndex(2);
+		rule.operand = csv_reader.AsStringByIndex(3);
+
+		if (iColCount > 5 && !csv_reader.AsStringViewByIndex(4).empty())
+		{
+			rule.whenColumn = csv_reader.AsStringByIndex(4);
+			rule.whenValues = split_range(csv_reader.AsStringByIndex(5), ",");
+		}
+
+		vecRule.emplace_back(std::move(rule));
+	}
+
+	return vecRule;
+}
+
+/**
+ * \brief
+ * Check the column rules of every file.
+ * The files are loaded by the caller with the columns the rules name, each one is turned into a column table of those
+ * columns, the rules are compiled against it and validated in a single batched pass.
+ * Findings point at the row, the message shows the values involved.
+ * \param: vecRule: vector
+ * \param: vecFile: vector, the files of the rules
+ */
+auto CProtoChecker::check_columns(const std::vector<SColumnRule>& vecRule, const std::vector<const SLoadedFile*>& vecFile) -> void
+{
+	cProfileScope profile("check_columns");
+
+	// Rules of each file, in the order of the rules.
+	std::vector<std::pair<std::string, std::vector<SColumnRule>>> vecSource;
+	for (const auto & rule : vecRule)
+	{
+		auto it = std::find_if(vecSource.begin(), vecSource.end(), [&rule](const auto & source) { return source.first == rule.file; });
+		if (it == vecSource.end())
+			it = vecSource.insert(vecSource.end(), { rule.file, {} });
+
+		it->second.push_back(rule);
+	}
+
+	write_log("COLUMN_START");
+	for (size_t i = 0; i < vecSource.size(); ++i)
+	{
+		const auto source = find_loaded(vecFile, vecSource[i].first);
+		if (!source || !source->table)
+			continue;
+
+		const auto & vecFileRule = vecSource[i].second;
+		std::vector<std::string> vecColumn;
+		for (const auto & rule : vecFileRule)
+			vecColumn.insert(vecColumn.end(), { rule.column, rule.operand, rule.whenColumn });
+
+		cCsvColumnMask mask{ 0 };
+		for (const auto index : find_columns(*source->table, vecColumn))
+		{
+			if (index >= 0)
+				mask.AddColumn(static_cast<size_t>(index));
+		}
+
+		cCsvColumnTable table;
+		table.Build(*source->table, mask);
+
+		CColumnRuleSet ruleSet;
+		std::vector<std::vector<uint32_t>> vecBroken;
+		{
+			cProfileScope validate("validate_columns");
+			validate.AddRows(table.GetRowCount());
+			ruleSet.Compile(table, vecFileRule);
+			vecBroken = ruleSet.Validate();
+		}
+		profile.AddRows(table.GetRowCount());
+
+		const auto & stFilePath = m_stRootPath + vecSource[i].first;
+		for (size_t rule = 0; rule < vecFileRule.size(); ++rule)
+		{
+			const auto & current = vecFileRule[rule];
+			auto stRule = current.column + " " + current.op + " " + current.operand;
+			if (!current.whenColumn.empty())
+			{
+				stRule += " when " + current.whenColumn + " in ";
+				for (size_t value = 0; value < current.whenValues.size(); ++value)
+					stRule += (value ? "," : "") + current.whenValues[value];
+			}
+
+			write_log("COLUMN_RULE", current.file.c_str(), stRule.c_str());
+			if (!ruleSet.GetError(rule).empty())
+			{
+				write_log("COLUMN_SKIPPED", ruleSet.GetError(rule).c_str());
+				continue;
+			}
+
+			// Values of the columns the rule names, the operand only when it's a column.
+			std::vector<std::pair<std::string, int>> vecShown;
+			for (const auto & stColumn : { current.column, current.operand, current.whenColumn })
+			{
+				const auto col = stColumn.empty() ? -1 : table.FindColumn(stColumn);
+				if (col >= 0 && std::none_of(vecShown.begin(), vecShown.end(), [col](const auto & shown) { return shown.second == col; }))
+					vecShown.emplace_back(stColumn, col);
+			}
+
+			for (const auto row : vecBroken[rule])
+			{
+				std::string stValues;
+				for (const auto & shown : vecShown)
+					stValues += (stValues.empty() ? "" : ", ") + shown.first + ": " + table.AsString(row, static_cast<size_t>(shown.second));
+
+				write_finding("COLUMN_BROKEN", stFilePath.c_str(), table.GetLine(row), table.GetLine(row), stValues.c_str());
+			}
+
+			write_log(vecBroken[rule].empty() ? "FILE_OK" : "FILE_TOTAL_LINES", static_cast<uint32_t>(vecBroken[rule].size()));
+		}
+	}
+	write_log("COLUMN_END");
+}
+
+/**
+ * \brief
+ * Check that every value of the token columns is a token of their dictionary.
+ * The files are loaded by the caller with their token columns, each field is looked up in the perfect hash of its column,
+ * in blocks of rows spread over the thread pool. Findings point at the line and the column of the field,
+ * a token close to a known one is reported with it.
+ * \param: vecColumn: vector
+ * \param: vecFile: vector, the files of the columns
+ */
+auto CProtoChecker::check_tokens(const std::vector<STokenColumn>& vecColumn, const std::vector<const SLoadedFile*>& vecFile) -> void
+{
+	static constexpr size_t BLOCK_ROW_COUNT = 4096;
+
+	struct STokenFile
+	{
+		std::string name;
+		std::vector<const STokenColumn*> columns;
+	};
+
+	cProfileScope profile("check_tokens");
+
+	// Token columns of each file, in the order of the columns.
+	std::vector<STokenFile> vecTokenFile;
+	for (const auto & column : vecColumn)
+	{
+		auto it = std::find_if(vecTokenFile.begin(), vecTokenFile.end(), [&column](const auto & file) { return file.name == column.file; });
+		if (it == vecTokenFile.end())
+			it = vecTokenFile.insert(vecTokenFile.end(), { column.file, {} });
+
+		it->columns.push_back(&column);
+	}
+
+	auto & pool = CThreadPool::Instance();
+	write_log("TOKEN_START");
+	for (const auto & file : vecTokenFile)
+	{
+		const auto loaded = find_loaded(vecFile, file.name);
+		if (!loaded || !loaded->table)
+			continue;
+
+		std::vector<std::string> vecName;
+		for (const auto column : file.columns)
+			vecName.push_back(column->column);
+
+		// Rows of each column whose field isn't a token, the header row is skipped.
+		const auto & csv = *loaded->table;
+		const auto & vecIndex = find_columns(csv, vecName);
+		const auto rowCount = csv.GetRowCount();
+		const auto blockCount = (rowCount + BLOCK_ROW_COUNT - 1) / BLOCK_ROW_COUNT;
+		std::vector<std::vector<std::vector<uint32_t>>> vecBlock(blockCount, std::vector<std::vector<uint32_t>>(file.columns.size()));
+		pool.ParallelFor(blockCount, [&](size_t block)
+		{
+			const auto begin = std::max<size_t>(block * BLOCK_ROW_COUNT, 1);
+			const auto end = std::min(rowCount, (block + 1) * BLOCK_ROW_COUNT);
+			for (size_t column = 0; column < file.columns.size(); ++column)
+			{
+				const auto col = vecIndex[column];
+				if (col < 0)
+					continue;
+
+				const auto & dictionary = *file.columns[column]->dictionary;
+				auto & vecRow = vecBlock[block][column];
+				for (auto row = begin; row < end; ++row)
+				{
+					const auto field = static_cast<size_t>(col) < csv.GetColCount(row) ? csv.GetField(row, static_cast<size_t>(col)) : std::string_view();
+					if (dictionary.Find(field) < 0)
+						vecRow.push_back(static_cast<uint32_t>(row));
+				}
+			}
+		});
+		profile.AddRows(rowCount ? rowCount - 1 : 0);
+
+		const auto & stFilePath = m_stRootPath + file.name;
+		for (size_t column = 0; column < file.columns.size(); ++column)
+		{
+			const auto & current = *file.columns[column];
+			write_log("TOKEN_COLUMN", current.file.c_str(), current.column.c_str());
+
+			const auto col = vecIndex[column];
+			if (col < 0)
+			{
+				write_log("COLUMN_SKIPPED", (current.column + " not found").c_str());
+				continue;
+			}
+
+			uint32_t iUnknownCount = 0;
+			for (const auto & vecRow : vecBlock)
+			{
+				for (const auto row : vecRow[column])
+				{
+					const auto & stToken = std::string(static_cast<size_t>(col) < csv.GetColCount(row) ? csv.GetField(row, static_cast<size_t>(col)) : std::string_view());
+					const auto closest = current.dictionary->FindClosest(stToken, TOKEN_SUGGEST_DISTANCE);
+					const auto line = csv.GetLine(row);
+					const auto iColumn = static_cast<uint32_t>(col + 1);
+					if (closest.empty())
+						write_finding("TOKEN_UNKNOWN", stFilePath.c_str(), line, line, iColumn, stToken.c_str());
+					else
+						write_finding("TOKEN_MISSPELLED", stFilePath.c_str(), line, line, iColumn, stToken.c_str(), std::string(closest).c_str());
+					++iUnknownCount;
+				}
+			}
+
+			write_log(iUnknownCount == 0 ? "FILE_OK" : "FILE_TOTAL_LINES", iUnknownCount);
+		}
+	}
+	write_log("TOKEN_END");
+}
+
+/**
+ * \brief
+ * Read a specific file and find the duplicates lines.
+ * Single pass over the rows, keyed on the integer vnum (or on the raw string when it isn't a plain number).
+ * Only keys seen more than once get a list of their lines, every other key costs one hash entry.
+ * \param: file: tuple
+ */
+auto CProtoChecker::find_duplicate(const TFileTuple& file) -> void
+{
+	if (!std::get<EXISTS>(file))
+		return;
+
+	const auto & stFileName = std::get<NAME>(file);
+	const auto & vecFileData = std::get<DATA>(file);
+	const auto & vecFileLine = std::get<LINE>(file);
+
+	cProfileScope profile("find_duplicate");
+	profile.AddRows(vecFileData.size());
+
+	write_log("FILE_NAME", stFileName.c_str());
+
+	struct SOccurrence
+	{
+		uint32_t firstLine;
+		uint32_t duplicateIndex;
+	};
+
+	static constexpr auto NO_DUPLICATE = UINT32_MAX;
+
+	std::unordered_map<uint32_t, SOccurrence> mapVnumOccurrence;
+	std::unordered_map<std::string_view, SOccurrence> mapStringOccurrence;
+	std::vector<std::vector<uint32_t>> vecDuplicateLines;
+	mapVnumOccurrence.reserve(vecFileData.size());
+
+	const auto AddOccurrence = [&vecDuplicateLines](SOccurrence & occurrence, const bool bInserted, const uint32_t lineIndex)
+	{
+		if (bInserted)
+			return;
+
+		if (occurrence.duplicateIndex == NO_DUPLICATE)
+		{
+			occurrence.duplicateIndex = static_cast<uint32_t>(vecDuplicateLines.size());
+			vecDuplicateLines.push_back({ occurrence.firstLine });
+		}
+
+		vecDuplicateLines[occurrence.duplicateIndex].emplace_back(lineIndex);
+	};
+
+	for (size_t i = 0; i < vecFileData.size(); ++i)
+	{
+		const auto lineIndex = vecFileLine[i];
+
+		uint32_t itemVnum;
+		if (parse_vnum(vecFileData[i], itemVnum))
+		{
+			const auto & it = mapVnumOccurrence.try_emplace(itemVnum, SOccurrence{ lineIndex, NO_DUPLICATE });
+			AddOccurrence(it.first->second, it.second, lineIndex);
+		}
+		else
+		{
+			const auto & it = mapStringOccurrence.try_emplace(vecFileData[i], SOccurrence{ lineIndex, NO_DUPLICATE });
+			AddOccurrence(it.first->second, it.second, lineIndex);
+		}
+	}
+
+	std::vector<std::tuple<uint32_t, std::string, uint32_t>> vecDuplicate;
+	for (const auto & it : mapVnumOccurrence)
+	{
+		if (it.second.duplicateIndex != NO_DUPLICATE)
+			vecDuplicate.emplace_back(it.first, std::to_string(it.first), it.second.duplicateIndex);
+	}
+	for (const auto & it : mapStringOccurrence)
+	{
+		if (it.second.duplicateIndex != NO_DUPLICATE)
+			vecDuplicate.emplace_back(UINT32_MAX, std::string(it.first), it.second.duplicateIndex);
+	}
+
+	std::sort(vecDuplicate.begin(), vecDuplicate.end());
+
+	// The finding points at the first repeated row, the message lists all of them.
+	const auto & stFilePath = m_stRootPath + stFileName;
+	for (const auto & it : vecDuplicate)
+	{
+		const auto & vecLines = vecDuplicateLines[std::get<2>(it)];
+
+		std::string stLines;
+		for (const auto lineIndex : vecLines)
+		{
+			if (!stLines.empty())
+				stLines.append(", ");
+			stLines.append(std::to_string(lineIndex));
+		}
+
+		write_finding("FILE_DUPLICATE_LINE", stFilePath.c_str(), vecLines[1], std::get<1>(it).c_str(), stLines.c_str());
+	}
+
+	write_log(vecDuplicate.empty() ? "FILE_OK" : "FILE_TOTAL_LINES", static_cast<uint32_t>(vecDuplicate.size()));
+}
+
+/**
+ * \brief
+ * Build the vnum index of a loaded file.
+ * \param: file: tuple
+ * \return: SVnumIndex
+ */
+auto CProtoChecker::make_vnum_index(const TFileTuple& file) -> SVnumIndex
+{
+	SVnumIndex index;
+
+	for (const auto & stItemVnum : std::get<DATA>(file))
+	{
+		const auto iRangePos = stItemVnum.find(DELIMITER_RANGE);
+
+		uint32_t itemVnum;
+		if (!parse_vnum(std::string_view(stItemVnum).substr(0, iRangePos), itemVnum))
+		{
+			index.other.emplace_back(stItemVnum);
+			continue;
+		}
+
+		index.keys.Add(itemVnum);
+		if (iRangePos == std::string::npos)
+			index.coverage.Add(itemVnum);
+	}
+
+	for (const auto & range : std::get<RANGE>(file))
+		index.coverage.AddRange(std::get<0>(range), std::get<1>(range));
+
+	index.keys.Optimize();
+	index.coverage.Optimize();
+
+	std::sort(index.other.begin(), index.other.end());
+	index.other.erase(std::unique(index.other.begin(), index.other.end()), index.other.end());
+	return index;
+}
+
+/**
+ * \brief
+ * Find the keys of the examined index which the searched index doesn't cover.
+ * A vnum is missing when it isn't covered by the searched file, either as a single vnum or inside one of its `~` ranges,
+ * so the whole comparison is a single AND-NOT between the two vnum sets.
+ * \param: indexExamine: SVnumIndex
+ * \param: indexSearch: SVnumIndex
+ * \return: SVnumDifference
+ */
+auto CProtoChecker::find_difference(const SVnumIndex& indexExamine, const SVnumIndex& indexSearch) -> SVnumDifference
+{
+	SVnumDifference difference;
+	difference.vnums = indexExamine.keys.AndNot(indexSearch.coverage);
+	std::set_difference(indexExamine.other.begin(), indexExamine.other.end(), indexSearch.other.begin(), indexSearch.other.end(), std::back_inserter(difference.other));
+	return difference;
+}
+
+/**
+ * \brief
+ * Compare two files and find the differences between them.
+ * \param: fileExamine: tuple
+ * \param: fileSearch: tuple
+ */
+auto CProtoChecker::compare(const TFileTuple& fileExamine, const TFileTuple& fileSearch) -> void
+{
+	if (!std::get<EXISTS>(fileExamine) || !std::get<EXISTS>(fileSearch))
+		return;
+
+	compare(fileExamine, make_vnum_index(fileExamine), fileSearch, make_vnum_index(fileSearch));
+}
+
+/**
+ * \brief
+ * Compare two files whose vnum indexes are built already.
+ * \param: fileExamine: tuple
+ * \param: indexExamine: SVnumIndex
+ * \param: fileSearch: tuple
+ * \param: indexSearch: SVnumIndex
+ */
+auto CProtoChecker::compare(const TFileTuple& fileExamine, const SVnumIndex& indexExamine, const TFileTuple& fileSearch, const SVnumIndex& indexSearch) -> void
+{
+	if (!std::get<EXISTS>(fileExamine) || !std::get<EXISTS>(fileSearch))
+		return;
+
+	cProfileScope profile("compare");
+	profile.AddRows(std::get<DATA>(fileExamine).size() + std::get<DATA>(fileSearch).size());
+	report_difference(fileExamine, fileSearch, find_difference(indexExamine, indexSearch));
+}
+
+/**
+ * \brief
+ * Log the keys of the examined file which are missing in the searched file.
+ * \param: fileExamine: tuple
+ * \param: fileSearch: tuple
+ * \param: difference: SVnumDifference, from find_difference
+ */
+auto CProtoChecker::report_difference(const TFileTuple& fileExamine, const TFileTuple& fileSearch, const SVnumDifference& difference) -> void
+{
+	if (!std::get<EXISTS>(fileExamine) || !std::get<EXISTS>(fileSearch))
+		return;
+
+	const auto & setFileDifference = difference.vnums;
+	const auto & vecOtherDifference = difference.other;
+
+	write_log("FILE_NAME", std::get<EFile::NAME>(fileSearch).c_str());
+
+	const auto iDifferenceCount = static_cast<size_t>(setFileDifference.Cardinality()) + vecOtherDifference.size();
+	if (iDifferenceCount == 0)
+	{
+		write_log("FILE_OK");
+		return;
+	}
+
+	// Every finding points at the row of the examined file which holds the missing key.
+	const auto & stExaminePath = m_stRootPath + std::get<NAME>(fileExamine);
+	const auto & vecFileData = std::get<DATA>(fileExamine);
+	const auto & vecFileLine = std::get<LINE>(fileExamine);
+	std::unordered_map<uint32_t, uint32_t> mapVnumLine;
+	std::unordered_map<std::string_view, uint32_t> mapOtherLine;
+
+	for (size_t i = 0; i < vecFileData.size(); ++i)
+	{
+		uint32_t itemVnum;
+		if (!parse_vnum(std::string_view(vecFileData[i]).substr(0, vecFileData[i].find(DELIMITER_RANGE)), itemVnum))
+			mapOtherLine.try_emplace(vecFileData[i], vecFileLine[i]);
+		else if (setFileDifference.Contains(itemVnum))
+			mapVnumLine.try_emplace(itemVnum, vecFileLine[i]);
+	}
+
+	setFileDifference.ForEach([&](uint32_t itemVnum)
+	{
+		write_finding("FILE_COMPARING_LINE", stExaminePath.c_str(), mapVnumLine[itemVnum], std::to_string(itemVnum).c_str());
+	});
+
+	for (const auto & stItemVnum : vecOtherDifference)
+		write_finding("FILE_COMPARING_LINE", stExaminePath.c_str(), mapOtherLine[stItemVnum], stItemVnum.c_str());
+
+	write_log("FILE_TOTAL_LINES", static_cast<uint32_t>(iDifferenceCount));
+}
+
+/**
+ * \brief
+ * Files of the checker in a fixed order, used as indices by the watch mode.
+ * \param: index: size_t
+ * \return: tuple
+ */
+auto CProtoChecker::get_file(size_t index) -> TFileTuple&
+{
+	TFileTuple* const arrFile[] = { &m_ItemProtoFile, &m_ItemNamesFile, &m_MobProtoFile, &m_MobNamesFile };
+	return *arrFile[index];
+}
+
+/**
+ * \brief
+ * Add or remove the rows [begin, end) of a file to its watch state and remember the keys they touch.
+ * Keys are derived exactly like find_duplicate and make_vnum_index do, so the state always matches a full check.
+ * \param: state: SFileState
+ * \param: file: tuple
+ * \param: begin: size_t
+ * \param: end: size_t
+ * \param: bAdd: bool
+ * \param: touched: STouchedKeys
+ */
+auto CProtoChecker::update_file_state(SFileState& state, const TFileTuple& file, size_t begin, size_t end, bool bAdd, STouchedKeys& touched) -> void
+{
+	const auto Update = [bAdd](auto & map, const auto & key)
+	{
+		auto & count = map[key];
+		bAdd ? ++count : --count;
+		if (count == 0)
+			map.erase(key);
+	};
+
+	const auto & vecFileData = std::get<DATA>(file);
+	for (auto i = begin; i < end; ++i)
+	{
+		const auto & stItemVnum = vecFileData[i];
+
+		uint32_t itemVnum;
+		const auto & duplicateKey = parse_vnum(stItemVnum, itemVnum) ? std::make_pair(itemVnum, std::string()) : std::make_pair(UINT32_MAX, stItemVnum);
+		const auto & it = state.duplicates.find(duplicateKey);
+		touched.duplicates.try_emplace(duplicateKey, it != state.duplicates.end() ? it->second : 0);
+		Update(state.duplicates, duplicateKey);
+
+		const auto iRangePos = stItemVnum.find(DELIMITER_RANGE);
+		if (parse_vnum(std::string_view(stItemVnum).substr(0, iRangePos), itemVnum))
+		{
+			Update(state.keys, itemVnum);
+			touched.vnums.insert(itemVnum);
+
+			if (iRangePos == std::string::npos)
+				Update(state.singles, itemVnum);
+		}
+		else
+		{
+			Update(state.other, stItemVnum);
+			touched.other.insert(stItemVnum);
+		}
+
+		if (iRangePos != std::string::npos)
+		{
+			const auto & range = std::make_pair(strtoul(stItemVnum.substr(0, iRangePos)), strtoul(stItemVnum.substr(iRangePos + 1)));
+			Update(state.ranges, range);
+			touched.ranges.push_back(range);
+		}
+	}
+}
+
+/**
+ * \brief
+ * Check if a vnum is covered by a file, either as a single vnum or inside one of its `~` ranges.
+ * \param: state: SFileState
+ * \param: itemVnum: uint32_t
+ * \return: bool
+ */
+auto CProtoChecker::is_covered(const SFileState& state, uint32_t itemVnum) -> bool
+{
+	if (state.singles.count(itemVnum))
+		return true;
+
+	for (auto it = state.ranges.begin(); it != state.ranges.end() && it->first.first <= itemVnum; ++it)
+	{
+		if (it->first.second >= itemVnum)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * \brief
+ * Re-evaluate some keys of a compared pair of files and log the ones whose result changed.
+ * \param: compare: SCompareState
+ * \param: setVnum: set
+ * \param: setOther: set
+ * \param: bReport: bool
+ * \return: size_t, number of keys whose result changed
+ */
+auto CProtoChecker::update_compare(SCompareState& compare, const std::set<uint32_t>& setVnum, const std::set<std::string>& setOther, bool bReport) -> size_t
+{
+	const auto & stateExamine = m_vecFileState[compare.examine];
+	const auto & stateSearch = m_vecFileState[compare.search];
+	const auto & stSearchName = std::get<NAME>(get_file(compare.search));
+	const auto bActive = std::get<EXISTS>(get_file(compare.examine)) && std::get<EXISTS>(get_file(compare.search));
+
+	size_t iChangeCount = 0;
+	const auto Report = [&](const bool bMissing, const std::string& stItemVnum)
+	{
+		++iChangeCount;
+		if (bReport)
+			write_log(bMissing ? "WATCH_MISSING_LINE" : "WATCH_FOUND_LINE", stItemVnum.c_str(), stSearchName.c_str());
+	};
+
+	for (const auto itemVnum : setVnum)
+	{
+		const auto bMissing = bActive && stateExamine.keys.count(itemVnum) && !is_covered(stateSearch, itemVnum);
+		if (bMissing == (compare.missing.count(itemVnum) != 0))
+			continue;
+
+		if (bMissing)
+			compare.missing.insert(itemVnum);
+		else
+			compare.missing.erase(itemVnum);
+		Report(bMissing, std::to_string(itemVnum));
+	}
+
+	for (const auto & stItemVnum : setOther)
+	{
+		const auto bMissing = bActive && stateExamine.other.count(stItemVnum) && !stateSearch.other.count(stItemVnum);
+		if (bMissing == (compare.missingOther.count(stItemVnum) != 0))
+			continue;
+
+		if (bMissing)
+			compare.missingOther.insert(stItemVnum);
+		else
+			compare.missingOther.erase(stItemVnum);
+		Report(bMissing, stItemVnum);
+	}
+
+	return iChangeCount;
+}
+
+/**
+ * \brief
+ * Reload an edited file and log only the results which changed.
+ * The edited rows are the ones left between the common prefix and suffix of the old and new rows,
+ * only their keys (and the keys inside their `~` ranges) are checked again.
+ * \param: index: size_t
+ */
+auto CProtoChecker::reload_file(size_t index) -> void
+{
+	const auto tStart = std::chrono::steady_clock::now();
+
+	auto & file = get_file(index);
+	auto fileNew = load_file(std::get<NAME>(file));
+	const auto & vecOld = std::get<DATA>(file);
+	const auto & vecNew = std::get<DATA>(fileNew);
+
+	size_t iPrefix = 0;
+	while (iPrefix < vecOld.size() && iPrefix < vecNew.size() && vecOld[iPrefix] == vecNew[iPrefix])
+		++iPrefix;
+
+	size_t iSuffix = 0;
+	while (iPrefix + iSuffix < vecOld.size() && iPrefix + iSuffix < vecNew.size() && vecOld[vecOld.size() - 1 - iSuffix] == vecNew[vecNew.size() - 1 - iSuffix])
+		++iSuffix;
+
+	const auto iRemoved = vecOld.size() - iPrefix - iSuffix;
+	const auto iAdded = vecNew.size() - iPrefix - iSuffix;
+	const auto bExistsChanged = std::get<EXISTS>(file) != std::get<EXISTS>(fileNew);
+
+	STouchedKeys touched;
+	auto & state = m_vecFileState[index];
+	update_file_state(state, file, iPrefix, iPrefix + iRemoved, false, touched);
+	update_file_state(state, fileNew, iPrefix, iPrefix + iAdded, true, touched);
+	file = std::move(fileNew);
+
+	write_log("WATCH_FILE_CHANGED", std::get<NAME>(file).c_str(), static_cast<uint32_t>(iRemoved), static_cast<uint32_t>(iAdded));
+
+	size_t iChangeCount = 0;
+	for (const auto & it : touched.duplicates)
+	{
+		const auto & itState = state.duplicates.find(it.first);
+		const auto iCount = itState != state.duplicates.end() ? itState->second : 0;
+		if (iCount == it.second || (iCount < 2 && it.second < 2))
+			continue;
+
+		++iChangeCount;
+		const auto & stItemVnum = it.first.second.empty() ? std::to_string(it.first.first) : it.first.second;
+		if (iCount < 2)
+		{
+			write_log("WATCH_DUPLICATE_OK", stItemVnum.c_str());
+			continue;
+		}
+
+		std::string stLines;
+		const auto & vecFileData = std::get<DATA>(file);
+		for (size_t i = 0; i < vecFileData.size(); ++i)
+		{
+			uint32_t itemVnum;
+			const auto bMatch = parse_vnum(vecFileData[i], itemVnum) ? it.first.second.empty() && itemVnum == it.first.first : vecFileData[i] == it.first.second;
+			if (!bMatch)
+				continue;
+
+			if (!stLines.empty())
+				stLines.append(", ");
+			stLines.append(std::to_string(std::get<LINE>(file)[i]));
+		}
+
+		write_log("FILE_DUPLICATE_LINE", stItemVnum.c_str(), stLines.c_str());
+	}
+
+	for (auto & compare : m_vecCompareState)
+	{
+		if (compare.examine != index && compare.search != index)
+			continue;
+
+		auto setVnum = touched.vnums;
+		auto setOther = touched.other;
+		if (compare.search == index)
+		{
+			const auto & stateExamine = m_vecFileState[compare.examine];
+			if (bExistsChanged)
+			{
+				for (const auto & it : stateExamine.keys)
+					setVnum.insert(it.first);
+				for (const auto & it : stateExamine.other)
+					setOther.insert(it.first);
+			}
+
+			for (const auto & range : touched.ranges)
+			{
+				for (auto it = stateExamine.keys.lower_bound(range.first); it != stateExamine.keys.end() && it->first <= range.second; ++it)
+					setVnum.insert(it->first);
+			}
+		}
+
+		iChangeCount += update_compare(compare, setVnum, setOther, true);
+	}
+
+	if (iChangeCount == 0)
+		write_log("WATCH_NO_CHANGE");
+
+	write_log("WATCH_DONE", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count());
+}
+
+/**
+ * \brief
+ * Keep running after the first check and re-check the files every time one of them is saved.
+ * The results of the last check are kept as row counts, so an edit only costs a reload of the file plus its edited rows.
+ */
+auto CProtoChecker::watch() -> void
+{
+	static constexpr size_t FILE_COUNT = 4;
+
+	load_files();
+	m_vecFileState.assign(FILE_COUNT, SFileState());
+	m_vecCompareState = { { 0, 1, {}, {} }, { 1, 0, {}, {} }, { 2, 3, {}, {} }, { 3, 2, {}, {} } };
+
+	for (size_t i = 0; i < FILE_COUNT; ++i)
+	{
+		STouchedKeys touched;
+		update_file_state(m_vecFileState[i], get_file(i), 0, std::get<DATA>(get_file(i)).size(), true, touched);
+	}
+
+	for (auto & compare : m_vecCompareState)
+	{
+		std::set<uint32_t> setVnum;
+		std::set<std::string> setOther;
+		for (const auto & it : m_vecFileState[compare.examine].keys)
+			setVnum.insert(it.first);
+		for (const auto & it : m_vecFileState[compare.examine].other)
+			setOther.insert(it.first);
+
+		update_compare(compare, setVnum, setOther, false);
+	}
+
+	cFileMonitor monitor;
+	for (size_t i = 0; i < FILE_COUNT; ++i)
+		monitor.Add(m_stRootPath + std::get<NAME>(get_file(i)));
+
+	write_log("WATCH_START", m_stRootPath.c_str());
+	for (;;)
+	{
+		for (const auto index : monitor.Wait())
+			reload_file(index);
+	}
+}
+
+/**
+ * \brief
+ * Keep the files, their vnum indices and the results of their last check in memory and answer requests
+ * on a Unix domain socket, one request line at a time and as many as wanted per connection:
+ *	CHECK <file>			results of the last check of a file: duplicates, comparison with its pair, references
+ *	VNUM <vnum>				where a vnum is defined, in every file
+ *	DIFF <file> <size>		followed by size bytes, diff of an (unsaved) buffer against the file on disk
+ *	PING, QUIT
+ * Every record of the answer is a JSON object on its own line (like the json report), the last line is
+ * {"status":"ok"|"error","ms":...}.
+ * A request first compares the size and write time of the files and reloads the ones which changed,
+ * only the results which depend on them are checked again. Every client runs on its own thread,
+ * requests share the state through a read-write lock and a reload is the only writer.
+ * \param: stSocketPath: string
+ * \return: bool, false if the socket can't be bound or accepting clients keeps failing
+ */
+auto CProtoChecker::serve(const std::string& stSocketPath) -> bool
+{
+	m_vecDaemonRule = load_reference_rules();
+	m_vecDaemonFile.assign(DAEMON_FILE_COUNT, SDaemonFile());
+	for (size_t i = 0; i < DAEMON_FILE_COUNT; ++i)
+		load_daemon_file(i);
+	for (size_t i = 0; i < DAEMON_FILE_COUNT; ++i)
+		check_daemon_file(i, true);
+
+	cLocalServer server;
+	if (!server.Listen(stSocketPath))
+	{
+		write_log("DAEMON_NO_SOCKET", stSocketPath.c_str());
+		m_LogSink.Flush();
+		return false;
+	}
+
+	write_log("DAEMON_START", m_stRootPath.c_str(), stSocketPath.c_str());
+	m_LogSink.Flush();
+
+	// A failure is logged when it starts, a server which keeps failing (or got closed) stops serving.
+	uint32_t iFailures = 0;
+	while (server.IsOpen())
+	{
+		auto client = server.Accept();
+		if (!client)
+		{
+			if (iFailures++ == 0)
+			{
+				write_log("DAEMON_NO_ACCEPT", stSocketPath.c_str(), std::system_category().message(server.GetError()).c_str());
+				m_LogSink.Flush();
+			}
+
+			if (iFailures == MAX_ACCEPT_FAILURES)
+				break;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+
+		iFailures = 0;
+		std::thread([this, client = std::move(client)] { serve_client(*client); }).detach();
+	}
+
+	write_log("DAEMON_STOPPED", stSocketPath.c_str(), iFailures);
+	m_LogSink.Flush();
+	return false;
+}
+
+/**
+ * \brief
+ * Answer the requests of a client until it quits or disconnects.
+ * \param: client: cLocalSocket
+ */
+auto CProtoChecker::serve_client(cLocalSocket& client) -> void
+{
+	std::string stLine, stBuffer;
+	while (client.ReadLine(stLine, MAX_REQUEST_LINE))
+	{
+		const auto tStart = std::chrono::steady_clock::now();
+
+		std::istringstream stream(stLine);
+		std::string stCommand, stArgument;
+		stream >> stCommand >> stArgument;
+		if (stCommand == "QUIT")
+			break;
+
+		// The buffer of a diff can't be skipped without its size, the connection is closed after the answer.
+		size_t iBufferSize = 0;
+		const auto bBadDiff = stCommand == "DIFF" && (!(stream >> iBufferSize) || iBufferSize > MAX_DIFF_BUFFER);
+		if (stCommand == "DIFF" && !bBadDiff && !client.Read(stBuffer, iBufferSize))
+			break;
+
+		if (!bBadDiff)
+			refresh_daemon_files();
+
+		std::string stResponse;
+		auto bOk = true;
+		{
+			SLogCapture capture;
+			std::shared_lock<std::shared_mutex> lock(m_DaemonMutex);
+
+			if (stCommand == "PING" && !bBadDiff)
+			{
+			}
+			else if (stCommand == "VNUM" && !stArgument.empty())
+			{
+				query_vnum(stArgument);
+			}
+			else if ((stCommand == "CHECK" || stCommand == "DIFF") && !stArgument.empty() && !bBadDiff)
+			{
+				const auto index = find_daemon_file(stArgument);
+				if (index == NO_DAEMON_FILE)
+				{
+					write_log("DAEMON_UNKNOWN_FILE", stArgument.c_str());
+					bOk = false;
+				}
+				else if (stCommand == "CHECK")
+				{
+					stResponse = m_vecDaemonFile[index].result + m_vecDaemonFile[index].references;
+				}
+				else
+				{
+					bOk = query_diff(index, std::move(stBuffer));
+				}
+			}
+			else
+			{
+				write_log("DAEMON_BAD_REQUEST", stLine.c_str());
+				bOk = false;
+			}
+
+			stResponse += capture.ToJson();
+		}
+
+		stResponse += format("{\"status\":\"%s\",\"ms\":%.3f}\n", bOk ? "ok" : "error", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count());
+		if (!client.Write(stResponse) || bBadDiff)
+			break;
+	}
+}
+
+/**
+ * \brief
+ * Reload the files whose size or write time changed since they were loaded and check again the files
+ * whose results depend on them: the file itself and its pair, the references of the file itself and of the files
+ * with a reference into it.
+ */
+auto CProtoChecker::refresh_daemon_files() -> void
+{
+	const auto IsChanged = [this](size_t index)
+	{
+		const auto & source = m_vecDaemonFile[index].source;
+		const auto & current = cProtoSnapshot::GetSource(m_stRootPath + std::get<NAME>(get_file(index)));
+		return current.exists != source.exists || current.size != source.size || current.time != source.time;
+	};
+
+	{
+		std::shared_lock<std::shared_mutex> lock(m_DaemonMutex);
+		auto bChanged = false;
+		for (size_t i = 0; i < DAEMON_FILE_COUNT && !bChanged; ++i)
+			bChanged = IsChanged(i);
+
+		if (!bChanged)
+			return;
+	}
+
+	// Another client may have reloaded the files in between, they're compared again under the write lock.
+	std::unique_lock<std::shared_mutex> lock(m_DaemonMutex);
+	std::vector<size_t> vecChanged;
+	for (size_t i = 0; i < DAEMON_FILE_COUNT; ++i)
+	{
+		if (!IsChanged(i))
+			continue;
+
+		const auto tStart = std::chrono::steady_clock::now();
+		load_daemon_file(i);
+		vecChanged.push_back(i);
+
+		const auto & file = get_file(i);
+		write_log("DAEMON_RELOADED", std::get<NAME>(file).c_str(), static_cast<uint32_t>(std::get<DATA>(file).size()), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count());
+	}
+
+	for (size_t i = 0; i < DAEMON_FILE_COUNT; ++i)
+	{
+		const auto & stFileName = std::get<NAME>(get_file(i));
+		const auto IsChangedFile = [&vecChanged](size_t index) { return std::find(vecChanged.begin(), vecChanged.end(), index) != vecChanged.end(); };
+		const auto bReferences = IsChangedFile(i) || std::any_of(vecChanged.begin(), vecChanged.end(), [&](size_t changed)
+		{
+			const auto & stChangedName = std::get<NAME>(get_file(changed));
+			return std::any_of(m_vecDaemonRule.begin(), m_vecDaemonRule.end(), [&](const SReferenceRule& rule) { return rule.file == stFileName && rule.target == stChangedName; });
+		});
+
+		if (bReferences || IsChangedFile(i ^ 1))
+			check_daemon_file(i, bReferences);
+	}
+}
+
+/**
+ * \brief
+ * Load a file of the daemon along with its vnum index and key lookups.
+ * \param: index: size_t, see get_file
+ */
+auto CProtoChecker::load_daemon_file(size_t index) -> void
+{
+	auto & daemonFile = m_vecDaemonFile[index];
+	auto & file = get_file(index);
+
+	// Taken before loading, a write during the load triggers another reload.
+	daemonFile.source = cProtoSnapshot::GetSource(m_stRootPath + std::get<NAME>(file));
+	file = load_file(std::get<NAME>(file));
+	m_vecFileLoaded[index] = true;
+	daemonFile.index = make_vnum_index(file);
+
+	daemonFile.singles.clear();
+	daemonFile.ranges.clear();
+	daemonFile.other.clear();
+
+	const auto & vecFileData = std::get<DATA>(file);
+	const auto & vecFileLine = std::get<LINE>(file);
+	for (size_t i = 0; i < vecFileData.size(); ++i)
+	{
+		const auto & stItemVnum = vecFileData[i];
+		const auto iRangePos = stItemVnum.find(DELIMITER_RANGE);
+
+		uint32_t itemVnum;
+		if (!parse_vnum(std::string_view(stItemVnum).substr(0, iRangePos), itemVnum))
+			daemonFile.other.emplace_back(stItemVnum, vecFileLine[i]);
+		else if (iRangePos == std::string::npos)
+			daemonFile.singles.emplace_back(itemVnum, vecFileLine[i]);
+		else
+			daemonFile.ranges.emplace_back(itemVnum, strtoul(stItemVnum.substr(iRangePos + 1)), vecFileLine[i]);
+	}
+
+	// Stable, a repeated key is found on its first line.
+	const auto ByKey = [](const auto & left, const auto & right) { return std::get<0>(left) < std::get<0>(right); };
+	std::stable_sort(daemonFile.singles.begin(), daemonFile.singles.end(), ByKey);
+	std::stable_sort(daemonFile.ranges.begin(), daemonFile.ranges.end(), ByKey);
+	std::stable_sort(daemonFile.other.begin(), daemonFile.other.end(), ByKey);
+
+	std::lock_guard<std::mutex> lock(m_DaemonTableMutex);
+	daemonFile.table.reset();
+}
+
+/**
+ * \brief
+ * Check a file of the daemon like run does and keep the records as the answer to CHECK.
+ * \param: index: size_t, see get_file
+ * \param: bReferences: bool, check the references of the file too, they don't depend on its pair
+ */
+auto CProtoChecker::check_daemon_file(size_t index, bool bReferences) -> void
+{
+	SLogCapture capture;
+
+	write_log("DUPLICATE_START");
+	find_duplicate(get_file(index));
+	write_log("DUPLICATE_END");
+
+	// Item and mob files are pairs, index ^ 1 is the other file of the pair.
+	const auto first = index & ~static_cast<size_t>(1);
+	const auto second = first + 1;
+	write_log("COMPARE_START");
+	report_difference(get_file(first), get_file(second), find_difference(m_vecDaemonFile[first].index, m_vecDaemonFile[second].index));
+	report_difference(get_file(second), get_file(first), find_difference(m_vecDaemonFile[second].index, m_vecDaemonFile[first].index));
+	write_log("COMPARE_END");
+	m_vecDaemonFile[index].result = capture.ToJson();
+
+	if (!bReferences)
+		return;
+
+	std::vector<SReferenceRule> vecRule;
+	const auto & stFileName = std::get<NAME>(get_file(index));
+	std::copy_if(m_vecDaemonRule.begin(), m_vecDaemonRule.end(), std::back_inserter(vecRule), [&stFileName](const SReferenceRule& rule) { return rule.file == stFileName; });
+
+	// The file is read with the columns of its rules, a target is a file of the daemon or is loaded with its index.
+	std::vector<std::string> vecColumn;
+	for (const auto & rule : vecRule)
+		vecColumn.insert(vecColumn.end(), { rule.column, rule.whenColumn });
+
+	std::deque<SLoadedFile> vecLoaded;
+	std::deque<std::pair<TFileTuple, SVnumIndex>> vecTarget;
+	vecLoaded.push_back({ stFileName, &get_file(index), &m_vecDaemonFile[index].index, nullptr });
+	if (!vecRule.empty())
+		load_file(stFileName, vecColumn, &vecLoaded.back().table);
+
+	for (const auto & rule : vecRule)
+	{
+		if (std::any_of(vecLoaded.begin(), vecLoaded.end(), [&rule](const SLoadedFile& file) { return file.name == rule.target; }))
+			continue;
+
+		const auto target = find_daemon_file(rule.target);
+		if (target != NO_DAEMON_FILE)
+		{
+			vecLoaded.push_back({ rule.target, &get_file(target), &m_vecDaemonFile[target].index, nullptr });
+			continue;
+		}
+
+		auto & loaded = vecTarget.emplace_back();
+		loaded.first = load_file(rule.target);
+		loaded.second = make_vnum_index(loaded.first);
+		vecLoaded.push_back({ rule.target, &loaded.first, &loaded.second, nullptr });
+	}
+
+	std::vector<const SLoadedFile*> vecFile;
+	for (const auto & file : vecLoaded)
+		vecFile.push_back(&file);
+
+	capture.records.clear();
+	if (!vecRule.empty())
+		check_references(vecRule, vecFile);
+
+	m_vecDaemonFile[index].references = capture.ToJson();
+}
+
+/**
+ * \brief
+ * Find a file of the daemon by its name, the directories of a path are ignored.
+ * \param: stFileName: string
+ * \return: size_t, NO_DAEMON_FILE if it isn't one of the files
+ */
+auto CProtoChecker::find_daemon_file(const std::string& stFileName) -> size_t
+{
+	const auto iNamePos = stFileName.find_last_of("/\\");
+	const auto & stName = iNamePos == std::string::npos ? stFileName : stFileName.substr(iNamePos + 1);
+	for (size_t i = 0; i < DAEMON_FILE_COUNT; ++i)
+	{
+		if (std::get<NAME>(get_file(i)) == stName)
+			return i;
+	}
+
+	return NO_DAEMON_FILE;
+}
+
+/**
+ * \brief
+ * Log where a key is defined in every file, as a single vnum, inside a `~` range or as a string key.
+ * \param: stItemVnum: string
+ */
+auto CProtoChecker::query_vnum(const std::string& stItemVnum) -> void
+{
+	uint32_t itemVnum = 0;
+	const auto bNumeric = parse_vnum(stItemVnum, itemVnum);
+
+	for (size_t i = 0; i < DAEMON_FILE_COUNT; ++i)
+	{
+		const auto & file = get_file(i);
+		if (!std::get<EXISTS>(file))
+			continue;
+
+		const auto & daemonFile = m_vecDaemonFile[i];
+		const auto & stFileName = std::get<NAME>(file);
+		const auto & stFilePath = m_stRootPath + stFileName;
+		if (bNumeric)
+		{
+			const auto it = std::lower_bound(daemonFile.singles.begin(), daemonFile.singles.end(), std::make_pair(itemVnum, 0u));
+			if (it != daemonFile.singles.end() && it->first == itemVnum)
+			{
+				write_finding("DAEMON_VNUM_DEFINED", stFilePath.c_str(), it->second, stItemVnum.c_str(), stFileName.c_str());
+				continue;
+			}
+
+			const auto itRange = std::find_if(daemonFile.ranges.begin(), daemonFile.ranges.end(), [itemVnum](const auto & range)
+			{
+				return std::get<0>(range) <= itemVnum && std::get<1>(range) >= itemVnum;
+			});
+
+			if (itRange != daemonFile.ranges.end())
+			{
+				write_finding("DAEMON_VNUM_RANGE", stFilePath.c_str(), std::get<2>(*itRange), stItemVnum.c_str(), std::get<0>(*itRange), std::get<1>(*itRange), stFileName.c_str());
+				continue;
+			}
+		}
+		else
+		{
+			const auto it = std::lower_bound(daemonFile.other.begin(), daemonFile.other.end(), std::string_view(stItemVnum), [](const auto & other, std::string_view key) { return other.first < key; });
+			if (it != daemonFile.other.end() && it->first == stItemVnum)
+			{
+				write_finding("DAEMON_VNUM_DEFINED", stFilePath.c_str(), it->second, stItemVnum.c_str(), stFileName.c_str());
+				continue;
+			}
+		}
+
+		write_log("DAEMON_VNUM_MISSING", stItemVnum.c_str(), stFileName.c_str());
+	}
+}
+
+/**
+ * \brief
+ * Diff a buffer against a file of the daemon, see diff. The file is read into memory on the first diff against it
+ * and kept until it's reloaded, a mapping could be truncated under the daemon by the next save.
+ * \param: index: size_t, see get_file
+ * \param: stBuffer: string, the new revision of the file
+ * \return: bool, false if a revision can't be loaded
+ */
+auto CProtoChecker::query_diff(size_t index, std::string stBuffer) -> bool
+{
+	const auto & stFilePath = m_stRootPath + std::get<NAME>(get_file(index));
+
+	std::shared_ptr<const cCsvTable> table;
+	{
+		std::lock_guard<std::mutex> lock(m_DaemonTableMutex);
+		auto & daemonFile = m_vecDaemonFile[index];
+		if (!daemonFile.table)
+		{
+			auto loadedTable = std::make_shared<cCsvTable>();
+			cMappedFile mapping;
+			if (mapping.Open(stFilePath.c_str()))
+				loadedTable->LoadBuffer(std::string(mapping.Data() ? mapping.Data() : "", mapping.Size()), DELIMITER_TAB, '"');
+
+			daemonFile.table = std::move(loadedTable);
+		}
+
+		table = daemonFile.table;
+	}
+
+	cCsvTable bufferTable;
+	bufferTable.LoadBuffer(std::move(stBuffer), DELIMITER_TAB, '"');
+	return diff_tables(*table, stFilePath, bufferTable, stFilePath);
+}
+
+/**
+ * \brief
+ * Split a string by a specific regular expression.
+ * \param:: stItemVnum: string
+ * \param:: stRegex: string
+ * \return: vector
+ */
+auto CProtoChecker::split_range(const std::string& stItemVnum, const std::string& stRegex) -> std::vector<std::string>
+{
+	try
+	{
+		const std::regex re(stRegex);
+		const std::sregex_token_iterator first{stItemVnum.begin(), stItemVnum.end(), re, -1};
+		const std::sregex_token_iterator last;
+		return { first, last };
+	}
+	catch (const std::regex_error & e)
+	{
+		std::cout << e.what() << e.code() << std::endl;
+	}
+	return {};
+}
+
+/**
+ * \brief
+ * Write a log line to console and the log files.
+ * \param: id: const char*, key of the message in the translation map
+ * \param: ...: any
+ */
+auto CProtoChecker::write_log(const char* id, ...) -> void
+{
+	va_list args;
+	va_start(args, id);
+	push_log(id, "", 0, args);
+	va_end(args);
+}
+
+/**
+ * \brief
+ * Write a log line about a specific row of a file, the location is kept for the reports.
+ * \param: id: const char*, key of the message in the translation map
+ * \param: file: const char*
+ * \param: line: uint32_t
+ * \param: ...: any
+ */
+auto CProtoChecker::write_finding(const char* id, const char* file, uint32_t line, ...) -> void
+{
+	va_list args;
+	va_start(args, line);
+	push_log(id, file, line, args);
+	va_end(args);
+}
+
+/**
+ * \brief
+ * Format a message and hand the record to the log sink, the writers run on its own thread.
+ * \param: id: const char*
+ * \param: file: const char*
+ * \param: line: uint32_t
+ * \param: args: va_list
+ */
+auto CProtoChecker::push_log(const char* id, const char* file, uint32_t line, va_list args) -> void
+{
+	const auto & it = TRANSLATE_MAP.find(id);
+	if (it == TRANSLATE_MAP.end())
+		return;
+
+	SLogRecord record{ it->second.first, id, vformat(it->second.second.c_str(), args), file, line };
+	if (!record.file.empty())
+		cProfiler::CountFinding();
+
+	if (t_pLogCapture)
+	{
+		t_pLogCapture->push_back(std::move(record));
+		return;
+	}
+
+	m_LogSink.Push(std::move(record));
+}
+
+/**
+ * \brief
+ * Add a writer (e.g. a json or sarif report) to the log sink.
+ * \param: writer: cLogWriter
+ */
+auto CProtoChecker::add_log_writer(std::unique_ptr<cLogWriter> writer) -> void
+{
+	m_LogSink.AddWriter(std::move(writer));
+}
+
+/**
+ * \brief
+ * Run the program.
+ */
+auto CProtoChecker::run() -> void
+{
+	cProfileScope profile("run");
+	run_pipeline(load_pipeline());
+	m_LogSink.Flush();
+}
+
+/**
+ * \brief
+ * The checks of the optional pipeline file, or the builtin pipeline when there's none.
+ * The pipeline file is tab separated with a header row: CHECK, FILE, TARGET, where CHECK is one of
+ * duplicate (FILE), compare (keys of FILE missing in TARGET), references (every reference rule), columns (every column rule)
+ * tokens (every token column) or ranges (the vnum ranges of the protos).
+ * \return: vector
+ */
+auto CProtoChecker::load_pipeline() -> std::vector<SPipelineCheck>
+{
+	cCsvTable csv_reader;
+	const auto & stFilePath = m_stRootPath + PIPELINE_FILE_NAME;
+	if (!csv_reader.LoadMapped(stFilePath.c_str(), DELIMITER_TAB, '"'))
+		return PIPELINE;
+
+	std::vector<SPipelineCheck> vecCheck;
+	csv_reader.Next();
+	while (csv_reader.Next())
+	{
+		const auto iColCount = csv_reader.ColCount();
+		if (iColCount < 1 || csv_reader.AsStringViewByIndex(0).empty() || csv_reader.AsStringViewByIndex(0)[0] == '#')
+			continue;
+
+		const auto & stCheck = csv_reader.AsStringByIndex(0);
+		const auto & stFile = iColCount > 1 ? csv_reader.AsStringByIndex(1) : std::string();
+		const auto & stTarget = iColCount > 2 ? csv_reader.AsStringByIndex(2) : std::string();
+
+		const auto it = std::find_if(std::begin(PIPELINE_SECTIONS), std::end(PIPELINE_SECTIONS), [&stCheck](const auto & section) { return stCheck == std::get<1>(section); });
+		const auto type = it == std::end(PIPELINE_SECTIONS) ? PIPELINE_REFERENCES : std::get<0>(*it);
+		const auto bFileless = type == PIPELINE_REFERENCES || type == PIPELINE_COLUMNS || type == PIPELINE_TOKENS || type == PIPELINE_RANGES;
+		if (it == std::end(PIPELINE_SECTIONS) || (!bFileless && stFile.empty()) || (type == PIPELINE_COMPARE && stTarget.empty()))
+		{
+			write_log("PIPELINE_BAD_CHECK", stCheck.c_str(), stFile.c_str(), stTarget.c_str());
+			continue;
+		}
+
+		vecCheck.push_back({ type, stFile, stTarget });
+	}
+
+	return vecCheck;
+}
+
+/**
+ * \brief
+ * Run the checks of a pipeline as a task graph on the thread pool.
+ * Every file is loaded once and indexed once; a check starts as soon as its files are ready and reads them from there.
+ * The keys of an unchanged file come from its snapshot and only the checks which read columns wait for its table,
+ * which is parsed with every column they read. The files of the checker are kept for the later modes.
+ * The log doesn't depend on the scheduling: sections follow EPipelineCheck, the checks of a section follow the
+ * pipeline, and each check logs into its own buffer which is pushed once everything before it was.
+ * \param: vecCheck: vector
+ */
+auto CProtoChecker::run_pipeline(const std::vector<SPipelineCheck>& vecCheck) -> void
+{
+	static constexpr size_t NO_TASK = SIZE_MAX;
+	static constexpr size_t NO_FILE = SIZE_MAX;
+
+	/**
+	 * \brief
+	 * File node of the graph. checker: index of the file of the checker it is (see get_file), NO_FILE if none.
+	 */
+	struct SPipelineFile
+	{
+		SLoadedFile loaded;
+		TFileTuple keys;
+		SVnumIndex index;
+		std::vector<std::string> columns;
+		bool bIndex = false;
+		size_t checker = NO_FILE;
+		size_t loadTask = NO_TASK;
+		size_t indexTask = NO_TASK;
+		size_t tableTask = NO_TASK;
+	};
+
+	/**
+	 * \brief
+	 * File read by a check, bIndex: it needs the vnum index, bTable: it reads columns.
+	 */
+	struct SPipelineUse
+	{
+		SPipelineFile* file;
+		bool bIndex;
+		bool bTable;
+	};
+
+	struct SPipelineOutput
+	{
+		std::vector<SLogRecord> records;
+		bool bDone;
+	};
+
+	CTaskGraph graph;
+	std::vector<std::unique_ptr<SPipelineFile>> vecFile;
+	std::vector<SPipelineOutput> vecOutput;
+	std::mutex outputMutex;
+	size_t nextOutput = 0;
+
+	const auto HasCheck = [&vecCheck](EPipelineCheck type)
+	{
+		return std::any_of(vecCheck.begin(), vecCheck.end(), [type](const auto & check) { return check.type == type; });
+	};
+
+	const auto & vecReferenceRule = HasCheck(PIPELINE_REFERENCES) ? load_reference_rules() : std::vector<SReferenceRule>();
+	const auto & vecColumnRule = HasCheck(PIPELINE_COLUMNS) ? load_column_rules() : std::vector<SColumnRule>();
+
+	// Files read by each check, with the columns it reads from them and whether it needs their vnum index.
+	std::vector<std::vector<SPipelineUse>> vecCheckFile(vecCheck.size());
+	const auto UseFile = [&](size_t check, const std::string& stFileName, bool bIndex, std::initializer_list<std::string> columns)
+	{
+		auto it = std::find_if(vecFile.begin(), vecFile.end(), [&stFileName](const auto & file) { return file->loaded.name == stFileName; });
+		if (it == vecFile.end())
+		{
+			it = vecFile.insert(vecFile.end(), std::make_unique<SPipelineFile>());
+			(*it)->loaded.name = stFileName;
+			for (size_t i = 0; i < m_vecFileLoaded.size(); ++i)
+			{
+				if (std::get<NAME>(get_file(i)) == stFileName)
+					(*it)->checker = i;
+			}
+		}
+
+		auto & file = **it;
+		file.bIndex = file.bIndex || bIndex;
+		for (const auto & stColumn : columns)
+		{
+			if (!stColumn.empty() && std::find(file.columns.begin(), file.columns.end(), stColumn) == file.columns.end())
+				file.columns.push_back(stColumn);
+		}
+
+		vecCheckFile[check].push_back({ &file, bIndex, columns.size() != 0 });
+	};
+
+	for (size_t i = 0; i < vecCheck.size(); ++i)
+	{
+		const auto & check = vecCheck[i];
+		if (check.type == PIPELINE_DUPLICATE)
+		{
+			UseFile(i, check.file, false, {});
+		}
+		else if (check.type == PIPELINE_COMPARE)
+		{
+			UseFile(i, check.file, true, {});
+			UseFile(i, check.target, true, {});
+		}
+		else if (check.type == PIPELINE_REFERENCES)
+		{
+			for (const auto & rule : vecReferenceRule)
+			{
+				UseFile(i, rule.file, false, { rule.column, rule.whenColumn });
+				UseFile(i, rule.target, true, {});
+			}
+		}
+		else if (check.type == PIPELINE_COLUMNS)
+		{
+			for (const auto & rule : vecColumnRule)
+				UseFile(i, rule.file, false, { rule.column, rule.operand, rule.whenColumn });
+		}
+		else if (check.type == PIPELINE_TOKENS)
+		{
+			for (const auto & column : TOKEN_COLUMNS)
+				UseFile(i, column.file, false, { column.column });
+		}
+		else if (check.type == PIPELINE_RANGES)
+		{
+			UseFile(i, ITEM_PROTO_FILE_NAME, false, {});
+			UseFile(i, MOB_PROTO_FILE_NAME, false, {});
+		}
+	}
+
+	// The keys of a file of the checker which is already loaded aren't read again.
+	// A stale snapshot is rewritten by the parse which reads the table, the table task has nothing left to do then.
+	std::vector<const SLoadedFile*> vecLoaded;
+	for (const auto & node : vecFile)
+	{
+		auto & file = *node;
+		vecLoaded.push_back(&file.loaded);
+		if (file.checker != NO_FILE && m_vecFileLoaded[file.checker])
+		{
+			file.loaded.keys = &get_file(file.checker);
+		}
+		else
+		{
+			file.loaded.keys = &file.keys;
+			file.loadTask = graph.Add([this, &file]
+			{
+				if (file.columns.empty() || !load_snapshot(file.loaded.name, file.keys))
+					file.keys = load_file(file.loaded.name, file.columns, file.columns.empty() ? nullptr : &file.loaded.table);
+			});
+		}
+
+		if (!file.columns.empty())
+		{
+			file.tableTask = graph.Add([this, &file]
+			{
+				if (!file.loaded.table && std::get<EXISTS>(*file.loaded.keys))
+					file.loaded.table = load_table(file.loaded.name, file.columns);
+			}, file.loadTask == NO_TASK ? std::vector<size_t>() : std::vector<size_t>{ file.loadTask });
+		}
+
+		if (!file.bIndex)
+			continue;
+
+		file.loaded.index = &file.index;
+		file.indexTask = graph.Add([&file]
+		{
+			cProfileScope profile("vnum_index");
+			profile.AddRows(std::get<DATA>(*file.loaded.keys).size());
+			file.index = make_vnum_index(*file.loaded.keys);
+		}, file.loadTask == NO_TASK ? std::vector<size_t>() : std::vector<size_t>{ file.loadTask });
+	}
+
+	// A check waits for the keys of the files it reads, and for their index and table when it needs them.
+	const auto GetDependency = [&](size_t check)
+	{
+		std::vector<size_t> vecDependency;
+		for (const auto & use : vecCheckFile[check])
+		{
+			for (const auto task : { use.bIndex ? use.file->indexTask : use.file->loadTask, use.bTable ? use.file->tableTask : NO_TASK })
+			{
+				if (task != NO_TASK)
+					vecDependency.push_back(task);
+			}
+		}
+		return vecDependency;
+	};
+
+	// Push the finished outputs which follow the last pushed one.
+	const auto Emit = [&](size_t output, std::vector<SLogRecord> records)
+	{
+		std::lock_guard<std::mutex> lock(outputMutex);
+		if (output != NO_TASK)
+		{
+			vecOutput[output].records = std::move(records);
+			vecOutput[output].bDone = true;
+		}
+
+		for (; nextOutput < vecOutput.size() && vecOutput[nextOutput].bDone; ++nextOutput)
+		{
+			for (auto & record : vecOutput[nextOutput].records)
+				m_LogSink.Push(std::move(record));
+			vecOutput[nextOutput].records.clear();
+		}
+	};
+
+	const auto AddBanner = [&](const char* id)
+	{
+		SLogCapture capture;
+		write_log(id);
+		vecOutput.push_back({ std::move(capture.records), true });
+	};
+
+	for (const auto & section : PIPELINE_SECTIONS)
+	{
+		const auto type = std::get<0>(section);
+		if (!HasCheck(type))
+			continue;
+
+		if (std::get<2>(section))
+			AddBanner(std::get<2>(section));
+
+		for (size_t i = 0; i < vecCheck.size(); ++i)
+		{
+			const auto & check = vecCheck[i];
+			if (check.type != type)
+				continue;
+
+			const auto output = vecOutput.size();
+			vecOutput.push_back({ {}, false });
+
+			if (type == PIPELINE_DUPLICATE)
+			{
+				const auto & file = *vecCheckFile[i][0].file;
+				graph.Add([this, &file, &Emit, output]
+				{
+					SLogCapture capture;
+					find_duplicate(*file.loaded.keys);
+					Emit(output, std::move(capture.records));
+				}, GetDependency(i));
+			}
+			else if (type == PIPELINE_COMPARE)
+			{
+				const auto & examine = *vecCheckFile[i][0].file;
+				const auto & search = *vecCheckFile[i][1].file;
+				graph.Add([this, &examine, &search, &Emit, output]
+				{
+					SLogCapture capture;
+					compare(*examine.loaded.keys, examine.index, *search.loaded.keys, search.index);
+					Emit(output, std::move(capture.records));
+				}, GetDependency(i));
+			}
+			else if (type == PIPELINE_REFERENCES)
+			{
+				graph.Add([this, &vecReferenceRule, &vecLoaded, &Emit, output]
+				{
+					SLogCapture capture;
+					check_references(vecReferenceRule, vecLoaded);
+					Emit(output, std::move(capture.records));
+				}, GetDependency(i));
+			}
+			else if (type == PIPELINE_COLUMNS)
+			{
+				graph.Add([this, &vecColumnRule, &vecLoaded, &Emit, output]
+				{
+					SLogCapture capture;
+					check_columns(vecColumnRule, vecLoaded);
+					Emit(output, std::move(capture.records));
+				}, GetDependency(i));
+			}
+			else if (type == PIPELINE_TOKENS)
+			{
+				graph.Add([this, &vecLoaded, &Emit, output]
+				{
+					SLogCapture capture;
+					check_tokens(TOKEN_COLUMNS, vecLoaded);
+					Emit(output, std::move(capture.records));
+				}, GetDependency(i));
+			}
+			else
+			{
+				graph.Add([this, &vecLoaded, &Emit, output]
+				{
+					SLogCapture capture;
+					check_ranges(vecLoaded);
+					Emit(output, std::move(capture.records));
+				}, GetDependency(i));
+			}
+		}
+
+		if (std::get<3>(section))
+			AddBanner(std::get<3>(section));
+	}
+
+	// The leading banner goes out before the first check finished.
+	Emit(NO_TASK, {});
+	graph.Run(CThreadPool::Instance());
+
+	// The files of the checker loaded here are kept for the modes which run after the checks.
+	for (const auto & file : vecFile)
+	{
+		if (file->checker == NO_FILE || file->loadTask == NO_TASK)
+			continue;
+
+		get_file(file->checker) = std::move(file->keys);
+		m_vecFileLoaded[file->checker] = true;
+	}
+}
+
+/**
+ * \brief
+ * Look for items and mobs which were copied under a new vnum with the same or nearly the same name.
+ */
+auto CProtoChecker::check_similar_names() -> void
+{
+	write_log("SIMILAR_START");
+	for (const auto & stFileName : { ITEM_NAMES_FILE_NAME, MOB_NAMES_FILE_NAME })
+		find_similar_names(stFileName);
+	write_log("SIMILAR_END");
+
+	m_LogSink.Flush();
+}
+
+/**
+ * \brief
+ * Report the clusters of near duplicate names of a names file.
+ * Names are indexed by the MinHash signatures of their n-grams, so candidates come out of the LSH buckets
+ * instead of a comparison of all pairs. The "+N" of a refine level is cut off a name, only rows of the same level pair
+ * (no level counts as +0) and the rows of a refine series (vnum - N is the same) are never paired, unless their names
+ * are identical. As a series holds one row per level, a cluster can't reach a whole series through other rows.
+ * \param: stFileName: string
+ */
+auto CProtoChecker::find_similar_names(const std::string& stFileName) -> void
+{
+	cCsvTable csv_reader;
+	if (!csv_reader.LoadMapped((m_stRootPath + stFileName).c_str(), DELIMITER_TAB, '"', cCsvColumnMask{ 0, 1 }))
+		return;
+
+	write_log("FILE_NAME", stFileName.c_str());
+
+	const auto & file = csv_reader.m_MappedFile;
+
+	// A refine level is a "+N" at the end of the name, the rows of a series share their vnum minus their level.
+	static constexpr auto NO_SERIES = UINT32_MAX;
+	const auto SplitLevel = [](std::string_view& name) -> uint32_t
+	{
+		const auto plus = name.find_last_of('+');
+		if (plus == std::string_view::npos || plus + 1 == name.size() || plus + 4 < name.size() ||
+			!std::all_of(name.begin() + plus + 1, name.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			return NO_SERIES;
+
+		const auto level = strtoul(std::string(name.substr(plus + 1)));
+		name = name.substr(0, plus);
+		while (!name.empty() && name.back() == ' ')
+			name.remove_suffix(1);
+		return level;
+	};
+
+	CMinHashIndex index;
+	std::vector<uint32_t> vecRow;
+	std::vector<uint32_t> vecSeries;
+	std::vector<uint32_t> vecLevel;
+	for (uint32_t row = 1; row < file.GetRowCount(); ++row)
+	{
+		if (file.GetColCount(row) < 2 || file.GetField(row, 1).empty())
+			continue;
+
+		auto name = file.GetField(row, 1);
+		const auto level = SplitLevel(name);
+		const auto vnum = strtoul(std::string(file.GetField(row, 0)));
+
+		index.Add(name);
+		vecRow.push_back(row);
+		vecSeries.push_back(level == NO_SERIES || level > vnum ? NO_SERIES : vnum - level);
+		vecLevel.push_back(level == NO_SERIES ? 0 : level);
+	}
+
+	const auto & vecCluster = index.FindClusters(SIMILAR_NAME_THRESHOLD, [&](uint32_t first, uint32_t second)
+	{
+		if (vecLevel[first] != vecLevel[second])
+			return false;
+
+		return vecSeries[first] == NO_SERIES || vecSeries[first] != vecSeries[second] || file.GetField(vecRow[first], 1) == file.GetField(vecRow[second], 1);
+	});
+
+	if (vecCluster.empty())
+	{
+		write_log("FILE_OK");
+		return;
+	}
+
+	const auto & stFilePath = m_stRootPath + stFileName;
+	for (const auto & cluster : vecCluster)
+	{
+		write_log("SIMILAR_CLUSTER", static_cast<uint32_t>(cluster.size()));
+		for (const auto id : cluster)
+		{
+			const auto row = vecRow[id];
+			write_finding("SIMILAR_NAME", stFilePath.c_str(), file.GetLine(row), std::string(file.GetField(row, 0)).c_str(), std::string(file.GetField(row, 1)).c_str());
+		}
+	}
+}
+
+/**
+ * \brief
+ * The builtin clone rules, replaced or completed by the ones of the optional rules file.
+ * The rules file is tab separated with a header row: FILE, IGNORE (comma separated column names),
+ * a rule replaces the builtin rule of its file.
+ * \return: vector
+ */
+auto CProtoChecker::load_clone_rules() const -> std::vector<SCloneRule>
+{
+	auto vecRule = CLONE_RULES;
+
+	cCsvTable csv_reader;
+	const auto & stFilePath = m_stRootPath + CLONE_RULES_FILE_NAME;
+	if (!csv_reader.LoadMapped(stFilePath.c_str(), DELIMITER_TAB, '"'))
+		return vecRule;
+
+	csv_reader.Next();
+	while (csv_reader.Next())
+	{
+		const auto iColCount = csv_reader.ColCount();
+		if (iColCount < 1 || csv_reader.AsStringViewByIndex(0).empty() || csv_reader.AsStringViewByIndex(0)[0] == '#')
+			continue;
+
+		SCloneRule rule;
+		rule.file = csv_reader.AsStringByIndex(0);
+		if (iColCount > 1 && !csv_reader.AsStringViewByIndex(1).empty())
+			rule.ignore = split_range(csv_reader.AsStringByIndex(1), ",");
+
+		const auto it = std::find_if(vecRule.begin(), vecRule.end(), [&rule](const auto & current) { return current.file == rule.file; });
+		if (it != vecRule.end())
+			*it = std::move(rule);
+		else
+			vecRule.emplace_back(std::move(rule));
+	}
+
+	return vecRule;
+}
+
+/**
+ * \brief
+ * Look for rows copied under another key, identical but for the ignored columns.
  */
-static const auto ROOT_PATH             = "resource\\";
-static const auto LOG_FILE_NAME         = "syslog.txt";
+auto CProtoChecker::check_clone_rows(const std::vector<SCloneRule>& vecRule) -> void
+{
+	write_log("CLONE_START");
+	for (const auto & rule : vecRule)
+		find_clone_rows(rule);
+	write_log("CLONE_END");
+
+	m_LogSink.Flush();
+}
+
+/**
+ * \brief
+ * Report the clusters of rows of a file with the same content in every column the rule doesn't ignore.
+ * Each row is fingerprinted by chaining the XXH64 of its compared fields (in blocks of rows on the thread pool),
+ * then a single pass groups the rows by fingerprint; a row joins a cluster only if its fields match those of the
+ * first row of the cluster, so a hash collision never merges different rows. Time and memory are linear in the rows.
+ * \param: rule: SCloneRule
+ */
+auto CProtoChecker::find_clone_rows(const SCloneRule& rule) -> void
+{
+	static constexpr size_t BLOCK_ROW_COUNT = 4096;
+	static constexpr auto NO_ROW = UINT32_MAX;
+
+	cProfileScope profile("clone_rows");
+
+	const auto & stFilePath = m_stRootPath + rule.file;
+	cCsvTable csv_reader;
+	if (!csv_reader.LoadMapped(stFilePath.c_str(), DELIMITER_TAB, '"'))
+		return;
+
+	write_log("FILE_NAME", rule.file.c_str());
+
+	const auto & file = csv_reader.m_MappedFile;
+	const auto rowCount = static_cast<uint32_t>(file.GetRowCount());
+	profile.AddRows(rowCount ? rowCount - 1 : 0);
+
+	// Compared columns, every column of the header but the ignored ones.
+	// An ignored column missing in the header would be compared (the key at least), every row would look unique.
+	std::vector<size_t> vecColumn;
+	{
+		const auto & vecIgnore = find_columns(file, rule.ignore);
+		const auto itMissing = std::find(vecIgnore.begin(), vecIgnore.end(), -1);
+		if (itMissing != vecIgnore.end())
+		{
+			write_log("CLONE_SKIPPED", (rule.ignore[static_cast<size_t>(itMissing - vecIgnore.begin())] + " not found").c_str());
+			return;
+		}
+
+		for (size_t col = 0; rowCount && col < file.GetColCount(0); ++col)
+		{
+			if (std::find(vecIgnore.begin(), vecIgnore.end(), static_cast<int>(col)) == vecIgnore.end())
+				vecColumn.push_back(col);
+		}
+	}
+
+	if (vecColumn.empty())
+	{
+		write_log("CLONE_SKIPPED", "no column left to compare");
+		return;
+	}
+
+	// A field past the end of a short row reads as empty, for the fingerprint and the compare alike.
+	const auto GetField = [&file](uint32_t row, size_t col)
+	{
+		return col < file.GetColCount(row) ? file.GetField(row, col) : std::string_view();
+	};
+
+	const auto IsSameContent = [&](uint32_t first, uint32_t second)
+	{
+		return std::all_of(vecColumn.begin(), vecColumn.end(), [&](size_t col) { return GetField(first, col) == GetField(second, col); });
+	};
+
+	std::vector<uint64_t> vecFingerprint(rowCount);
+	const auto blockCount = (rowCount + BLOCK_ROW_COUNT - 1) / BLOCK_ROW_COUNT;
+	CThreadPool::Instance().ParallelFor(blockCount, [&](size_t block)
+	{
+		const auto begin = std::max<size_t>(block * BLOCK_ROW_COUNT, 1);
+		const auto end = std::min<size_t>(rowCount, (block + 1) * BLOCK_ROW_COUNT);
+		for (auto row = begin; row < end; ++row)
+		{
+			uint64_t fingerprint = 0;
+			for (const auto col : vecColumn)
+			{
+				const auto field = GetField(static_cast<uint32_t>(row), col);
+				fingerprint = hash_xxh64(field.data(), field.size(), fingerprint);
+			}
+			vecFingerprint[row] = fingerprint;
+		}
+	});
+
+	// First row of each cluster by fingerprint; rows with the same fingerprint but another content chain their own cluster.
+	std::unordered_map<uint64_t, uint32_t> mapFirst;
+	mapFirst.reserve(rowCount);
+	std::vector<uint32_t> vecNextFirst(rowCount, NO_ROW);
+	std::vector<uint32_t> vecNextRow(rowCount, NO_ROW);
+	std::vector<uint32_t> vecLastRow(rowCount, NO_ROW);
+	std::vector<uint32_t> vecSize(rowCount, 1);
+	for (uint32_t row = 1; row < rowCount; ++row)
+	{
+		const auto & inserted = mapFirst.emplace(vecFingerprint[row], row);
+		if (inserted.second)
+			continue;
+
+		auto first = inserted.first->second;
+		auto bSame = IsSameContent(first, row);
+		while (!bSame && vecNextFirst[first] != NO_ROW)
+		{
+			first = vecNextFirst[first];
+			bSame = IsSameContent(first, row);
+		}
 
-static const auto ITEM_PROTO_FILE_NAME  = "item_proto.txt";
-static const auto ITEM_NAMES_FILE_NAME  = "item_names.txt";
-static const auto MOB_PROTO_FILE_NAME   = "mob_proto.txt";
-static const auto MOB_NAMES_FILE_NAME   = "mob_names.txt";
+		if (!bSame)
+		{
+			vecNextFirst[first] = row;
+			continue;
+		}
 
-/**
- * \brief
- * Builtin translation.
- */
-using TLocaleStringMap = std::map<std::string, std::string>;
-TLocaleStringMap TRANSLATE_MAP =
-{
-	{"FILE_EMPTY",          format(COLOR_GREEN, "File %s is empty.")},
-	{"FILE_OK",             format(COLOR_GREEN, "\tOK")},
-	{"FILE_NAME",           format(COLOR_GRAY,  "Reading file: %s")},
-	{"FILE_TOTAL_LINES",    format(COLOR_RED,   "\tTotal lines: %d")},
-	{"FILE_DUPLICATE_LINE", format(COLOR_RED,   "\tDuplicated itemVnum: %s at line: %d")},
-	{"FILE_COMPARING_LINE", format(COLOR_RED,   "\tMissing itemVnum: %s")},
-};
+		vecNextRow[vecLastRow[first] == NO_ROW ? first : vecLastRow[first]] = row;
+		vecLastRow[first] = row;
+		++vecSize[first];
+	}
+
+	auto bClone = false;
+	for (uint32_t first = 1; first < rowCount; ++first)
+	{
+		if (vecSize[first] < 2)
+			continue;
+
+		bClone = true;
+		write_log("CLONE_CLUSTER", vecSize[first]);
+		for (auto row = first; row != NO_ROW; row = vecNextRow[row])
+		{
+			const auto line = file.GetLine(row);
+			write_finding("CLONE_ROW", stFilePath.c_str(), line, std::string(GetField(row, 0)).c_str(), std::string(GetField(row, 1)).c_str(), line);
+		}
+	}
+
+	if (!bClone)
+		write_log("FILE_OK");
+}
 
 /**
  * \brief
- * Called the constructor/destructor method.
+ * Add the keys of a loaded file to a range index: every numeric single vnum and every `~` range.
+ * A range which ends before it starts isn't added.
+ * \param: file: tuple
+ * \param: source: uint32_t, tag of the file's intervals
+ * \param: index: CVnumRangeIndex
  */
-CProtoChecker::CProtoChecker() :
-	m_ItemProtoFile(load_file(ITEM_PROTO_FILE_NAME)),
-	m_ItemNamesFile(load_file(ITEM_NAMES_FILE_NAME)),
-	m_MobProtoFile(load_file(MOB_PROTO_FILE_NAME)),
-	m_MobNamesFile(load_file(MOB_NAMES_FILE_NAME))
+auto CProtoChecker::add_range_keys(const TFileTuple& file, uint32_t source, CVnumRangeIndex& index) -> void
 {
-}
+	const auto & vecFileData = std::get<DATA>(file);
+	const auto & vecFileLine = std::get<LINE>(file);
+	for (size_t i = 0; i < vecFileData.size(); ++i)
+	{
+		const auto & stItemVnum = vecFileData[i];
+		const auto iRangePos = stItemVnum.find(DELIMITER_RANGE);
 
-CProtoChecker::~CProtoChecker()
-{
+		uint32_t first, last;
+		if (!parse_vnum(std::string_view(stItemVnum).substr(0, iRangePos), first))
+			continue;
+
+		if (iRangePos == std::string::npos)
+			last = first;
+		else if (!parse_vnum(std::string_view(stItemVnum).substr(iRangePos + 1), last) || last < first)
+			continue;
+
+		index.Add(first, last, source, vecFileLine[i]);
+	}
 }
 
 /**
  * \brief
- * Load a specific file and save the data into a tuple.
- * \param: stFileName: string
- * \return: tuple
+ * Check the vnum ranges of the proto files: ranges overlapping each other, single vnums inside a range,
+ * reversed or malformed (`100~`) ranges, and item_proto rows which don't follow the range convention (see EVnumRangeConfig).
+ * The keys of each file are sorted once in a range index, the overlaps come out of one sweep over them.
+ * \param: vecFile: vector, the loaded protos
  */
-auto CProtoChecker::load_file(const std::string& stFileName) const -> TFileTuple
+auto CProtoChecker::check_ranges(const std::vector<const SLoadedFile*>& vecFile) -> void
 {
-	cCsvTable csv_reader;
-	std::vector<std::string> vecFileData;
-	std::vector<std::tuple<uint32_t, uint32_t>> vecRangeVnum;
-
-	std::string stFilePath(ROOT_PATH);
-	stFilePath.append(stFileName);
+	cProfileScope profile("check_ranges");
 
-	const auto bFileExists = csv_reader.Load(stFilePath.c_str(), DELIMITER_TAB);
-	if (bFileExists)
+	for (const auto & stFileName : { ITEM_PROTO_FILE_NAME, MOB_PROTO_FILE_NAME })
 	{
-		csv_reader.Next();
-		while (csv_reader.Next())
+		const auto loaded = find_loaded(vecFile, stFileName);
+		if (!loaded || !std::get<EXISTS>(*loaded->keys))
+			continue;
+
+		const auto file = loaded->keys;
+		write_log("FILE_NAME", std::get<NAME>(*file).c_str());
+
+		const auto & stFilePath = m_stRootPath + std::get<NAME>(*file);
+		const auto & vecFileData = std::get<DATA>(*file);
+		const auto & vecFileLine = std::get<LINE>(*file);
+		const auto bConvention = std::get<NAME>(*file) == ITEM_PROTO_FILE_NAME;
+		profile.AddRows(vecFileData.size());
+
+		uint32_t iBrokenCount = 0;
+		for (size_t i = 0; i < vecFileData.size(); ++i)
 		{
-			const auto & stItemVnum = csv_reader.AsStringByIndex(0);
-			if (stItemVnum.find(DELIMITER_RANGE) != std::string::npos)
+			const auto & stItemVnum = vecFileData[i];
+			const auto iRangePos = stItemVnum.find(DELIMITER_RANGE);
+
+			uint32_t first = 0, last = 0;
+			const auto bFirst = parse_vnum(std::string_view(stItemVnum).substr(0, iRangePos), first);
+			const auto bRange = iRangePos != std::string::npos;
+			if (bRange && (!bFirst || !parse_vnum(std::string_view(stItemVnum).substr(iRangePos + 1), last)))
 			{
-				const auto & vecVnumRange = split_range(stItemVnum, std::string(1, DELIMITER_RANGE));
-				vecRangeVnum.emplace_back(strtoul(vecVnumRange[0]), strtoul(vecVnumRange[1]));
+				write_finding("RANGE_MALFORMED", stFilePath.c_str(), vecFileLine[i], vecFileLine[i], stItemVnum.c_str());
+				++iBrokenCount;
+				continue;
 			}
 
-			vecFileData.emplace_back(stItemVnum);
+			if (!bFirst)
+				continue;
+
+			if (bRange && last < first)
+			{
+				write_finding("RANGE_REVERSED", stFilePath.c_str(), vecFileLine[i], vecFileLine[i], stItemVnum.c_str());
+				++iBrokenCount;
+			}
+			else if (bConvention && first >= VNUM_RANGE_START && first <= VNUM_RANGE_END && (!bRange || last != first + VNUM_RANGE))
+			{
+				write_finding("RANGE_CONVENTION", stFilePath.c_str(), vecFileLine[i], vecFileLine[i], stItemVnum.c_str(), first, first + VNUM_RANGE);
+				++iBrokenCount;
+			}
 		}
-	}
 
-	return std::make_tuple(stFileName, vecFileData, bFileExists, vecRangeVnum);
+		CVnumRangeIndex index;
+		add_range_keys(*file, 0, index);
+		index.Build();
+
+		const auto ToString = [](const CVnumRangeIndex::SInterval& interval)
+		{
+			return interval.first == interval.last ? std::to_string(interval.first) : std::to_string(interval.first) + static_cast<char>(DELIMITER_RANGE) + std::to_string(interval.last);
+		};
+
+		for (const auto & overlap : index.FindOverlaps())
+		{
+			const auto & outer = overlap.outer;
+			const auto & inner = overlap.inner;
+			if (outer.first == outer.last || inner.first == inner.last)
+			{
+				const auto & single = outer.first == outer.last ? outer : inner;
+				const auto & range = outer.first == outer.last ? inner : outer;
+				write_finding("RANGE_INSIDE", stFilePath.c_str(), single.line, single.line, range.line, ToString(single).c_str(), ToString(range).c_str());
+			}
+			else
+			{
+				write_finding("RANGE_OVERLAP", stFilePath.c_str(), inner.line, outer.line, inner.line, ToString(outer).c_str(), ToString(inner).c_str());
+			}
+			++iBrokenCount;
+		}
+
+		write_log(iBrokenCount == 0 ? "FILE_OK" : "FILE_TOTAL_LINES", iBrokenCount);
+	}
 }
 
 /**
  * \brief
- * Read a specific file and find the duplicates lines.
- * \param: file: tuple
+ * Report the lowest block of free vnums of a size, at or above a vnum, for items and for mobs.
+ * A vnum is taken when a row of the proto or of the names file is keyed on it, or when it's inside a `~` range.
+ * \param: count: uint32_t
+ * \param: from: uint32_t
  */
-auto CProtoChecker::find_duplicate(const TFileTuple& file) -> void
+auto CProtoChecker::find_free_vnums(uint32_t count, uint32_t from) -> void
 {
-	if (!std::get<EXISTS>(file))
-		return;
-
-	const auto & stFileName = std::get<NAME>(file);
-	const auto & vecFileData = std::get<DATA>(file);
+	load_files();
 
-	write_log(TRANSLATE_MAP["FILE_NAME"], stFileName.c_str());
-
-	std::map<std::string, uint32_t> mapFileDuplicate;
-	uint32_t lineIndex = 1;
-	for (const auto & stItemVnum : vecFileData)
+	write_log("FREE_START");
+	for (const auto & space : { std::make_pair(&m_ItemProtoFile, &m_ItemNamesFile), std::make_pair(&m_MobProtoFile, &m_MobNamesFile) })
 	{
-		++lineIndex;
-		const auto iCount = std::count(vecFileData.begin(), vecFileData.end(), stItemVnum);
-		if (iCount > 1)
-			mapFileDuplicate[stItemVnum] = lineIndex;
+		CVnumRangeIndex index;
+		add_range_keys(*space.first, 0, index);
+		add_range_keys(*space.second, 1, index);
+		index.Build();
+
+		const auto & stFileName = std::get<NAME>(*space.first);
+		uint32_t first;
+		if (index.FindFree(count, from, first))
+			write_log("FREE_BLOCK", count, from, stFileName.c_str(), first, static_cast<uint32_t>(first + (count ? count - 1 : 0)));
+		else
+			write_log("FREE_NONE", count, from, stFileName.c_str());
 	}
+	write_log("FREE_END");
 
-	for (const auto & it : mapFileDuplicate)
-		write_log(TRANSLATE_MAP["FILE_DUPLICATE_LINE"], it.first.c_str(), it.second);
+	m_LogSink.Flush();
+}
+
+/**
+ * \brief
+ * Rewrite the files with what the checks found: duplicated proto and names rows are removed (the first row is kept)
+ * and a placeholder row is added to the names file for every proto vnum without a name, named like the proto row.
+ * The name is converted to UTF-8 for a UTF-8 names file, NONAME is written if it can't be converted to the names file's encoding.
+ * Rows are copied byte for byte, so quoting and the comment lines above a row are kept; the original file is kept as .bak.
+ * \param: bSort: bool, sort the rows by vnum, otherwise keep their order and append the placeholders
+ */
+auto CProtoChecker::fix(bool bSort) -> void
+{
+	write_log("FIX_START");
+	fix_pair(ITEM_PROTO_FILE_NAME, ITEM_NAMES_FILE_NAME, bSort);
+	fix_pair(MOB_PROTO_FILE_NAME, MOB_NAMES_FILE_NAME, bSort);
+	write_log("FIX_END");
 
-	write_log(mapFileDuplicate.empty() ? TRANSLATE_MAP["FILE_OK"] : TRANSLATE_MAP["FILE_TOTAL_LINES"], mapFileDuplicate.size());
+	m_LogSink.Flush();
 }
 
 /**
  * \brief
- * Compare two files and find the differences between them.
- * \param: fileExamine: tuple
- * \param: fileSearch: tuple
+ * Fix a proto file and its names file.
+ * \param: stProtoName: string
+ * \param: stNamesName: string
+ * \param: bSort: bool
  */
-auto CProtoChecker::compare(const TFileTuple& fileExamine, const TFileTuple& fileSearch) -> void
+auto CProtoChecker::fix_pair(const std::string& stProtoName, const std::string& stNamesName, bool bSort) -> void
 {
-	if (!std::get<EXISTS>(fileExamine) || !std::get<EXISTS>(fileSearch))
+	cMappedFile protoFile;
+	std::vector<SFixRow> vecProtoRow;
+	std::string stProtoLineEnd;
+	std::string_view protoTail;
+	if (!protoFile.Open((m_stRootPath + stProtoName).c_str()) || !read_fix_rows(protoFile, vecProtoRow, stProtoLineEnd, protoTail))
 		return;
-	 
-	auto vecFileExamine = std::get<DATA>(fileExamine);
-	auto vecFileSearch = std::get<DATA>(fileSearch);
-	decltype(vecFileSearch) vecFileDifference;
 
-	std::sort(vecFileExamine.begin(), vecFileExamine.end());
-	std::sort(vecFileSearch.begin(), vecFileSearch.end());
+	const auto iProtoRemoved = remove_duplicate_rows(vecProtoRow);
+	if (bSort)
+		sort_rows(vecProtoRow);
 
-	const auto bCmpItemProto = std::get<NAME>(fileSearch) == ITEM_PROTO_FILE_NAME;
-	const auto bCmpItemNames = std::get<NAME>(fileSearch) == ITEM_NAMES_FILE_NAME;
+	cMappedFile namesFile;
+	std::vector<SFixRow> vecNamesRow;
+	std::string stNamesLineEnd;
+	std::string_view namesTail;
+	const auto bNamesExists = namesFile.Open((m_stRootPath + stNamesName).c_str()) && read_fix_rows(namesFile, vecNamesRow, stNamesLineEnd, namesTail);
+	const auto iNamesRemoved = bNamesExists ? remove_duplicate_rows(vecNamesRow) : 0;
 
-	if (bCmpItemProto || bCmpItemNames)
+	// Placeholders for every proto key the names file doesn't cover, the same way compare decides it.
+	std::deque<std::string> deqPlaceholder;
+	if (bNamesExists)
 	{
-		for (const auto & stItemVnum : vecFileExamine)
+		CVnumSet setNamesCoverage;
+		std::set<std::string> setNamesOther;
+		for (size_t i = 1; i < vecNamesRow.size(); ++i)
 		{
-			auto stBaseItemVnum = stItemVnum;
-			if (bCmpItemProto)
+			const auto & row = vecNamesRow[i];
+			if (!row.numeric)
+				setNamesOther.insert(row.key);
+			else if (!row.range)
+				setNamesCoverage.Add(row.vnum);
+			else
 			{
-				const auto itemVnum = strtoul(stItemVnum);
-				if (itemVnum >= VNUM_RANGE_START && itemVnum <= VNUM_RANGE_END)
-				{
-					char cVnumRange[64];
-					_snprintf_s(cVnumRange, sizeof(cVnumRange), "%u%c%u", itemVnum, DELIMITER_RANGE, itemVnum + VNUM_RANGE);
-					stBaseItemVnum = cVnumRange;
-				}
+				uint32_t lastVnum;
+				if (parse_vnum(std::string_view(row.key).substr(row.key.find(DELIMITER_RANGE) + 1), lastVnum) && lastVnum >= row.vnum)
+					setNamesCoverage.AddRange(row.vnum, lastVnum);
 			}
-			if (bCmpItemNames)
+		}
+
+		// A name is copied as it is unless the files disagree on the encoding, an ASCII names file takes any name.
+		const auto protoEncoding = cTextEncoding::Detect(std::string_view(protoFile.Data(), protoFile.Size()));
+		const auto namesEncoding = cTextEncoding::Detect(std::string_view(namesFile.Data(), namesFile.Size()));
+		std::string stTranscoded;
+
+		const auto iNamesRowCount = vecNamesRow.size();
+		for (size_t i = 1; i < vecProtoRow.size(); ++i)
+		{
+			const auto & row = vecProtoRow[i];
+			if (row.numeric ? setNamesCoverage.Contains(row.vnum) : setNamesOther.count(row.key) != 0)
+				continue;
+
+			// The name field of the proto row, as it's written there (a quoted name may hold tabs).
+			const auto & text = row.text.substr(row.begin);
+			auto name = std::string_view("NONAME");
+			const auto iKeyEnd = text.find(DELIMITER_TAB);
+			if (iKeyEnd != std::string_view::npos)
 			{
-				if (stItemVnum.find(DELIMITER_RANGE) != std::string::npos)
+				auto iNameEnd = iKeyEnd + 1;
+				if (iNameEnd < text.size() && text[iNameEnd] == '"')
+				{
+					for (iNameEnd = text.find('"', iNameEnd + 1); iNameEnd + 1 < text.size() && text[iNameEnd + 1] == '"'; iNameEnd = text.find('"', iNameEnd + 2))
+						;
+					iNameEnd = std::min(iNameEnd, text.size() - 1) + 1;
+				}
+				else
 				{
-					const auto stItemVnumStart = split_range(stItemVnum, std::string(1, DELIMITER_RANGE)).at(0);
-					stBaseItemVnum = stItemVnumStart;
+					iNameEnd = std::min(text.find(DELIMITER_TAB, iNameEnd), text.size());
+				}
+
+				name = text.substr(iKeyEnd + 1, iNameEnd - iKeyEnd - 1);
+				if (namesEncoding != cTextEncoding::ENCODING_ASCII && namesEncoding != protoEncoding && cTextEncoding::FindNonAscii(name) != name.size())
+				{
+					if (namesEncoding == cTextEncoding::ENCODING_UTF8 && cTextEncoding::NeedsTranscoding(protoEncoding))
+					{
+						stTranscoded.clear();
+						cTextEncoding::ToUtf8(name, protoEncoding, stTranscoded);
+						name = stTranscoded;
+					}
+					else
+					{
+						name = "NONAME";
+					}
 				}
 			}
-			if (std::find(vecFileSearch.begin(), vecFileSearch.end(), stBaseItemVnum) == vecFileSearch.end())
-				vecFileDifference.emplace_back(stBaseItemVnum);
+
+			const auto & stKey = row.numeric ? std::to_string(row.vnum) : row.key;
+			deqPlaceholder.emplace_back(stKey);
+			deqPlaceholder.back().append(1, DELIMITER_TAB).append(name);
+			vecNamesRow.push_back({ deqPlaceholder.back(), 0, stKey, row.vnum, row.numeric, false });
 		}
+
+		if (bSort)
+			sort_rows(vecNamesRow);
+		else
+			std::stable_sort(vecNamesRow.begin() + static_cast<std::ptrdiff_t>(iNamesRowCount), vecNamesRow.end(), [](const SFixRow& left, const SFixRow& right) { return std::make_tuple(!left.numeric, left.vnum, left.key) < std::make_tuple(!right.numeric, right.vnum, right.key); });
+	}
+
+	// Names are written before the proto, their placeholders point into the proto mapping.
+	if (bNamesExists)
+	{
+		write_log("FILE_NAME", stNamesName.c_str());
+		const auto bNamesChanged = iNamesRemoved != 0 || !deqPlaceholder.empty();
+		log_fix_result(stNamesName, write_fix_file(stNamesName, namesFile, vecNamesRow, stNamesLineEnd, namesTail, bNamesChanged), bNamesChanged, iNamesRemoved, static_cast<uint32_t>(deqPlaceholder.size()));
 	}
-	else
+
+	write_log("FILE_NAME", stProtoName.c_str());
+	log_fix_result(stProtoName, write_fix_file(stProtoName, protoFile, vecProtoRow, stProtoLineEnd, protoTail, iProtoRemoved != 0), iProtoRemoved != 0, iProtoRemoved, 0);
+}
+
+/**
+ * \brief
+ * Log what write_fix_file did with a file.
+ * \param: stFileName: string
+ * \param: result: EFixResult
+ * \param: bChanged: bool, rows were removed or added, otherwise a rewrite only sorted the rows
+ * \param: iRemoved: uint32_t, duplicated rows removed
+ * \param: iAdded: uint32_t, placeholder rows added
+ */
+auto CProtoChecker::log_fix_result(const std::string& stFileName, EFixResult result, bool bChanged, uint32_t iRemoved, uint32_t iAdded) -> void
+{
+	const auto & stBackupPath = stFileName + ".bak";
+	switch (result)
+	{
+		case FIX_UNCHANGED:
+			write_log("FILE_OK");
+			break;
+
+		case FIX_REWRITTEN:
+			if (bChanged)
+				write_log("FIX_WRITTEN", iRemoved, iAdded, stBackupPath.c_str());
+			else
+				write_log("FIX_SORTED", stBackupPath.c_str());
+			break;
+
+		case FIX_FAILED:
+			write_log("FIX_FAILED", (m_stRootPath + stFileName).c_str());
+			break;
+	}
+}
+
+/**
+ * \brief
+ * Write the rows of a file into a temporary file, then swap it with the original which is kept as .bak.
+ * Nothing is written when the rows are the ones of the file in the same order.
+ * \param: stFileName: string
+ * \param: mapping: cMappedFile, the source of the rows, closed before the files are swapped
+ * \param: vecRow: vector
+ * \param: stLineEnd: string
+ * \param: tail: string_view, comment lines after the last row
+ * \param: bChanged: bool, false if no row was removed or added
+ * \return: EFixResult, FIX_UNCHANGED when the file was left as it is
+ */
+auto CProtoChecker::write_fix_file(const std::string& stFileName, cMappedFile& mapping, const std::vector<SFixRow>& vecRow, const std::string& stLineEnd, std::string_view tail, bool bChanged) -> EFixResult
+{
+	const auto bInOrder = std::is_sorted(vecRow.begin(), vecRow.end(), [](const SFixRow& left, const SFixRow& right) { return left.text.data() < right.text.data(); });
+	if (!bChanged && bInOrder)
+		return FIX_UNCHANGED;
+
+	const auto & stFilePath = m_stRootPath + stFileName;
+	const auto & stTemporaryPath = stFilePath + ".tmp";
+	const auto & stBackupPath = stFilePath + ".bak";
+
+	cCsvWriter writer(DELIMITER_TAB, '"');
+	writer.SetLineEnd(stLineEnd);
+	auto bWritten = writer.Open(stTemporaryPath.c_str());
+	if (bWritten)
 	{
-		std::set_difference(vecFileExamine.begin(), vecFileExamine.end(), vecFileSearch.begin(), vecFileSearch.end(), std::inserter(vecFileDifference, vecFileDifference.begin()));
+		for (const auto & row : vecRow)
+		{
+			writer.WriteRaw(row.text);
+			writer.EndRow();
+		}
+
+		if (tail.data())
+		{
+			writer.WriteRaw(tail);
+			writer.EndRow();
+		}
+
+		bWritten = writer.Close();
 	}
 
-	write_log(TRANSLATE_MAP["FILE_NAME"], std::get<EFile::NAME>(fileSearch).c_str());
+	mapping.Close();
 
-	if (vecFileDifference.empty())
+	std::error_code error;
+	if (bWritten)
 	{
-		write_log(TRANSLATE_MAP["FILE_OK"]);
-		return;
+		std::filesystem::remove(stBackupPath, error);
+		std::filesystem::rename(stFilePath, stBackupPath, error);
+		if (!error)
+			std::filesystem::rename(stTemporaryPath, stFilePath, error);
 	}
 
-	for (const auto & stItemVnum : vecFileDifference)
-		write_log(TRANSLATE_MAP["FILE_COMPARING_LINE"], stItemVnum.c_str());
+	if (!bWritten || error)
+	{
+		std::filesystem::remove(stTemporaryPath, error);
+		return FIX_FAILED;
+	}
 
-	write_log(TRANSLATE_MAP["FILE_TOTAL_LINES"], vecFileDifference.size());
+	return FIX_REWRITTEN;
 }
 
 /**
  * \brief
- * Split a string by a specific regular expression.
- * \param:: stItemVnum: string
- * \param:: stRegex: string
- * \return: vector
+ * Split a mapped file into rows without unescaping anything.
+ * A row ends at a line break outside of quotes, empty lines and lines starting with '#' are comments
+ * which stay with the row below them.
+ * \param: mapping: cMappedFile
+ * \param: vecRow: vector, the header is the first row
+ * \param: stLineEnd: string, line break used by the file
+ * \param: tail: string_view, comment lines after the last row, a null view when there are none
+ * \return: bool, false if the file has no header
  */
-auto CProtoChecker::split_range(const std::string& stItemVnum, const std::string& stRegex) -> std::vector<std::string>
+auto CProtoChecker::read_fix_rows(const cMappedFile& mapping, std::vector<SFixRow>& vecRow, std::string& stLineEnd, std::string_view& tail) -> bool
 {
-	try
+	const std::string_view data(mapping.Data() ? mapping.Data() : "", mapping.Size());
+	const auto iFirstLineEnd = data.find('\n');
+	stLineEnd = iFirstLineEnd != std::string_view::npos && iFirstLineEnd > 0 && data[iFirstLineEnd - 1] == '\r' ? "\r\n" : "\n";
+
+	const auto TrimLineEnd = [&data](size_t begin, size_t end)
 	{
-		const std::regex re(stRegex);
-		const std::sregex_token_iterator first{stItemVnum.begin(), stItemVnum.end(), re, -1};
-		const std::sregex_token_iterator last;
-		return { first, last };
+		return end > begin && data[end - 1] == '\r' ? end - 1 : end;
+	};
+
+	auto iCommentBegin = std::string_view::npos;
+	size_t pos = 0;
+	while (pos < data.size())
+	{
+		auto iLineEnd = std::min(data.find('\n', pos), data.size());
+		if (TrimLineEnd(pos, iLineEnd) == pos || data[pos] == '#')
+		{
+			if (iCommentBegin == std::string_view::npos)
+				iCommentBegin = pos;
+
+			pos = iLineEnd + 1;
+			continue;
+		}
+
+		// A quoted field may hold line breaks, the row goes on until the quotes are balanced at the end of a line.
+		auto bQuoted = false;
+		for (auto iScan = pos; ; iScan = iLineEnd + 1)
+		{
+			iLineEnd = std::min(data.find('\n', iScan), data.size());
+			for (auto iQuote = data.find('"', iScan); iQuote < iLineEnd; iQuote = data.find('"', iQuote + 1))
+				bQuoted = !bQuoted;
+
+			if (!bQuoted || iLineEnd >= data.size())
+				break;
+		}
+
+		SFixRow row;
+		const auto iRowBegin = iCommentBegin == std::string_view::npos ? pos : iCommentBegin;
+		row.text = data.substr(iRowBegin, TrimLineEnd(pos, iLineEnd) - iRowBegin);
+		row.begin = pos - iRowBegin;
+
+		// First field, unquoted.
+		const auto iKeyEnd = std::min(data.find_first_of("\t\r\n", pos), data.size());
+		const auto key = data.substr(pos, iKeyEnd - pos);
+		if (key.size() >= 2 && key.front() == '"' && key.back() == '"')
+		{
+			for (size_t i = 1; i + 1 < key.size(); ++i)
+			{
+				row.key += key[i];
+				if (key[i] == '"' && key[i + 1] == '"')
+					++i;
+			}
+		}
+		else
+		{
+			row.key = std::string(key);
+		}
+
+		const auto iRangePos = row.key.find(DELIMITER_RANGE);
+		row.range = iRangePos != std::string::npos;
+		row.numeric = parse_vnum(std::string_view(row.key).substr(0, iRangePos), row.vnum);
+		if (!row.numeric)
+			row.vnum = 0;
+
+		vecRow.emplace_back(std::move(row));
+		iCommentBegin = std::string_view::npos;
+		pos = iLineEnd + 1;
 	}
-	catch (const std::regex_error & e)
+
+	tail = iCommentBegin == std::string_view::npos ? std::string_view() : data.substr(iCommentBegin, TrimLineEnd(iCommentBegin, data.size() - (data.back() == '\n')) - iCommentBegin);
+	return !vecRow.empty();
+}
+
+/**
+ * \brief
+ * Remove the rows (not the header) whose key is already used by a row above, keyed like find_duplicate.
+ * \param: vecRow: vector
+ * \return: uint32_t, removed rows
+ */
+auto CProtoChecker::remove_duplicate_rows(std::vector<SFixRow>& vecRow) -> uint32_t
+{
+	std::unordered_set<uint32_t> setVnum;
+	std::unordered_set<std::string> setOther;
+	setVnum.reserve(vecRow.size());
+
+	size_t iKept = 1;
+	for (size_t i = 1; i < vecRow.size(); ++i)
 	{
-		std::cout << e.what() << e.code() << std::endl;
+		const auto & row = vecRow[i];
+		const auto bFirst = row.numeric && !row.range ? setVnum.insert(row.vnum).second : setOther.insert(row.key).second;
+		if (!bFirst)
+			continue;
+
+		if (iKept != i)
+			vecRow[iKept] = std::move(vecRow[i]);
+		++iKept;
 	}
-	return {};
+
+	const auto iRemoved = vecRow.size() - iKept;
+	vecRow.resize(iKept);
+	return static_cast<uint32_t>(iRemoved);
 }
 
 /**
  * \brief
- * Strip a specific string from the beginning and at the end of the string.
- * \param: stSrc: string
- * \param: stFrom: string
+ * Sort the rows (not the header) by vnum, keys which aren't numbers go last.
+ * \param: vecRow: vector
  */
-auto CProtoChecker::strip_color(std::string & stSrc, const std::string& stFrom) -> void
+auto CProtoChecker::sort_rows(std::vector<SFixRow>& vecRow) -> void
 {
-	size_t iStartPos = 0;
-	while ((iStartPos = stSrc.find(stFrom, iStartPos)) != std::string::npos)
-		stSrc.replace(iStartPos, stFrom.length(), "");
+	std::stable_sort(vecRow.begin() + 1, vecRow.end(), [](const SFixRow& left, const SFixRow& right)
+	{
+		if (left.numeric != right.numeric)
+			return left.numeric;
+
+		return left.numeric ? left.vnum < right.vnum : left.key < right.key;
+	});
 }
 
 /**
  * \brief
- * Write a log line to console and specific log file.
- * \param: fmt: string
- * \param: ...: any
+ * Diff two revisions of a file row by row, rows are matched on their first field (the nth row with a vnum
+ * in the old file pairs with the nth one in the new file).
+ * Every row gets an XXH64 fingerprint of the columns both headers share, so matching and spotting the modified rows
+ * is one hash lookup per row; the fields are only compared, by column name, for the rows whose fingerprints differ.
+ * \param: stOldPath: string
+ * \param: stNewPath: string
+ * \return: bool, false if a file can't be loaded
  */
-auto CProtoChecker::write_log(const std::string fmt, ...) -> void
+auto CProtoChecker::diff(const std::string& stOldPath, const std::string& stNewPath) -> bool
 {
-	char cLogLine[512];
-	va_list args;
-	va_start(args, fmt);
-	_vsnprintf_s(cLogLine, sizeof(cLogLine), fmt.c_str(), args);
-	va_end(args);
+	cCsvTable oldTable, newTable;
+	oldTable.LoadMapped(stOldPath.c_str(), DELIMITER_TAB, '"');
+	newTable.LoadMapped(stNewPath.c_str(), DELIMITER_TAB, '"');
+	return diff_tables(oldTable, stOldPath, newTable, stNewPath);
+}
+
+/**
+ * \brief
+ * Diff two loaded revisions of a file, see diff. A table which failed to load has no rows.
+ * \param: oldTable: cCsvTable, loaded with every column
+ * \param: stOldPath: string
+ * \param: newTable: cCsvTable, loaded with every column
+ * \param: stNewPath: string
+ * \return: bool, false if a table has no rows
+ */
+auto CProtoChecker::diff_tables(const cCsvTable& oldTable, const std::string& stOldPath, const cCsvTable& newTable, const std::string& stNewPath) -> bool
+{
+	write_log("DIFF_START");
+	write_log("DIFF_FILES", stOldPath.c_str(), stNewPath.c_str());
+
+	for (const auto & it : { std::make_pair(&oldTable, &stOldPath), std::make_pair(&newTable, &stNewPath) })
+	{
+		if (it.first->RowCount() != 0)
+			continue;
+
+		write_log("DIFF_LOAD_FAILED", it.second->c_str());
+		write_log("DIFF_END");
+		m_LogSink.Flush();
+		return false;
+	}
+
+	// Both revisions are compared as UTF-8, a file saved in another encoding only reports this line.
+	if (oldTable.GetEncoding() != newTable.GetEncoding())
+		write_log("DIFF_ENCODING", cTextEncoding::GetName(oldTable.GetEncoding()), cTextEncoding::GetName(newTable.GetEncoding()));
+
+	const auto & oldFile = oldTable.m_MappedFile;
+	const auto & newFile = newTable.m_MappedFile;
+	const auto GetField = [](const cCsvMappedFile& file, size_t row, size_t col)
+	{
+		return col < file.GetColCount(row) ? file.GetField(row, col) : std::string_view();
+	};
+
+	// Columns are matched by header name, the fingerprints only cover the shared ones.
+	std::vector<std::pair<size_t, size_t>> vecSharedColumn;
+	for (size_t newCol = 0; newCol < newFile.GetColCount(0); ++newCol)
+	{
+		size_t oldCol = 0;
+		while (oldCol < oldFile.GetColCount(0) && oldFile.GetField(0, oldCol) != newFile.GetField(0, newCol))
+			++oldCol;
+
+		if (oldCol < oldFile.GetColCount(0))
+			vecSharedColumn.emplace_back(oldCol, newCol);
+		else
+			write_log("DIFF_COLUMN_ADDED", std::string(newFile.GetField(0, newCol)).c_str());
+	}
+
+	for (size_t oldCol = 0; oldCol < oldFile.GetColCount(0); ++oldCol)
+	{
+		if (std::none_of(vecSharedColumn.begin(), vecSharedColumn.end(), [oldCol](const std::pair<size_t, size_t>& column) { return column.first == oldCol; }))
+			write_log("DIFF_COLUMN_REMOVED", std::string(oldFile.GetField(0, oldCol)).c_str());
+	}
+
+	const auto Fingerprint = [&](const cCsvMappedFile& file, bool bOld)
+	{
+		std::vector<uint64_t> vecHash(file.GetRowCount());
+		static constexpr size_t BLOCK_SIZE = 1 << 14;
+		CThreadPool::Instance().ParallelFor((vecHash.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](size_t block)
+		{
+			const auto iEnd = std::min(vecHash.size(), (block + 1) * BLOCK_SIZE);
+			for (auto row = block * BLOCK_SIZE; row < iEnd; ++row)
+			{
+				uint64_t hash = 0;
+				for (const auto & column : vecSharedColumn)
+				{
+					const auto & field = GetField(file, row, bOld ? column.first : column.second);
+					hash = hash_xxh64(field.data(), field.size(), hash);
+				}
+
+				vecHash[row] = hash;
+			}
+		});
+
+		return vecHash;
+	};
+
+	const auto & vecOldHash = Fingerprint(oldFile, true);
+	const auto & vecNewHash = Fingerprint(newFile, false);
+
+	// Old rows by key, rows sharing a key are chained in file order.
+	static constexpr auto NO_ROW = UINT32_MAX;
+	std::unordered_map<std::string_view, std::pair<uint32_t, uint32_t>> mapOldRow;
+	std::vector<uint32_t> vecNextRow(oldFile.GetRowCount(), NO_ROW);
+	std::vector<bool> vecMatched(oldFile.GetRowCount(), false);
+	mapOldRow.reserve(oldFile.GetRowCount());
+
+	for (uint32_t row = 1; row < oldFile.GetRowCount(); ++row)
+	{
+		const auto & it = mapOldRow.try_emplace(GetField(oldFile, row, 0), row, row);
+		if (!it.second)
+		{
+			vecNextRow[it.first->second.second] = row;
+			it.first->second.second = row;
+		}
+	}
+
+	uint32_t iAdded = 0, iRemoved = 0, iModified = 0, iUnchanged = 0;
+	for (uint32_t row = 1; row < newFile.GetRowCount(); ++row)
+	{
+		const auto & key = GetField(newFile, row, 0);
+		const auto & stKey = std::string(key);
+		const auto it = mapOldRow.find(key);
+		if (it == mapOldRow.end() || it->second.first == NO_ROW)
+		{
+			write_finding("DIFF_ROW_ADDED", stNewPath.c_str(), newFile.GetLine(row), stKey.c_str());
+			++iAdded;
+			continue;
+		}
+
+		const auto oldRow = it->second.first;
+		it->second.first = vecNextRow[oldRow];
+		vecMatched[oldRow] = true;
+
+		if (vecOldHash[oldRow] == vecNewHash[row])
+		{
+			++iUnchanged;
+			continue;
+		}
+
+		write_finding("DIFF_ROW_MODIFIED", stNewPath.c_str(), newFile.GetLine(row), stKey.c_str());
+		for (const auto & column : vecSharedColumn)
+		{
+			const auto & oldField = GetField(oldFile, oldRow, column.first);
+			const auto & newField = GetField(newFile, row, column.second);
+			if (oldField != newField)
+				write_log("DIFF_FIELD", std::string(newFile.GetField(0, column.second)).c_str(), std::string(oldField).c_str(), std::string(newField).c_str());
+		}
 
-	std::string stLogLine = cLogLine;
-	std::cout << stLogLine << std::endl;
+		++iModified;
+	}
 
-	for (const auto & color: {COLOR_GREEN, COLOR_GRAY, COLOR_RED})
+	for (uint32_t row = 1; row < oldFile.GetRowCount(); ++row)
 	{
-		for (const auto & item : split_range(color, "%s"))
-			strip_color(stLogLine, item);
+		if (vecMatched[row])
+			continue;
+
+		write_finding("DIFF_ROW_REMOVED", stOldPath.c_str(), oldFile.GetLine(row), std::string(GetField(oldFile, row, 0)).c_str());
+		++iRemoved;
 	}
-	
-	m_vecLogFile.emplace_back(stLogLine);
+
+	write_log("DIFF_SUMMARY", iAdded, iRemoved, iModified, iUnchanged);
+	write_log("DIFF_END");
+	m_LogSink.Flush();
+	return true;
 }
 
 /**
  * \brief
- * Create the syslog file.
+ * Check the names files of several locales against the protos in one run.
+ * The proto vnum indices are built once and shared read-only, the locales are loaded and compared in parallel
+ * and logged in the given order, followed by a coverage matrix of the names missing in each locale.
+ * \param: vecLocalePath: vector, directories of the names files, relative to the root path and ending with '/'
  */
-auto CProtoChecker::create_file_log() -> void
+auto CProtoChecker::run_locales(const std::vector<std::string>& vecLocalePath) -> void
 {
-	std::ofstream outfile(LOG_FILE_NAME);
-	for (const auto & line : m_vecLogFile)
-		outfile << line << std::endl;
+	load_files();
 
-	outfile.close();
+	auto & pool = CThreadPool::Instance();
+	auto futItemIndex = pool.Submit([this] { return make_vnum_index(m_ItemProtoFile); });
+	auto futMobIndex = pool.Submit([this] { return make_vnum_index(m_MobProtoFile); });
+	const auto itemProtoIndex = futItemIndex.get();
+	const auto mobProtoIndex = futMobIndex.get();
+
+	std::vector<SLocaleResult> vecLocale(vecLocalePath.size());
+	pool.ParallelFor(vecLocale.size(), [&](size_t i)
+	{
+		auto & locale = vecLocale[i];
+		locale.path = vecLocalePath[i];
+		locale.itemNames = load_file(locale.path + ITEM_NAMES_FILE_NAME);
+		locale.mobNames = load_file(locale.path + MOB_NAMES_FILE_NAME);
+
+		if (std::get<EXISTS>(m_ItemProtoFile) && std::get<EXISTS>(locale.itemNames))
+		{
+			const auto & namesIndex = make_vnum_index(locale.itemNames);
+			locale.itemMissing = find_difference(itemProtoIndex, namesIndex);
+			locale.itemUnknown = find_difference(namesIndex, itemProtoIndex);
+		}
+
+		if (std::get<EXISTS>(m_MobProtoFile) && std::get<EXISTS>(locale.mobNames))
+		{
+			const auto & namesIndex = make_vnum_index(locale.mobNames);
+			locale.mobMissing = find_difference(mobProtoIndex, namesIndex);
+			locale.mobUnknown = find_difference(namesIndex, mobProtoIndex);
+		}
+	});
+
+	write_log("DUPLICATE_START");
+	find_duplicate(m_ItemProtoFile);
+	find_duplicate(m_MobProtoFile);
+	for (const auto & locale : vecLocale)
+	{
+		find_duplicate(locale.itemNames);
+		find_duplicate(locale.mobNames);
+	}
+	write_log("DUPLICATE_END");
+
+	write_log("COMPARE_START");
+	for (const auto & locale : vecLocale)
+	{
+		write_log("LOCALE_NAME", locale.path.c_str());
+		report_difference(m_ItemProtoFile, locale.itemNames, locale.itemMissing);
+		report_difference(locale.itemNames, m_ItemProtoFile, locale.itemUnknown);
+		report_difference(m_MobProtoFile, locale.mobNames, locale.mobMissing);
+		report_difference(locale.mobNames, m_MobProtoFile, locale.mobUnknown);
+	}
+	write_log("COMPARE_END");
+
+	write_log("COVERAGE_START");
+	report_coverage(m_ItemProtoFile, vecLocale, &SLocaleResult::itemNames, &SLocaleResult::itemMissing);
+	report_coverage(m_MobProtoFile, vecLocale, &SLocaleResult::mobNames, &SLocaleResult::mobMissing);
+	write_log("COVERAGE_END");
+
+	m_LogSink.Flush();
 }
 
 /**
  * \brief
- * Run the program.
+ * Log one row per proto key which has no name in at least one locale, with a column per locale:
+ * x: missing, .: present, -: the locale has no such names file.
+ * \param: fileProto: tuple
+ * \param: vecLocale: vector, from run_locales
+ * \param: pNames: names file of a locale
+ * \param: pMissing: proto keys without a name in a locale
  */
-auto CProtoChecker::run() -> void
+auto CProtoChecker::report_coverage(const TFileTuple& fileProto, const std::vector<SLocaleResult>& vecLocale, TFileTuple SLocaleResult::* pNames, SVnumDifference SLocaleResult::* pMissing) -> void
 {
-	write_log("###### START_CHECKING_FOR_DUPLICATE ######");
-	for (const auto & file : { m_ItemProtoFile, m_ItemNamesFile, m_MobProtoFile, m_MobNamesFile })
-		find_duplicate(file);
-	write_log("###### END_CHECKING_FOR_DUPLICATE ######");
+	if (!std::get<EXISTS>(fileProto))
+		return;
+
+	write_log("FILE_NAME", std::get<NAME>(fileProto).c_str());
+
+	std::string stHeader;
+	std::set<uint32_t> setVnum;
+	std::set<std::string> setOther;
+	for (const auto & locale : vecLocale)
+	{
+		if (!stHeader.empty())
+			stHeader += '\t';
+		stHeader.append(locale.path, 0, locale.path.find_last_not_of("/\\") + 1);
+
+		const auto & missing = locale.*pMissing;
+		missing.vnums.ForEach([&setVnum](uint32_t itemVnum) { setVnum.insert(itemVnum); });
+		setOther.insert(missing.other.begin(), missing.other.end());
+	}
+
+	write_log("COVERAGE_HEADER", stHeader.c_str());
+
+	const auto WriteRow = [&](const std::string& stItemVnum, const std::function<bool(const SVnumDifference&)>& IsMissing)
+	{
+		std::string stCells;
+		for (const auto & locale : vecLocale)
+		{
+			if (!stCells.empty())
+				stCells += '\t';
+
+			if (!std::get<EXISTS>(locale.*pNames))
+				stCells += '-';
+			else
+				stCells += IsMissing(locale.*pMissing) ? 'x' : '.';
+		}
+
+		write_log("COVERAGE_ROW", stItemVnum.c_str(), stCells.c_str());
+	};
+
+	for (const auto itemVnum : setVnum)
+		WriteRow(std::to_string(itemVnum), [itemVnum](const SVnumDifference& missing) { return missing.vnums.Contains(itemVnum); });
 
-	write_log("###### START_COMPARING ######");
-	compare(m_ItemProtoFile, m_ItemNamesFile);
-	compare(m_ItemNamesFile, m_ItemProtoFile);
-	compare(m_MobProtoFile, m_MobNamesFile);
-	compare(m_MobNamesFile, m_MobProtoFile);
-	write_log("###### END_COMPARING ######");
+	for (const auto & stItemVnum : setOther)
+		WriteRow(stItemVnum, [&stItemVnum](const SVnumDifference& missing) { return std::binary_search(missing.other.begin(), missing.other.end(), stItemVnum); });
 
-	create_file_log();
+	const auto iRowCount = static_cast<uint32_t>(setVnum.size() + setOther.size());
+	write_log(iRowCount == 0 ? "FILE_OK" : "FILE_TOTAL_LINES", iRowCount);
 }
\ No newline at end of file
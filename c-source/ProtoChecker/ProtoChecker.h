@@ -1,40 +1,330 @@
 #pragma once
+#include "VnumSet.h"
+#include "LogSink.h"
+#include "MappedFile.h"
+#include "ProtoSnapshot.h"
+#include "ColumnRules.h"
+#include <shared_mutex>
 
-using TFileTuple = std::tuple<std::string, std::vector<std::string>, bool, std::vector<std::tuple<uint32_t, uint32_t>>>;
+class cCsvTable;
+class cCsvMappedFile;
+class cLocalSocket;
+class cTokenDictionary;
+class CVnumRangeIndex;
 
 /**
  * \brief
- * Color configuration.
+ * Path configuration.
  */
-static const auto COLOR_GREEN = "\033[92m%s\033[00m";
-static const auto COLOR_RED = "\033[91m%s\033[00m";
-static const auto COLOR_GRAY = "\033[37m%s\033[00m";
+static const auto ROOT_PATH             = "resource/";
+static const auto LOG_FILE_NAME         = "syslog.txt";
+
+static const auto ITEM_PROTO_FILE_NAME  = "item_proto.txt";
+static const auto ITEM_NAMES_FILE_NAME  = "item_names.txt";
+static const auto MOB_PROTO_FILE_NAME   = "mob_proto.txt";
+static const auto MOB_NAMES_FILE_NAME   = "mob_names.txt";
+static const auto REFINE_PROTO_FILE_NAME = "refine_proto.txt";
+static const auto REFERENCE_RULES_FILE_NAME = "reference_rules.txt";
+static const auto COLUMN_RULES_FILE_NAME = "column_rules.txt";
+static const auto CLONE_RULES_FILE_NAME = "clone_rules.txt";
+static const auto PIPELINE_FILE_NAME    = "pipeline.txt";
+
+using TFileTuple = std::tuple<std::string, std::vector<std::string>, bool, std::vector<std::tuple<uint32_t, uint32_t>>, std::vector<uint32_t>>;
+
+/**
+ * \brief
+ * Vnum index of a loaded file.
+ * keys: the vnum of every row, a `~` range row is keyed on its first vnum.
+ * coverage: every single vnum plus every `~` range stored as a run.
+ * other: sorted keys which aren't plain numbers.
+ */
+struct SVnumIndex
+{
+	CVnumSet keys;
+	CVnumSet coverage;
+	std::vector<std::string> other;
+};
+
+/**
+ * \brief
+ * Reference from a column of a file to the keys of another file (its first column, `~` ranges included).
+ * whenColumn/whenValues: only rows whose whenColumn holds one of the values are checked, every row when empty.
+ */
+struct SReferenceRule
+{
+	std::string file;
+	std::string column;
+	std::string target;
+	std::string whenColumn;
+	std::vector<std::string> whenValues;
+};
+
+/**
+ * \brief
+ * Column of a file holding tokens of a closed set (item types, apply types, mob ranks, ...), see TokenTables.h.
+ */
+struct STokenColumn
+{
+	std::string file;
+	std::string column;
+	const cTokenDictionary* dictionary;
+};
+
+/**
+ * \brief
+ * File checked for rows copied under another key, rows are compared on every column but the ignored ones.
+ */
+struct SCloneRule
+{
+	std::string file;
+	std::vector<std::string> ignore;
+};
+
+/**
+ * \brief
+ * Kind of a pipeline check, the sections of the log follow this order.
+ */
+enum EPipelineCheck
+{
+	PIPELINE_DUPLICATE,
+	PIPELINE_COMPARE,
+	PIPELINE_REFERENCES,
+	PIPELINE_COLUMNS,
+	PIPELINE_TOKENS,
+	PIPELINE_RANGES,
+};
+
+/**
+ * \brief
+ * Check run by run(): the duplicated keys of file, the keys of file missing in target,
+ * or every reference/column rule, token column or vnum range (no file).
+ */
+struct SPipelineCheck
+{
+	EPipelineCheck type;
+	std::string file;
+	std::string target;
+};
+
+/**
+ * \brief
+ * File loaded once and shared by the checks which read it.
+ * keys: its keys (see load_file). index: their vnum index, nullptr when no check needs it.
+ * table: its rows with the key column and the columns the checks name, nullptr when only the keys are needed or it doesn't exist.
+ */
+struct SLoadedFile
+{
+	std::string name;
+	const TFileTuple* keys = nullptr;
+	const SVnumIndex* index = nullptr;
+	std::shared_ptr<const cCsvMappedFile> table;
+};
+
+/**
+ * \brief
+ * Outcome of rewriting a file in the fix mode.
+ */
+enum EFixResult
+{
+	FIX_UNCHANGED,
+	FIX_REWRITTEN,
+	FIX_FAILED,
+};
+
+/**
+ * \brief
+ * Row of a file rewritten by the fix mode.
+ * text: the row as it is in the file, with the comment and blank lines above it and without its line break.
+ * begin: offset of the row itself in text.
+ * key: first field, vnum: its first vnum when numeric is set (`~` ranges included, range is set for them).
+ */
+struct SFixRow
+{
+	std::string_view text;
+	size_t begin;
+	std::string key;
+	uint32_t vnum;
+	bool numeric;
+	bool range;
+};
+
+/**
+ * \brief
+ * Keys of an examined file which the searched file doesn't cover.
+ */
+struct SVnumDifference
+{
+	CVnumSet vnums;
+	std::vector<std::string> other;
+};
+
+/**
+ * \brief
+ * Names files of one locale and their differences with the protos, filled in parallel by run_locales.
+ * itemMissing/mobMissing: proto keys without a name.
+ * itemUnknown/mobUnknown: names keys without a proto row.
+ */
+struct SLocaleResult
+{
+	std::string path;
+	TFileTuple itemNames, mobNames;
+	SVnumDifference itemMissing, itemUnknown;
+	SVnumDifference mobMissing, mobUnknown;
+};
+
+/**
+ * \brief
+ * Row counts of a file kept up to date by the watch mode, so an edit only touches the keys of the edited rows.
+ * duplicates: keyed like find_duplicate, plain numbers first.
+ * keys/other: compared keys, like SVnumIndex::keys/other.
+ * singles/ranges: single vnums and `~` ranges, like SVnumIndex::coverage.
+ */
+struct SFileState
+{
+	std::map<std::pair<uint32_t, std::string>, uint32_t> duplicates;
+	std::map<uint32_t, uint32_t> keys;
+	std::map<std::string, uint32_t> other;
+	std::unordered_map<uint32_t, uint32_t> singles;
+	std::map<std::pair<uint32_t, uint32_t>, uint32_t> ranges;
+};
+
+/**
+ * \brief
+ * Keys touched by an edit of a file, duplicates keep the row count the key had before the edit.
+ */
+struct STouchedKeys
+{
+	std::map<std::pair<uint32_t, std::string>, uint32_t> duplicates;
+	std::set<uint32_t> vnums;
+	std::set<std::string> other;
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+};
+
+/**
+ * \brief
+ * Missing keys of a compared pair of files, kept by the watch mode.
+ */
+struct SCompareState
+{
+	size_t examine;
+	size_t search;
+	std::set<uint32_t> missing;
+	std::set<std::string> missingOther;
+};
+
+/**
+ * \brief
+ * File kept in memory by the daemon, it's reloaded when its size or write time changes.
+ * singles/ranges/other: (key, line) of the rows for the vnum queries, sorted by key; other views into the loaded file.
+ * table: every column of the file, read on the first diff against it.
+ * result/references: JSON lines of the last check of the file and of its references.
+ */
+struct SDaemonFile
+{
+	SSnapshotSource source;
+	SVnumIndex index;
+	std::vector<std::pair<uint32_t, uint32_t>> singles;
+	std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> ranges;
+	std::vector<std::pair<std::string_view, uint32_t>> other;
+	std::shared_ptr<const cCsvTable> table;
+	std::string result;
+	std::string references;
+};
 
 class CProtoChecker
 {
-	std::vector<std::string> m_vecLogFile;
+	std::string m_stRootPath;
+	bool m_bSnapshot;
+	cLogSink m_LogSink;
 	TFileTuple m_ItemProtoFile, m_ItemNamesFile, m_MobProtoFile, m_MobNamesFile;
+	std::vector<bool> m_vecFileLoaded;
+	std::vector<SFileState> m_vecFileState;
+	std::vector<SCompareState> m_vecCompareState;
+	std::vector<SDaemonFile> m_vecDaemonFile;
+	std::vector<SReferenceRule> m_vecDaemonRule;
+	std::shared_mutex m_DaemonMutex;
+	std::mutex m_DaemonTableMutex;
 
 	enum EFile
 	{
 		NAME,
 		DATA,
 		EXISTS,
+		RANGE,
+		LINE,
 	};
 	
 	public:
-		CProtoChecker();
+		explicit CProtoChecker(const std::string& stRootPath = ROOT_PATH, bool bSnapshot = true);
 		virtual ~CProtoChecker();
 
 		auto run() -> void;
+		auto load_files() -> void;
 		auto find_duplicate(const TFileTuple &) -> void;
 		auto compare(const TFileTuple &, const TFileTuple &) -> void;
+		auto compare(const TFileTuple &, const SVnumIndex &, const TFileTuple &, const SVnumIndex &) -> void;
+		auto report_difference(const TFileTuple &, const TFileTuple &, const SVnumDifference &) -> void;
+		static auto find_difference(const SVnumIndex &, const SVnumIndex &) -> SVnumDifference;
+
+		auto diff(const std::string &, const std::string &) -> bool;
+		auto diff_tables(const cCsvTable &, const std::string &, const cCsvTable &, const std::string &) -> bool;
+
+		auto check_similar_names() -> void;
+		auto find_similar_names(const std::string &) -> void;
+
+		auto load_clone_rules() const -> std::vector<SCloneRule>;
+		auto check_clone_rows(const std::vector<SCloneRule> &) -> void;
+		auto find_clone_rows(const SCloneRule &) -> void;
+
+		auto check_ranges(const std::vector<const SLoadedFile*> &) -> void;
+		auto find_free_vnums(uint32_t, uint32_t) -> void;
+		static auto add_range_keys(const TFileTuple &, uint32_t, CVnumRangeIndex &) -> void;
+
+		auto run_locales(const std::vector<std::string> &) -> void;
+		auto report_coverage(const TFileTuple &, const std::vector<SLocaleResult> &, TFileTuple SLocaleResult::*, SVnumDifference SLocaleResult::*) -> void;
+
+		auto watch() -> void;
+		auto reload_file(size_t) -> void;
+		auto update_compare(SCompareState &, const std::set<uint32_t> &, const std::set<std::string> &, bool) -> size_t;
+		auto get_file(size_t) -> TFileTuple &;
+		static auto update_file_state(SFileState &, const TFileTuple &, size_t, size_t, bool, STouchedKeys &) -> void;
+		static auto is_covered(const SFileState &, uint32_t) -> bool;
+
+		auto serve(const std::string &) -> bool;
+		auto serve_client(cLocalSocket &) -> void;
+		auto refresh_daemon_files() -> void;
+		auto load_daemon_file(size_t) -> void;
+		auto check_daemon_file(size_t, bool) -> void;
+		auto find_daemon_file(const std::string &) -> size_t;
+		auto query_vnum(const std::string &) -> void;
+		auto query_diff(size_t, std::string) -> bool;
+
+		auto write_log(const char*, ...) -> void;
+		auto write_finding(const char*, const char*, uint32_t, ...) -> void;
+		auto push_log(const char*, const char*, uint32_t, va_list) -> void;
+		auto add_log_writer(std::unique_ptr<cLogWriter>) -> void;
 
-		auto write_log(const std::string, ...) -> void;
-		auto create_file_log() -> void;
+		auto fix(bool) -> void;
+		auto fix_pair(const std::string&, const std::string&, bool) -> void;
+		auto write_fix_file(const std::string&, cMappedFile&, const std::vector<SFixRow>&, const std::string&, std::string_view, bool) -> EFixResult;
+		auto log_fix_result(const std::string&, EFixResult, bool, uint32_t, uint32_t) -> void;
+		static auto read_fix_rows(const cMappedFile&, std::vector<SFixRow>&, std::string&, std::string_view&) -> bool;
+		static auto remove_duplicate_rows(std::vector<SFixRow>&) -> uint32_t;
+		static auto sort_rows(std::vector<SFixRow>&) -> void;
 
-		auto load_file(const std::string&) const -> TFileTuple;
+		auto load_snapshot(const std::string&, TFileTuple&) const -> bool;
+		auto load_table(const std::string&, const std::vector<std::string>&) const -> std::shared_ptr<cCsvMappedFile>;
+		auto load_file(const std::string&, const std::vector<std::string>& = {}, std::shared_ptr<const cCsvMappedFile>* = nullptr) const -> TFileTuple;
+		static auto find_loaded(const std::vector<const SLoadedFile*>&, const std::string&) -> const SLoadedFile*;
+		static auto find_columns(const cCsvMappedFile&, const std::vector<std::string>&) -> std::vector<int>;
+		auto load_reference_rules() const -> std::vector<SReferenceRule>;
+		auto check_references(const std::vector<SReferenceRule>&, const std::vector<const SLoadedFile*>&) -> void;
+		auto load_column_rules() const -> std::vector<SColumnRule>;
+		auto check_columns(const std::vector<SColumnRule>&, const std::vector<const SLoadedFile*>&) -> void;
+		auto check_tokens(const std::vector<STokenColumn>&, const std::vector<const SLoadedFile*>&) -> void;
+		auto load_pipeline() -> std::vector<SPipelineCheck>;
+		auto run_pipeline(const std::vector<SPipelineCheck>&) -> void;
+		static auto make_vnum_index(const TFileTuple&) -> SVnumIndex;
 
 		static auto split_range(const std::string&, const std::string&) -> std::vector<std::string>;
-		static auto strip_color(std::string&, const std::string&) -> void;
 };
\ No newline at end of file
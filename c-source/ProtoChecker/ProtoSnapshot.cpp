@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "ProtoSnapshot.h"
+#include "Hash.h"
+#include <filesystem>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * \brief
+ * Size and modification time of a file.
+ * \param: sourcePath: string
+ * \return: SSnapshotSource, exists is false if the file can't be stat'ed
+ */
+auto cProtoSnapshot::GetSource(const std::string& sourcePath) -> SSnapshotSource
+{
+	SSnapshotSource source;
+	std::error_code error;
+
+	const auto size = std::filesystem::file_size(sourcePath, error);
+	if (error)
+		return source;
+
+	const auto time = std::filesystem::last_write_time(sourcePath, error);
+	if (error)
+		return source;
+
+	source.exists = true;
+	source.size = size;
+	source.time = static_cast<int64_t>(time.time_since_epoch().count());
+	return source;
+}
+
+/**
+ * \brief
+ * Write the snapshot of a parsed source.
+ * It's written to a temporary file and renamed over the old snapshot, so a reader never maps a partial file.
+ * \param: sourcePath: string
+ * \param: source: SSnapshotSource, taken before the source was parsed
+ * \param: content: string_view, the parsed bytes
+ * \param: vecVnum: vector, vnum column of every row
+ * \param: vecLine: vector, line of every row
+ * \param: vecRange: vector, `~` ranges
+ * \return: bool, false if the snapshot can't be written (read-only directory, source changed while parsing)
+ */
+auto cProtoSnapshot::Write(const std::string& sourcePath, const SSnapshotSource& source, std::string_view content,
+	const std::vector<std::string>& vecVnum, const std::vector<uint32_t>& vecLine, const std::vector<std::tuple<uint32_t, uint32_t>>& vecRange) -> bool
+{
+	if (!source.exists || source.size != content.size() || vecVnum.size() != vecLine.size())
+		return false;
+
+	// Most vnums are distinct, but names files repeat them and the strings section is stored once.
+	std::unordered_map<std::string_view, uint32_t> mapString;
+	std::vector<uint32_t> vecPayload;
+	std::string stStrings;
+
+	mapString.reserve(vecVnum.size());
+	vecPayload.reserve(vecVnum.size() * 3 + vecRange.size() * 2 + 1);
+
+	std::vector<uint32_t> vecStringOffset{ 0 };
+	for (const auto & stVnum : vecVnum)
+	{
+		const auto it = mapString.emplace(stVnum, static_cast<uint32_t>(mapString.size())).first;
+		if (it->second + 1 == vecStringOffset.size())
+		{
+			stStrings += stVnum;
+			vecStringOffset.push_back(static_cast<uint32_t>(stStrings.size()));
+		}
+
+		vecPayload.push_back(it->second);
+	}
+
+	vecPayload.insert(vecPayload.end(), vecLine.begin(), vecLine.end());
+	for (const auto & range : vecRange)
+	{
+		vecPayload.push_back(std::get<0>(range));
+		vecPayload.push_back(std::get<1>(range));
+	}
+
+	vecPayload.insert(vecPayload.end(), vecStringOffset.begin(), vecStringOffset.end());
+
+	SHeader header {};
+	std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+	header.version = VERSION;
+	header.sourceSize = source.size;
+	header.sourceTime = source.time;
+	header.sourceHash = hash_xxh64(content.data(), content.size());
+	header.rowCount = static_cast<uint32_t>(vecVnum.size());
+	header.rangeCount = static_cast<uint32_t>(vecRange.size());
+	header.stringCount = static_cast<uint32_t>(vecStringOffset.size() - 1);
+	header.stringBytes = static_cast<uint32_t>(stStrings.size());
+
+	if (IsRacy(source.time))
+		header.flags |= FLAG_RACY;
+
+	const auto payloadBytes = vecPayload.size() * sizeof(uint32_t);
+	const auto payloadHash = hash_xxh64(vecPayload.data(), payloadBytes);
+	header.payloadHash = hash_xxh64(stStrings.data(), stStrings.size(), payloadHash);
+
+	const auto & stSnapshotPath = GetSnapshotPath(sourcePath);
+	const auto & stTemporaryPath = stSnapshotPath + ".tmp";
+	{
+		std::ofstream file(stTemporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(vecPayload.data()), static_cast<std::streamsize>(payloadBytes));
+		file.write(stStrings.data(), static_cast<std::streamsize>(stStrings.size()));
+		if (!file.good())
+		{
+			file.close();
+			std::remove(stTemporaryPath.c_str());
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(stTemporaryPath, stSnapshotPath, error);
+	if (error)
+	{
+		std::remove(stTemporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * \brief
+ * Map the snapshot of a source and check that it still describes the source.
+ * \param: sourcePath: string
+ * \return: bool, false if there's no snapshot or it's damaged, of another version or stale
+ */
+auto cProtoSnapshot::Open(const std::string& sourcePath) -> bool
+{
+	Close();
+
+	if (!m_Mapping.Open(GetSnapshotPath(sourcePath).c_str()) || !Validate(sourcePath))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+auto cProtoSnapshot::Close() -> void
+{
+	m_Mapping.Close();
+	m_pHeader = nullptr;
+	m_pRowStrings = nullptr;
+	m_pRowLines = nullptr;
+	m_pRanges = nullptr;
+	m_pStringOffsets = nullptr;
+	m_pStrings = nullptr;
+}
+
+/**
+ * \brief
+ * Whether a source was modified so recently that another write could keep its size and time.
+ * \param: time: int64_t, modification time of the source
+ * \return: bool
+ */
+auto cProtoSnapshot::IsRacy(int64_t time) -> bool
+{
+	const auto age = std::filesystem::file_time_type::clock::now().time_since_epoch() - std::filesystem::file_time_type::duration(time);
+	return age < std::chrono::milliseconds(RACY_INTERVAL_MS);
+}
+
+auto cProtoSnapshot::HashSource(const std::string& sourcePath, uint64_t& hash) -> bool
+{
+	cMappedFile source;
+	if (!source.Open(sourcePath.c_str()))
+		return false;
+
+	hash = hash_xxh64(source.Data(), source.Size());
+	return true;
+}
+
+/**
+ * \brief
+ * Check the layout and checksum of the mapped snapshot, then compare it with the source.
+ * \param: sourcePath: string
+ * \return: bool
+ */
+auto cProtoSnapshot::Validate(const std::string& sourcePath) -> bool
+{
+	if (m_Mapping.Size() < sizeof(SHeader))
+		return false;
+
+	const auto pHeader = reinterpret_cast<const SHeader*>(m_Mapping.Data());
+	if (!std::equal(std::begin(MAGIC), std::end(MAGIC), pHeader->magic) || pHeader->version != VERSION)
+		return false;
+
+	const auto payloadWords = uint64_t(pHeader->rowCount) * 2 + uint64_t(pHeader->rangeCount) * 2 + uint64_t(pHeader->stringCount) + 1;
+	const auto payloadBytes = payloadWords * sizeof(uint32_t);
+	if (m_Mapping.Size() != sizeof(SHeader) + payloadBytes + pHeader->stringBytes)
+		return false;
+
+	const auto source = GetSource(sourcePath);
+	if (!source.exists || source.size != pHeader->sourceSize)
+		return false;
+
+	const auto pPayload = m_Mapping.Data() + sizeof(SHeader);
+	const auto payloadHash = hash_xxh64(pPayload, payloadBytes);
+	if (hash_xxh64(pPayload + payloadBytes, pHeader->stringBytes, payloadHash) != pHeader->payloadHash)
+		return false;
+
+	if (source.time != pHeader->sourceTime || (pHeader->flags & FLAG_RACY))
+	{
+		uint64_t sourceHash;
+		if (!HashSource(sourcePath, sourceHash) || sourceHash != pHeader->sourceHash)
+			return false;
+
+		// Same content, record the new time so the next start skips the hash again.
+		const uint32_t flags = IsRacy(source.time) ? FLAG_RACY : 0;
+		if (source.time != pHeader->sourceTime || flags != pHeader->flags)
+		{
+			std::fstream file(GetSnapshotPath(sourcePath), std::ios::in | std::ios::out | std::ios::binary);
+			file.seekp(offsetof(SHeader, flags));
+			file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+			file.seekp(offsetof(SHeader, sourceTime));
+			file.write(reinterpret_cast<const char*>(&source.time), sizeof(source.time));
+		}
+	}
+
+	m_pHeader = pHeader;
+	m_pRowStrings = reinterpret_cast<const uint32_t*>(pPayload);
+	m_pRowLines = m_pRowStrings + pHeader->rowCount;
+	m_pRanges = m_pRowLines + pHeader->rowCount;
+	m_pStringOffsets = m_pRanges + uint64_t(pHeader->rangeCount) * 2;
+	m_pStrings = pPayload + payloadBytes;
+
+	// The checksum matched, this only guards against a snapshot written by a broken build.
+	if (m_pStringOffsets[pHeader->stringCount] != pHeader->stringBytes)
+		return false;
+
+	for (uint32_t row = 0; row < pHeader->rowCount; ++row)
+	{
+		if (m_pRowStrings[row] >= pHeader->stringCount)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "MappedFile.h"
+
+/**
+ * \brief
+ * Size and modification time of a source file, taken before it's parsed.
+ */
+struct SSnapshotSource
+{
+	bool exists = false;
+	uint64_t size = 0;
+	int64_t time = 0;
+};
+
+/**
+ * \brief
+ * Binary snapshot of the vnum column of a proto file, stored next to the source as <source>.snap.
+ * The file is memory mapped and read in place, every section is an array of uint32_t:
+ * header | row string ids | row lines | ranges (first, last) | string offsets (count + 1) | string bytes
+ * A snapshot is used only if the source has the recorded size and modification time,
+ * when only the time differs (checkout, touch) the source content hash decides and the time is refreshed.
+ */
+class cProtoSnapshot
+{
+	private:
+		static constexpr char MAGIC[8] = { 'P', 'C', 'S', 'N', 'A', 'P', '\r', '\n' };
+		static constexpr uint32_t VERSION = 1;
+		static constexpr auto FILE_EXTENSION = ".snap";
+
+		/**
+		 * \brief
+		 * Sources modified less than RACY_INTERVAL_MS before the snapshot was written may change again
+		 * without a visible time change, their content hash is always checked.
+		 */
+		static constexpr int64_t RACY_INTERVAL_MS = 2000;
+
+		enum EFlag : uint32_t
+		{
+			FLAG_RACY = 1 << 0,
+		};
+
+		/**
+		 * \brief
+		 * payloadHash: XXH64 of everything after the header.
+		 */
+		struct SHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t flags;
+			uint64_t sourceSize;
+			int64_t sourceTime;
+			uint64_t sourceHash;
+			uint64_t payloadHash;
+			uint32_t rowCount;
+			uint32_t rangeCount;
+			uint32_t stringCount;
+			uint32_t stringBytes;
+		};
+
+		cMappedFile m_Mapping;
+		const SHeader* m_pHeader = nullptr;
+		const uint32_t* m_pRowStrings = nullptr;
+		const uint32_t* m_pRowLines = nullptr;
+		const uint32_t* m_pRanges = nullptr;
+		const uint32_t* m_pStringOffsets = nullptr;
+		const char* m_pStrings = nullptr;
+
+	public:
+		cProtoSnapshot() = default;
+		virtual ~cProtoSnapshot() = default;
+
+	public:
+		static auto GetSource(const std::string& sourcePath) -> SSnapshotSource;
+		static auto Write(const std::string& sourcePath, const SSnapshotSource& source, std::string_view content,
+			const std::vector<std::string>& vecVnum, const std::vector<uint32_t>& vecLine, const std::vector<std::tuple<uint32_t, uint32_t>>& vecRange) -> bool;
+
+		auto Open(const std::string& sourcePath) -> bool;
+		auto Close() -> void;
+
+		auto GetRowCount() const -> size_t
+		{
+			return m_pHeader->rowCount;
+		}
+
+		auto GetVnum(size_t row) const -> std::string_view
+		{
+			const auto id = m_pRowStrings[row];
+			return std::string_view(m_pStrings + m_pStringOffsets[id], m_pStringOffsets[id + 1] - m_pStringOffsets[id]);
+		}
+
+		auto GetLine(size_t row) const -> uint32_t
+		{
+			return m_pRowLines[row];
+		}
+
+		auto GetRangeCount() const -> size_t
+		{
+			return m_pHeader->rangeCount;
+		}
+
+		auto GetRange(size_t index) const -> std::tuple<uint32_t, uint32_t>
+		{
+			return std::make_tuple(m_pRanges[index * 2], m_pRanges[index * 2 + 1]);
+		}
+
+	private:
+		static auto GetSnapshotPath(const std::string& sourcePath) -> std::string
+		{
+			return sourcePath + FILE_EXTENSION;
+		}
+
+		static auto IsRacy(int64_t time) -> bool;
+		static auto HashSource(const std::string& sourcePath, uint64_t& hash) -> bool;
+		auto Validate(const std::string& sourcePath) -> bool;
+
+		cProtoSnapshot(const cProtoSnapshot&) {}
+
+		auto operator =(const cProtoSnapshot&) const -> const cProtoSnapshot&
+		{
+			return *this;
+		}
+};
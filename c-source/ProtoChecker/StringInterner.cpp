@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "StringInterner.h"
+
+/**
+ * \brief
+ * Get the id of a string, adding it to the pool the first time it is seen.
+ * \param: text: string_view
+ * \return: uint32_t
+ */
+auto cStringInterner::Intern(std::string_view text) -> uint32_t
+{
+	uint32_t id;
+	if (Find(text, id))
+		return id;
+
+	std::unique_lock<std::shared_mutex> lock(m_Mutex);
+	return InternLocked(text);
+}
+
+/**
+ * \brief
+ * Intern a batch of strings under a single lock.
+ * \param: vecText: vector
+ * \return: vector, the id of every string in the same order
+ */
+auto cStringInterner::InternBatch(const std::vector<std::string_view>& vecText) -> std::vector<uint32_t>
+{
+	std::vector<uint32_t> vecId;
+	vecId.reserve(vecText.size());
+
+	std::unique_lock<std::shared_mutex> lock(m_Mutex);
+	for (const auto & text : vecText)
+		vecId.push_back(InternLocked(text));
+
+	return vecId;
+}
+
+auto cStringInterner::Find(std::string_view text, uint32_t& id) const -> bool
+{
+	std::shared_lock<std::shared_mutex> lock(m_Mutex);
+	const auto it = m_mapIndex.find(text);
+	if (it == m_mapIndex.end())
+		return false;
+
+	id = it->second;
+	return true;
+}
+
+auto cStringInterner::Get(uint32_t id) const -> std::string_view
+{
+	std::shared_lock<std::shared_mutex> lock(m_Mutex);
+	return id < m_vecStrings.size() ? m_vecStrings[id] : std::string_view();
+}
+
+auto cStringInterner::Size() const -> size_t
+{
+	std::shared_lock<std::shared_mutex> lock(m_Mutex);
+	return m_vecStrings.size();
+}
+
+/**
+ * \brief
+ * Approximate number of bytes held by the pool.
+ * \return: size_t
+ */
+auto cStringInterner::MemoryUsage() const -> size_t
+{
+	std::shared_lock<std::shared_mutex> lock(m_Mutex);
+	return m_StorageBytes + m_Storage.size() * sizeof(std::string) + m_vecStrings.size() * sizeof(std::string_view)
+		+ m_mapIndex.size() * (sizeof(std::string_view) + sizeof(uint32_t) + sizeof(void*)) + m_mapIndex.bucket_count() * sizeof(void*);
+}
+
+auto cStringInterner::InternLocked(std::string_view text) -> uint32_t
+{
+	const auto it = m_mapIndex.find(text);
+	if (it != m_mapIndex.end())
+		return it->second;
+
+	const auto & stored = m_Storage.emplace_back(text);
+	const auto id = static_cast<uint32_t>(m_vecStrings.size());
+	m_vecStrings.emplace_back(stored);
+	m_mapIndex.emplace(m_vecStrings.back(), id);
+	m_StorageBytes += text.size() + 1;
+	return id;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+/**
+ * \brief
+ * Thread safe string pool, every distinct string is stored once and identified by a dense id.
+ * Ids are stable for the lifetime of the interner, so they can be shared by every table built on it.
+ */
+class cStringInterner
+{
+	private:
+		mutable std::shared_mutex m_Mutex;
+		std::deque<std::string> m_Storage;
+		std::vector<std::string_view> m_vecStrings;
+		std::unordered_map<std::string_view, uint32_t> m_mapIndex;
+		size_t m_StorageBytes = 0;
+
+	public:
+		cStringInterner() = default;
+		virtual ~cStringInterner() = default;
+
+	public:
+		auto Intern(std::string_view text) -> uint32_t;
+		auto InternBatch(const std::vector<std::string_view>& vecText) -> std::vector<uint32_t>;
+		auto Find(std::string_view text, uint32_t& id) const -> bool;
+		auto Get(uint32_t id) const -> std::string_view;
+		auto Size() const -> size_t;
+		auto MemoryUsage() const -> size_t;
+
+	private:
+		auto InternLocked(std::string_view text) -> uint32_t;
+
+		cStringInterner(const cStringInterner&) {}
+
+		auto operator =(const cStringInterner&) const -> const cStringInterner&
+		{
+			return *this;
+		}
+};
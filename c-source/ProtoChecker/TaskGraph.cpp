@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "TaskGraph.h"
+#include "ThreadPool.h"
+
+/**
+ * \brief
+ * Add a task which runs once every one of its dependencies finished.
+ * \param: func: function
+ * \param: vecDependency: vector<size_t>, ids returned by earlier Add calls
+ * \return: size_t, id of the task
+ */
+auto CTaskGraph::Add(std::function<void()> func, const std::vector<size_t>& vecDependency) -> size_t
+{
+	const auto id = m_vecNode.size();
+	auto node = std::make_unique<SNode>();
+	node->func = std::move(func);
+
+	for (const auto dependency : vecDependency)
+	{
+		if (dependency >= id)
+			continue;
+
+		m_vecNode[dependency]->vecDependent.emplace_back(id);
+		++node->dependencyCount;
+	}
+
+	m_vecNode.emplace_back(std::move(node));
+	return id;
+}
+
+/**
+ * \brief
+ * Run every task and wait for all of them, the calling thread runs queued tasks meanwhile.
+ * \param: pool: CThreadPool
+ */
+auto CTaskGraph::Run(CThreadPool& pool) -> void
+{
+	std::atomic<size_t> unfinished(m_vecNode.size());
+	for (const auto & node : m_vecNode)
+		node->remaining = node->dependencyCount;
+
+	for (size_t i = 0; i < m_vecNode.size(); ++i)
+	{
+		if (m_vecNode[i]->dependencyCount == 0)
+			Schedule(pool, i, unfinished);
+	}
+
+	pool.WaitUntil([&unfinished] { return unfinished == 0; });
+}
+
+/**
+ * \brief
+ * Queue a ready task; when it finished it queues the dependents it was the last dependency of.
+ * \param: pool: CThreadPool
+ * \param: node: size_t
+ * \param: unfinished: atomic<size_t>, tasks of the run not finished yet
+ */
+auto CTaskGraph::Schedule(CThreadPool& pool, size_t node, std::atomic<size_t>& unfinished) -> void
+{
+	pool.Enqueue([this, &pool, node, &unfinished]
+	{
+		const auto & current = *m_vecNode[node];
+		current.func();
+
+		for (const auto dependent : current.vecDependent)
+		{
+			if (--m_vecNode[dependent]->remaining == 0)
+				Schedule(pool, dependent, unfinished);
+		}
+
+		--unfinished;
+	});
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <functional>
+#include <atomic>
+#include <memory>
+
+class CThreadPool;
+
+/**
+ * \brief
+ * Tasks with dependencies between them, run on the thread pool.
+ * A task is queued as soon as its last dependency finished, by the worker which finished it, so it's usually
+ * picked up by that same worker while idle workers steal the other ready tasks.
+ * Dependencies must be added before their dependents, which keeps the graph free of cycles.
+ */
+class CTaskGraph
+{
+	private:
+		struct SNode
+		{
+			std::function<void()> func;
+			std::vector<size_t> vecDependent;
+			size_t dependencyCount = 0;
+			std::atomic<size_t> remaining{ 0 };
+		};
+
+		std::vector<std::unique_ptr<SNode>> m_vecNode;
+
+	public:
+		CTaskGraph() = default;
+		virtual ~CTaskGraph() = default;
+
+	public:
+		auto Add(std::function<void()> func, const std::vector<size_t>& vecDependency = {}) -> size_t;
+		auto Run(CThreadPool& pool) -> void;
+
+		auto GetSize() const -> size_t
+		{
+			return m_vecNode.size();
+		}
+
+	private:
+		auto Schedule(CThreadPool& pool, size_t node, std::atomic<size_t>& unfinished) -> void;
+
+		CTaskGraph(const CTaskGraph&) {}
+
+		auto operator =(const CTaskGraph&) const -> const CTaskGraph&
+		{
+			return *this;
+		}
+};
@@ -0,0 +1,310 @@
+#include "pch.h"
+#include "TextEncoding.h"
+#include "CsvScanner.h"
+#include "CodePageTables.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define TEXT_ENCODING_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#define TEXT_TARGET_AVX2
+	#else
+		#define TEXT_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace
+{
+	static constexpr uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+	static constexpr size_t UTF8_BOM_SIZE = 3;
+
+	/**
+	 * \brief
+	 * Offset of the first byte with the high bit set from pos, or of the unscanned tail (fewer than 8 bytes).
+	 */
+	auto FindNonAsciiScalar(const char* data, size_t pos, size_t size) -> size_t
+	{
+		for (; pos + 8 <= size; pos += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, data + pos, sizeof(word));
+			if (word & 0x8080808080808080ULL)
+				return pos + count_trailing_zeros(word & 0x8080808080808080ULL) / 8;
+		}
+		return pos;
+	}
+
+#ifdef TEXT_ENCODING_X86
+	auto FindNonAsciiSSE2(const char* data, size_t pos, size_t size) -> size_t
+	{
+		for (; pos + 64 <= size; pos += 64)
+		{
+			const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+			const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 16));
+			const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 32));
+			const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 48));
+			if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) == 0)
+				continue;
+
+			const auto mask = static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(a)) | (static_cast<uint32_t>(_mm_movemask_epi8(b)) << 16)) |
+				(static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(c)) | (static_cast<uint32_t>(_mm_movemask_epi8(d)) << 16)) << 32);
+			return pos + count_trailing_zeros(mask);
+		}
+		return pos;
+	}
+
+	TEXT_TARGET_AVX2 auto FindNonAsciiAVX2(const char* data, size_t pos, size_t size) -> size_t
+	{
+		for (; pos + 64 <= size; pos += 64)
+		{
+			const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+			const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 32));
+			if (_mm256_movemask_epi8(_mm256_or_si256(a, b)) == 0)
+				continue;
+
+			const auto mask = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(a))) |
+				(static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(b))) << 32);
+			return pos + count_trailing_zeros(mask);
+		}
+		return pos;
+	}
+#endif
+
+	/**
+	 * \brief
+	 * Length of the UTF-8 sequence at p, 0 if it's malformed, overlong, a surrogate or past U+10FFFF.
+	 */
+	auto GetUtf8Length(const unsigned char* p, size_t available) -> size_t
+	{
+		const auto IsContinuation = [](unsigned char c) { return (c & 0xC0) == 0x80; };
+		const auto lead = p[0];
+
+		if (lead < 0xC2 || lead > 0xF4)
+			return 0;
+
+		if (lead < 0xE0)
+			return available >= 2 && IsContinuation(p[1]) ? 2 : 0;
+
+		if (lead < 0xF0)
+		{
+			if (available < 3 || !IsContinuation(p[2]))
+				return 0;
+
+			const auto low = lead == 0xE0 ? 0xA0 : 0x80;
+			const auto high = lead == 0xED ? 0x9F : 0xBF;
+			return p[1] >= low && p[1] <= high ? 3 : 0;
+		}
+
+		if (available < 4 || !IsContinuation(p[2]) || !IsContinuation(p[3]))
+			return 0;
+
+		const auto low = lead == 0xF0 ? 0x90 : 0x80;
+		const auto high = lead == 0xF4 ? 0x8F : 0xBF;
+		return p[1] >= low && p[1] <= high ? 4 : 0;
+	}
+
+	/**
+	 * \brief
+	 * Code point of the CP949 sequence at p, 0 if there's no valid double byte sequence.
+	 */
+	auto GetCp949CodePoint(const unsigned char* p, size_t available) -> uint32_t
+	{
+		if (available < 2 || p[0] < CP949_LEAD_FIRST || p[0] > CP949_LEAD_LAST || p[1] < CP949_TRAIL_FIRST || p[1] > CP949_TRAIL_LAST)
+			return 0;
+
+		return CP949_TABLE[(p[0] - CP949_LEAD_FIRST) * CP949_TRAIL_COUNT + p[1] - CP949_TRAIL_FIRST];
+	}
+
+	/**
+	 * \brief
+	 * Write a code point of the basic multilingual plane past U+007F, every code page maps into it.
+	 */
+	auto WriteUtf8(char* out, uint32_t codePoint) -> char*
+	{
+		if (codePoint < 0x800)
+		{
+			out[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+			out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			return out + 2;
+		}
+
+		out[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+		out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		return out + 3;
+	}
+
+	auto HasUtf8Bom(std::string_view text) -> bool
+	{
+		return text.size() >= UTF8_BOM_SIZE && text.compare(0, UTF8_BOM_SIZE, "\xEF\xBB\xBF") == 0;
+	}
+}
+
+/**
+ * \brief
+ * Encoding of a whole buffer, a UTF-8 byte order mark decides on its own.
+ * \param: text: string_view
+ * \return: EEncoding
+ */
+auto cTextEncoding::Detect(std::string_view text) -> EEncoding
+{
+	if (HasUtf8Bom(text))
+		return ENCODING_UTF8;
+
+	return Detect(std::vector<std::string_view>{ text });
+}
+
+/**
+ * \brief
+ * Common encoding of several pieces of text (the fields of a file), a multibyte sequence never spans two of them
+ * because the seperators and quotes are ASCII.
+ * \param: vecText: vector
+ * \return: EEncoding
+ */
+auto cTextEncoding::Detect(const std::vector<std::string_view>& vecText) -> EEncoding
+{
+	auto bAscii = true;
+	for (const auto & text : vecText)
+	{
+		if (FindNonAscii(text) == text.size())
+			continue;
+
+		bAscii = false;
+		if (!IsUtf8(text))
+		{
+			if (std::all_of(vecText.begin(), vecText.end(), [](std::string_view text) { return IsCp949(text); }))
+				return ENCODING_CP949;
+
+			return ENCODING_CP1252;
+		}
+	}
+
+	return bAscii ? ENCODING_ASCII : ENCODING_UTF8;
+}
+
+/**
+ * \brief
+ * Offset of the first byte with the high bit set, the widest instruction set of the cpu is used.
+ * \param: text: string_view
+ * \param: pos: size_t
+ * \return: size_t, text.size() if the text is ASCII from pos on
+ */
+auto cTextEncoding::FindNonAscii(std::string_view text, size_t pos) -> size_t
+{
+	const auto data = text.data();
+	const auto size = text.size();
+
+#ifdef TEXT_ENCODING_X86
+	static const auto implementation = cCsvScanner::GetBestImplementation();
+	if (size - pos >= 64)
+	{
+		if (implementation >= cCsvScanner::IMPL_AVX2)
+			pos = FindNonAsciiAVX2(data, pos, size);
+		else if (implementation >= cCsvScanner::IMPL_SSE2)
+			pos = FindNonAsciiSSE2(data, pos, size);
+	}
+#endif
+
+	pos = FindNonAsciiScalar(data, pos, size);
+	while (pos < size && static_cast<unsigned char>(data[pos]) < 0x80)
+		++pos;
+
+	return pos;
+}
+
+auto cTextEncoding::IsUtf8(std::string_view text) -> bool
+{
+	const auto data = reinterpret_cast<const unsigned char*>(text.data());
+	for (auto pos = FindNonAscii(text); pos < text.size();)
+	{
+		const auto length = GetUtf8Length(data + pos, text.size() - pos);
+		if (!length)
+			return false;
+
+		pos += length;
+		if (pos < text.size() && data[pos] < 0x80)
+			pos = FindNonAscii(text, pos);
+	}
+
+	return true;
+}
+
+auto cTextEncoding::IsCp949(std::string_view text) -> bool
+{
+	const auto data = reinterpret_cast<const unsigned char*>(text.data());
+	for (auto pos = FindNonAscii(text); pos < text.size();)
+	{
+		if (!GetCp949CodePoint(data + pos, text.size() - pos))
+			return false;
+
+		pos += 2;
+		if (pos < text.size() && data[pos] < 0x80)
+			pos = FindNonAscii(text, pos);
+	}
+
+	return true;
+}
+
+/**
+ * \brief
+ * Transcode text to UTF-8 and append it to out, ASCII runs are copied as they are.
+ * A byte which doesn't start a valid sequence becomes U+FFFD, a UTF-8 byte order mark is dropped.
+ * \param: text: string_view
+ * \param: encoding: EEncoding
+ * \param: out: string
+ */
+auto cTextEncoding::ToUtf8(std::string_view text, EEncoding encoding, std::string& out) -> void
+{
+	if (!NeedsTranscoding(encoding))
+	{
+		out.append(HasUtf8Bom(text) ? text.substr(UTF8_BOM_SIZE) : text);
+		return;
+	}
+
+	// A byte never takes more than 3 bytes of UTF-8, the output is written in place and trimmed.
+	const auto data = reinterpret_cast<const unsigned char*>(text.data());
+	const auto offset = out.size();
+	out.resize(offset + text.size() * 3);
+
+	auto cur = &out[offset];
+	for (size_t pos = 0; pos < text.size();)
+	{
+		if (data[pos] < 0x80)
+		{
+			const auto next = FindNonAscii(text, pos);
+			std::memcpy(cur, text.data() + pos, next - pos);
+			cur += next - pos;
+			pos = next;
+			continue;
+		}
+
+		if (encoding == ENCODING_CP1252)
+		{
+			cur = WriteUtf8(cur, CP1252_TABLE[data[pos] - 0x80]);
+			++pos;
+			continue;
+		}
+
+		const auto codePoint = GetCp949CodePoint(data + pos, text.size() - pos);
+		cur = WriteUtf8(cur, codePoint ? codePoint : REPLACEMENT_CHARACTER);
+		pos += codePoint ? 2 : 1;
+	}
+
+	out.resize(static_cast<size_t>(cur - out.data()));
+}
+
+auto cTextEncoding::GetName(EEncoding encoding) -> const char*
+{
+	switch (encoding)
+	{
+		case ENCODING_UTF8:
+			return "utf-8";
+		case ENCODING_CP949:
+			return "cp949";
+		case ENCODING_CP1252:
+			return "windows-1252";
+		default:
+			return "ascii";
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * \brief
+ * Encoding detection and transcoding to UTF-8 of the text loaded from a csv file.
+ * Proto files are mostly ASCII, runs of ASCII bytes are skipped 64 bytes at a time with SSE2/AVX2
+ * and only the non-ASCII bytes are validated or looked up in the code page tables (CodePageTables.h).
+ * Text is ASCII, else UTF-8 if it's valid UTF-8, else CP949 if every non-ASCII byte belongs to a CP949 sequence,
+ * else windows-1252 (the western locales), which maps every byte.
+ */
+class cTextEncoding
+{
+	public:
+		enum EEncoding
+		{
+			ENCODING_ASCII,
+			ENCODING_UTF8,
+			ENCODING_CP949,
+			ENCODING_CP1252,
+		};
+
+	public:
+		static auto Detect(std::string_view text) -> EEncoding;
+		static auto Detect(const std::vector<std::string_view>& vecText) -> EEncoding;
+		static auto FindNonAscii(std::string_view text, size_t pos = 0) -> size_t;
+		static auto IsUtf8(std::string_view text) -> bool;
+		static auto IsCp949(std::string_view text) -> bool;
+		static auto ToUtf8(std::string_view text, EEncoding encoding, std::string& out) -> void;
+		static auto GetName(EEncoding encoding) -> const char*;
+
+		/**
+		 * \brief
+		 * Whether text in the encoding has to be transcoded to be UTF-8.
+		 */
+		static auto NeedsTranscoding(EEncoding encoding) -> bool
+		{
+			return encoding == ENCODING_CP949 || encoding == ENCODING_CP1252;
+		}
+
+	private:
+		cTextEncoding() = default;
+};
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <atomic>
+
+namespace
+{
+	static constexpr size_t NO_WORKER = SIZE_MAX;
+
+	thread_local const CThreadPool* t_pPool = nullptr;
+	thread_local size_t t_WorkerIndex = NO_WORKER;
+}
+
+/**
+ * \brief
+ * Start the worker threads, one per hardware thread by default.
+ * \param: threadCount: size_t
+ */
+CThreadPool::CThreadPool(size_t threadCount) : m_PendingCount(0), m_bStop(false)
+{
+	if (threadCount == 0)
+		threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+	m_vecQueue.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+		m_vecQueue.emplace_back(std::make_unique<SWorkerQueue>());
+
+	m_vecWorker.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i)
+		m_vecWorker.emplace_back(&CThreadPool::WorkerLoop, this, i);
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+
+	m_Condition.notify_all();
+	for (auto & worker : m_vecWorker)
+		worker.join();
+}
+
+auto CThreadPool::Instance() -> CThreadPool&
+{
+	static CThreadPool pool;
+	return pool;
+}
+
+/**
+ * \brief
+ * Queue a task, on the deque of the calling worker or on the shared queue when the caller isn't a worker of this pool.
+ * The pending count is raised under the pool mutex, so a worker about to sleep can't miss the task.
+ * \param: task: function
+ */
+auto CThreadPool::Enqueue(std::function<void()> task) -> void
+{
+	if (t_pPool == this)
+	{
+		auto & queue = *m_vecQueue[t_WorkerIndex];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.emplace_back(std::move(task));
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		++m_PendingCount;
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_queTask.emplace_back(std::move(task));
+		++m_PendingCount;
+	}
+
+	m_Condition.notify_one();
+	m_WaitCondition.notify_all();
+}
+
+/**
+ * \brief
+ * Run one queued task on the calling thread, outside of the profile phases the thread is in.
+ * \return: bool, false if no task was queued
+ */
+auto CThreadPool::RunPendingTask() -> bool
+{
+	std::function<void()> task;
+	if (!TryPop(task))
+		return false;
+
+	{
+		cProfilePause pause;
+		task();
+	}
+
+	NotifyWaiters();
+	return true;
+}
+
+/**
+ * \brief
+ * Run func(0) .. func(count - 1) on the pool and wait for all of them.
+ * The calling thread claims indices too, it only waits for the ones already running on other threads.
+ * \param: count: size_t
+ * \param: func: function
+ */
+auto CThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func) -> void
+{
+	if (count == 0)
+		return;
+
+	struct SState
+	{
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> done{ 0 };
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+
+	const auto state = std::make_shared<SState>();
+	const auto Work = [state, count, &func]
+	{
+		for (auto index = state->next++; index < count; index = state->next++)
+		{
+			func(index);
+			if (++state->done == count)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->condition.notify_all();
+			}
+		}
+	};
+
+	const auto helperCount = std::min(count - 1, m_vecWorker.size());
+	for (size_t i = 0; i < helperCount; ++i)
+		Enqueue(Work);
+
+	Work();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->condition.wait(lock, [&state, count] { return state->done == count; });
+}
+
+auto CThreadPool::WorkerLoop(size_t index) -> void
+{
+	t_pPool = this;
+	t_WorkerIndex = index;
+
+	for (;;)
+	{
+		std::function<void()> task;
+		if (TryPop(task))
+		{
+			task();
+			NotifyWaiters();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this] { return m_bStop || m_PendingCount > 0; });
+		if (m_bStop && m_PendingCount == 0)
+			return;
+	}
+}
+
+/**
+ * \brief
+ * Take the next task for the calling thread: the newest one of its own deque, else the oldest one of the shared queue,
+ * else steal the oldest one of another worker, starting with the next worker so thieves spread over the deques.
+ * \param: task: function
+ * \return: bool
+ */
+auto CThreadPool::TryPop(std::function<void()>& task) -> bool
+{
+	if (m_PendingCount == 0)
+		return false;
+
+	const auto index = t_pPool == this ? t_WorkerIndex : NO_WORKER;
+	if (index != NO_WORKER)
+	{
+		auto & queue = *m_vecQueue[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			--m_PendingCount;
+			return true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_queTask.empty())
+		{
+			task = std::move(m_queTask.front());
+			m_queTask.pop_front();
+			--m_PendingCount;
+			return true;
+		}
+	}
+
+	const auto count = m_vecQueue.size();
+	const auto start = index == NO_WORKER ? 0 : index + 1;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto victim = (start + i) % count;
+		if (victim == index)
+			continue;
+
+		auto & queue = *m_vecQueue[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			--m_PendingCount;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * \brief
+ * Wake the threads in WaitUntil after a task finished, it may be the one they wait for.
+ * Taking the mutex orders the wake-up after their last look at their condition, so none is missed.
+ */
+auto CThreadPool::NotifyWaiters() -> void
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+	}
+
+	m_WaitCondition.notify_all();
+}
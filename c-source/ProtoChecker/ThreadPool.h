@@ -0,0 +1,104 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <atomic>
+
+/**
+ * \brief
+ * Fixed size pool of worker threads shared by the whole program.
+ * Every worker owns a task deque: tasks queued by a worker go to its own deque, which it runs newest first,
+ * idle workers steal the oldest task of another deque. Tasks queued from outside the pool go to a shared queue.
+ * ParallelFor and Wait let the calling thread take part in the work, so they can be used from inside a pool task without deadlocking.
+ * A task run by a waiting thread is kept out of the profile phases that thread is in (see cProfilePause).
+ */
+class CThreadPool
+{
+	private:
+		struct SWorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<std::thread> m_vecWorker;
+		std::vector<std::unique_ptr<SWorkerQueue>> m_vecQueue;
+		std::deque<std::function<void()>> m_queTask;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		std::condition_variable m_WaitCondition;
+		std::atomic<size_t> m_PendingCount;
+		bool m_bStop;
+
+	public:
+		explicit CThreadPool(size_t threadCount = 0);
+		virtual ~CThreadPool();
+
+	public:
+		static auto Instance() -> CThreadPool&;
+
+		auto Enqueue(std::function<void()> task) -> void;
+		auto ParallelFor(size_t count, const std::function<void(size_t)>& func) -> void;
+		auto RunPendingTask() -> bool;
+
+		auto GetThreadCount() const -> size_t
+		{
+			return m_vecWorker.size();
+		}
+
+		template <typename F>
+		auto Submit(F func) -> std::future<decltype(func())>
+		{
+			auto task = std::make_shared<std::packaged_task<decltype(func())()>>(std::move(func));
+			auto future = task->get_future();
+			Enqueue([task] { (*task)(); });
+			return future;
+		}
+
+		/**
+		 * \brief
+		 * Run queued tasks on the calling thread until done() holds, done() has to turn true in a task of this pool.
+		 * The thread sleeps while nothing is queued and wakes up when a task is queued or finished.
+		 * \param: done: callable returning bool
+		 */
+		template <typename F>
+		auto WaitUntil(F done) -> void
+		{
+			while (!done())
+			{
+				if (RunPendingTask())
+					continue;
+
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WaitCondition.wait(lock, [this, &done] { return m_PendingCount > 0 || done(); });
+			}
+		}
+
+		/**
+		 * \brief
+		 * Wait for the result of a task, running other queued tasks meanwhile.
+		 * \param: future: future
+		 * \return: result of the task
+		 */
+		template <typename T>
+		auto Wait(std::future<T>& future) -> T
+		{
+			WaitUntil([&future] { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+			return future.get();
+		}
+
+	private:
+		auto WorkerLoop(size_t index) -> void;
+		auto TryPop(std::function<void()>& task) -> bool;
+		auto NotifyWaiters() -> void;
+
+		CThreadPool(const CThreadPool&) {}
+
+		auto operator =(const CThreadPool&) const -> const CThreadPool&
+		{
+			return *this;
+		}
+};
@@ -0,0 +1,48 @@
+#include "pch.h"
+#include "TokenDictionary.h"
+
+/**
+ * \brief
+ * Token of the dictionary nearest to an unknown one, by edit distance with letter case ignored.
+ * Only called for the tokens a lookup rejected, which are few.
+ * \param: token: string_view
+ * \param: maxDistance: size_t, farthest token returned
+ * \return: string_view, empty when no token is close enough
+ */
+auto cTokenDictionary::FindClosest(std::string_view token, size_t maxDistance) const -> std::string_view
+{
+	std::string_view closest;
+	auto closestDistance = maxDistance + 1;
+
+	std::vector<size_t> vecPrevious, vecCurrent;
+	for (size_t i = 0; i < m_Count; ++i)
+	{
+		const auto candidate = m_pEntry[i].token;
+		if ((candidate.size() > token.size() ? candidate.size() - token.size() : token.size() - candidate.size()) >= closestDistance)
+			continue;
+
+		vecPrevious.resize(candidate.size() + 1);
+		vecCurrent.resize(candidate.size() + 1);
+		for (size_t col = 0; col <= candidate.size(); ++col)
+			vecPrevious[col] = col;
+
+		for (size_t row = 1; row <= token.size(); ++row)
+		{
+			vecCurrent[0] = row;
+			for (size_t col = 1; col <= candidate.size(); ++col)
+			{
+				const auto bSame = toupper(static_cast<unsigned char>(token[row - 1])) == toupper(static_cast<unsigned char>(candidate[col - 1]));
+				vecCurrent[col] = std::min({ vecPrevious[col] + 1, vecCurrent[col - 1] + 1, vecPrevious[col - 1] + (bSame ? 0 : 1) });
+			}
+			vecPrevious.swap(vecCurrent);
+		}
+
+		if (vecPrevious[candidate.size()] < closestDistance)
+		{
+			closest = candidate;
+			closestDistance = vecPrevious[candidate.size()];
+		}
+	}
+
+	return closest;
+}
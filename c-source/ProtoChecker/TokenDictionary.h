@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * \brief
+ * FNV-1a hash of a token, the first hash of a dictionary lookup.
+ * \param token: string_view
+ * \return: uint64_t
+ */
+constexpr auto hash_token(std::string_view token) -> uint64_t
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (const auto c : token)
+	{
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+/**
+ * \brief
+ * Token hash displaced by the seed of its bucket, the second hash of a dictionary lookup.
+ */
+constexpr auto mix_token_hash(uint64_t hash, uint32_t seed) -> uint64_t
+{
+	hash ^= seed * 0x9E3779B97F4A7C15ULL;
+	hash ^= hash >> 31;
+	hash *= 0xBF58476D1CE4E5B9ULL;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+/**
+ * \brief
+ * Token of a dictionary and the enum value the game stores for it.
+ */
+struct STokenEntry
+{
+	std::string_view token;
+	uint8_t value;
+};
+
+/**
+ * \brief
+ * Closed set of tokens stored as a minimal perfect hash, generated by Tools/gen_token_tables.py (see TokenTables.h).
+ * A token hashes to a bucket, the seed of the bucket moves it to its own slot, there are as many slots as tokens.
+ * A lookup is two multiply-shift reductions and one compare, it doesn't branch on the token set.
+ */
+class cTokenDictionary
+{
+	private:
+		const char* m_Name;
+		const STokenEntry* m_pEntry;
+		size_t m_Count;
+		const uint16_t* m_pSeed;
+		size_t m_SeedCount;
+
+	public:
+		template <size_t N, size_t M>
+		constexpr cTokenDictionary(const char* name, const STokenEntry (&entries)[N], const uint16_t (&seeds)[M]) :
+			m_Name(name), m_pEntry(entries), m_Count(N), m_pSeed(seeds), m_SeedCount(M)
+		{
+		}
+
+	public:
+		/**
+		 * \brief
+		 * Enum value of a token.
+		 * \param: token: string_view
+		 * \return: int, -1 if the token isn't in the dictionary
+		 */
+		constexpr auto Find(std::string_view token) const -> int
+		{
+			const auto hash = hash_token(token);
+			const auto seed = m_pSeed[((hash & 0xFFFFFFFFULL) * m_SeedCount) >> 32];
+			const auto slot = ((mix_token_hash(hash, seed) >> 32) * m_Count) >> 32;
+			return m_pEntry[slot].token == token ? m_pEntry[slot].value : -1;
+		}
+
+		/**
+		 * \brief
+		 * Every token is found with its own value, checked at compile time against the generated tables.
+		 */
+		constexpr auto IsPerfect() const -> bool
+		{
+			for (size_t i = 0; i < m_Count; ++i)
+			{
+				if (Find(m_pEntry[i].token) != m_pEntry[i].value)
+					return false;
+			}
+			return true;
+		}
+
+		auto FindClosest(std::string_view token, size_t maxDistance) const -> std::string_view;
+
+		constexpr auto GetName() const -> const char*
+		{
+			return m_Name;
+		}
+
+		constexpr auto GetCount() const -> size_t
+		{
+			return m_Count;
+		}
+};
@@ -0,0 +1,270 @@
+#pragma once
+// Generated by Tools/gen_token_tables.py, do not edit.
+#include "TokenDictionary.h"
+
+static constexpr STokenEntry ITEM_TYPE_ENTRIES[39] =
+{
+	{"ITEM_MATERIAL", 5},
+	{"ITEM_WEAPON", 1},
+	{"ITEM_RESOURCE", 14},
+	{"ITEM_BELT", 34},
+	{"ITEM_GIFTBOX", 23},
+	{"ITEM_RING", 33},
+	{"ITEM_DS", 29},
+	{"ITEM_TOOL", 7},
+	{"ITEM_SKILLBOOK", 17},
+	{"ITEM_MEDIUM", 36},
+	{"ITEM_COSTUME", 28},
+	{"ITEM_ARMOR", 2},
+	{"ITEM_FISH", 12},
+	{"ITEM_PET", 35},
+	{"ITEM_SPECIAL", 6},
+	{"ITEM_ROD", 13},
+	{"ITEM_ELK", 9},
+	{"ITEM_USE", 3},
+	{"ITEM_QUEST", 18},
+	{"ITEM_TOTEM", 26},
+	{"ITEM_CONTAINER", 11},
+	{"ITEM_PICK", 24},
+	{"ITEM_CAMPFIRE", 15},
+	{"ITEM_SOUL", 38},
+	{"ITEM_AUTOUSE", 4},
+	{"ITEM_SECONDARY_COIN", 32},
+	{"ITEM_SKILLFORGET", 22},
+	{"ITEM_UNIQUE", 16},
+	{"ITEM_TREASURE_KEY", 21},
+	{"ITEM_GACHA", 37},
+	{"ITEM_LOTTERY", 8},
+	{"ITEM_BLEND", 27},
+	{"ITEM_METIN", 10},
+	{"ITEM_EXTRACT", 31},
+	{"ITEM_TREASURE_BOX", 20},
+	{"ITEM_NONE", 0},
+	{"ITEM_HAIR", 25},
+	{"ITEM_SPECIAL_DS", 30},
+	{"ITEM_POLYMORPH", 19},
+};
+
+static constexpr uint16_t ITEM_TYPE_SEEDS[20] =
+{
+	2, 3, 9, 8, 0, 22, 17, 0, 1, 1, 0, 1, 0, 22, 2, 61,
+	2, 12, 21, 0,
+};
+
+static constexpr cTokenDictionary ITEM_TYPE_TOKENS("ITEM_TYPE", ITEM_TYPE_ENTRIES, ITEM_TYPE_SEEDS);
+static_assert(ITEM_TYPE_TOKENS.IsPerfect(), "ITEM_TYPE_TOKENS doesn't find its own tokens");
+
+static constexpr STokenEntry LIMIT_TYPE_ENTRIES[10] =
+{
+	{"PC_BANG", 6},
+	{"REAL_TIME", 7},
+	{"REAL_TIME_FIRST_USE", 8},
+	{"STR", 2},
+	{"LEVEL", 1},
+	{"LIMIT_NONE", 0},
+	{"TIMER_BASED_ON_WEAR", 9},
+	{"CON", 5},
+	{"INT", 4},
+	{"DEX", 3},
+};
+
+static constexpr uint16_t LIMIT_TYPE_SEEDS[5] =
+{
+	9, 0, 6, 1, 2,
+};
+
+static constexpr cTokenDictionary LIMIT_TYPE_TOKENS("LIMIT_TYPE", LIMIT_TYPE_ENTRIES, LIMIT_TYPE_SEEDS);
+static_assert(LIMIT_TYPE_TOKENS.IsPerfect(), "LIMIT_TYPE_TOKENS doesn't find its own tokens");
+
+static constexpr STokenEntry APPLY_TYPE_ENTRIES[117] =
+{
+	{"APPLY_ENCHANT_ICE", 101},
+	{"APPLY_CURSE_PCT", 57},
+	{"APPLY_SLOW_PCT", 14},
+	{"APPLY_ITEM_DROP_BONUS", 45},
+	{"APPLY_MALL_EXPBONUS", 66},
+	{"APPLY_ATTBONUS_INSECT", 106},
+	{"APPLY_RESIST_MAGIC", 37},
+	{"APPLY_CON", 3},
+	{"APPLY_ATTBONUS_MONSTER", 63},
+	{"APPLY_MAX_SP", 2},
+	{"APPLY_RESIST_WARRIOR", 78},
+	{"APPLY_MAX_HP_PCT", 69},
+	{"APPLY_SKILL", 51},
+	{"APPLY_ENERGY", 82},
+	{"APPLY_STEAL_HP", 23},
+	{"APPLY_MOV_SPEED", 8},
+	{"APPLY_POISON_PCT", 12},
+	{"APPLY_NORMAL_HIT_DEFEND_BONUS", 74},
+	{"APPLY_ATTBONUS_DEVIL", 22},
+	{"APPLY_POTION_BONUS", 46},
+	{"APPLY_MAGIC_ATTBONUS_PER", 85},
+	{"APPLY_GOLD_DOUBLE_BONUS", 44},
+	{"APPLY_RESIST_FAN", 33},
+	{"APPLY_SP_REGEN", 11},
+	{"APPLY_BOW_DISTANCE", 52},
+	{"APPLY_POISON_REDUCE", 41},
+	{"APPLY_STUN_PCT", 13},
+	{"APPLY_RESIST_EARTH", 88},
+	{"APPLY_RESIST_MAGIC_REDUCTION", 98},
+	{"APPLY_MAX_HP", 1},
+	{"APPLY_INT", 4},
+	{"APPLY_ATTBONUS_SWORD", 108},
+	{"APPLY_KILL_SP_RECOVER", 42},
+	{"APPLY_HP_REGEN", 10},
+	{"APPLY_RESIST_TWOHAND", 30},
+	{"APPLY_REFLECT_MELEE", 39},
+	{"APPLY_ATT_GRADE_BONUS", 53},
+	{"APPLY_ENCHANT_EARTH", 103},
+	{"APPLY_ATTBONUS_SHAMAN", 62},
+	{"APPLY_ATTBONUS_WARRIOR", 59},
+	{"APPLY_ATTBONUS_BOW", 113},
+	{"APPLY_MAX_SP_PCT", 70},
+	{"APPLY_ATTBONUS_ANIMAL", 18},
+	{"APPLY_ATTBONUS_BELL", 111},
+	{"APPLY_SKILL_DAMAGE_BONUS", 71},
+	{"APPLY_RESIST_BELL", 32},
+	{"APPLY_MALL_ITEMBONUS", 67},
+	{"APPLY_ATTBONUS_ORC", 19},
+	{"APPLY_PC_BANG_DROP_BONUS", 76},
+	{"APPLY_MANA_BURN_PCT", 25},
+	{"APPLY_STR", 5},
+	{"APPLY_RESIST_ASSASSIN", 79},
+	{"APPLY_ENCHANT_FIRE", 100},
+	{"APPLY_DODGE", 28},
+	{"APPLY_NORMAL_HIT_DAMAGE_BONUS", 72},
+	{"APPLY_DEF_GRADE", 83},
+	{"APPLY_ATTBONUS_ASSASSIN", 60},
+	{"APPLY_SKILL_DEFEND_BONUS", 73},
+	{"APPLY_IMMUNE_FALL", 50},
+	{"APPLY_IMMUNE_SLOW", 49},
+	{"APPLY_MELEE_MAGIC_ATTBONUS_PER", 86},
+	{"APPLY_PENETRATE_PCT", 16},
+	{"APPLY_DEX", 6},
+	{"APPLY_EXTRACT_HP_PCT", 77},
+	{"APPLY_RESIST_FIRE", 35},
+	{"APPLY_ACCEDRAIN_RATE", 97},
+	{"APPLY_RESIST_HUMAN", 115},
+	{"APPLY_RESIST_SURA", 80},
+	{"APPLY_RESIST_CLAW", 96},
+	{"APPLY_MAX_STAMINA", 58},
+	{"APPLY_MAGIC_ATT_GRADE", 55},
+	{"APPLY_ATTBONUS_UNDEAD", 21},
+	{"APPLY_BLEEDING_REDUCE", 92},
+	{"APPLY_MALL_ATTBONUS", 64},
+	{"APPLY_ATTBONUS_CLAW", 114},
+	{"APPLY_ATTBONUS_TWOHAND", 109},
+	{"APPLY_RESIST_MOUNT_FALL", 116},
+	{"APPLY_MAGIC_DEF_GRADE", 56},
+	{"APPLY_RESIST_DARK", 89},
+	{"APPLY_DAMAGE_SP_RECOVER", 26},
+	{"APPLY_ATTBONUS_WOLFMAN", 94},
+	{"APPLY_ATTBONUS_FAN", 112},
+	{"APPLY_PC_BANG_EXP_BONUS", 75},
+	{"APPLY_RESIST_WOLFMAN", 95},
+	{"APPLY_RESIST_SHAMAN", 81},
+	{"APPLY_DEF_GRADE_BONUS", 54},
+	{"APPLY_ATTBONUS_HUMAN", 17},
+	{"APPLY_CRITICAL_PCT", 15},
+	{"APPLY_RESIST_WIND", 38},
+	{"APPLY_ATTBONUS_DESERT", 107},
+	{"APPLY_ANTI_CRITICAL_PCT", 90},
+	{"APPLY_RESIST_BOW", 34},
+	{"APPLY_BLEEDING_PCT", 93},
+	{"APPLY_STEAL_SP", 24},
+	{"APPLY_COSTUME_ATTR_BONUS", 84},
+	{"APPLY_ENCHANT_WIND", 102},
+	{"APPLY_RESIST_ELEC", 36},
+	{"APPLY_IMMUNE_STUN", 48},
+	{"APPLY_ATTBONUS_MILGYO", 20},
+	{"APPLY_RESIST_SWORD", 29},
+	{"APPLY_CAST_SPEED", 9},
+	{"APPLY_KILL_HP_RECOVER", 47},
+	{"APPLY_REFLECT_CURSE", 40},
+	{"APPLY_ENCHANT_DARK", 104},
+	{"APPLY_MALL_DEFBONUS", 65},
+	{"APPLY_ATTBONUS_CZ", 105},
+	{"APPLY_RESIST_DAGGER", 31},
+	{"APPLY_ATTBONUS_SURA", 61},
+	{"APPLY_MALL_GOLDBONUS", 68},
+	{"APPLY_ANTI_PENETRATE_PCT", 91},
+	{"APPLY_ENCHANT_ELECT", 99},
+	{"APPLY_BLOCK", 27},
+	{"APPLY_ATT_SPEED", 7},
+	{"APPLY_NONE", 0},
+	{"APPLY_RESIST_ICE", 87},
+	{"APPLY_EXP_DOUBLE_BONUS", 43},
+	{"APPLY_ATTBONUS_DAGGER", 110},
+};
+
+static constexpr uint16_t APPLY_TYPE_SEEDS[59] =
+{
+	0, 4, 8, 1, 11, 0, 1, 0, 2, 2, 0, 9, 3, 1, 18, 0,
+	8, 4, 14, 0, 10, 12, 1, 2, 0, 0, 0, 0, 22, 31, 12, 0,
+	0, 0, 0, 3, 0, 14, 0, 7, 10, 7, 2, 4, 31, 0, 4, 0,
+	86, 19, 0, 4, 52, 3, 9, 16, 12, 117, 6,
+};
+
+static constexpr cTokenDictionary APPLY_TYPE_TOKENS("APPLY_TYPE", APPLY_TYPE_ENTRIES, APPLY_TYPE_SEEDS);
+static_assert(APPLY_TYPE_TOKENS.IsPerfect(), "APPLY_TYPE_TOKENS doesn't find its own tokens");
+
+static constexpr STokenEntry MOB_RANK_ENTRIES[6] =
+{
+	{"KING", 5},
+	{"S_KNIGHT", 3},
+	{"PAWN", 0},
+	{"BOSS", 4},
+	{"S_PAWN", 1},
+	{"KNIGHT", 2},
+};
+
+static constexpr uint16_t MOB_RANK_SEEDS[3] =
+{
+	3, 0, 16,
+};
+
+static constexpr cTokenDictionary MOB_RANK_TOKENS("MOB_RANK", MOB_RANK_ENTRIES, MOB_RANK_SEEDS);
+static_assert(MOB_RANK_TOKENS.IsPerfect(), "MOB_RANK_TOKENS doesn't find its own tokens");
+
+static constexpr STokenEntry MOB_TYPE_ENTRIES[11] =
+{
+	{"NPC", 1},
+	{"PC", 6},
+	{"DOOR", 4},
+	{"MONSTER", 0},
+	{"STONE", 2},
+	{"POLYMORPH_PC", 7},
+	{"HORSE", 8},
+	{"WARP", 3},
+	{"BUILDING", 5},
+	{"GOTO", 9},
+	{"PET", 10},
+};
+
+static constexpr uint16_t MOB_TYPE_SEEDS[6] =
+{
+	6, 0, 6, 5, 2, 5,
+};
+
+static constexpr cTokenDictionary MOB_TYPE_TOKENS("MOB_TYPE", MOB_TYPE_ENTRIES, MOB_TYPE_SEEDS);
+static_assert(MOB_TYPE_TOKENS.IsPerfect(), "MOB_TYPE_TOKENS doesn't find its own tokens");
+
+static constexpr STokenEntry BATTLE_TYPE_ENTRIES[8] =
+{
+	{"SUPER_TANKER", 7},
+	{"MELEE", 0},
+	{"TANKER", 5},
+	{"SPECIAL", 3},
+	{"POWER", 4},
+	{"RANGE", 1},
+	{"SUPER_POWER", 6},
+	{"MAGIC", 2},
+};
+
+static constexpr uint16_t BATTLE_TYPE_SEEDS[4] =
+{
+	0, 0, 11, 14,
+};
+
+static constexpr cTokenDictionary BATTLE_TYPE_TOKENS("BATTLE_TYPE", BATTLE_TYPE_ENTRIES, BATTLE_TYPE_SEEDS);
+static_assert(BATTLE_TYPE_TOKENS.IsPerfect(), "BATTLE_TYPE_TOKENS doesn't find its own tokens");
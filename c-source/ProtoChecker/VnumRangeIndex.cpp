@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "VnumRangeIndex.h"
+
+static constexpr size_t NO_GAP = SIZE_MAX;
+
+/**
+ * \brief
+ * Add the key of a row, a single vnum has first == last.
+ * \param: first: uint32_t
+ * \param: last: uint32_t, not below first
+ * \param: source: uint32_t
+ * \param: line: uint32_t
+ */
+auto CVnumRangeIndex::Add(uint32_t first, uint32_t last, uint32_t source, uint32_t line) -> void
+{
+	m_vecInterval.push_back({ first, last, source, line });
+}
+
+/**
+ * \brief
+ * Sort the intervals and index the gaps between them, call it once every interval was added.
+ * Vnum 0 is never free, it stands for no vnum in the files.
+ */
+auto CVnumRangeIndex::Build() -> void
+{
+	// A longer interval goes first, so the one holding another is met before it.
+	std::sort(m_vecInterval.begin(), m_vecInterval.end(), [](const SInterval& left, const SInterval& right)
+	{
+		return left.first != right.first ? left.first < right.first : left.last > right.last;
+	});
+
+	m_vecGap.clear();
+	uint64_t next = 1;
+	for (const auto & interval : m_vecInterval)
+	{
+		if (interval.first > next)
+			m_vecGap.emplace_back(static_cast<uint32_t>(next), interval.first - 1);
+		next = std::max<uint64_t>(next, uint64_t(interval.last) + 1);
+	}
+
+	if (next <= UINT32_MAX)
+		m_vecGap.emplace_back(static_cast<uint32_t>(next), UINT32_MAX);
+
+	// Segment tree of the largest gap under each node, the leaves follow the gaps.
+	m_LeafCount = 1;
+	while (m_LeafCount < m_vecGap.size())
+		m_LeafCount *= 2;
+
+	m_vecTree.assign(2 * m_LeafCount, 0);
+	for (size_t gap = 0; gap < m_vecGap.size(); ++gap)
+		m_vecTree[m_LeafCount + gap] = uint64_t(m_vecGap[gap].second) - m_vecGap[gap].first + 1;
+
+	for (auto node = m_LeafCount - 1; node > 0; --node)
+		m_vecTree[node] = std::max(m_vecTree[2 * node], m_vecTree[2 * node + 1]);
+}
+
+/**
+ * \brief
+ * Sweep the sorted intervals for the ones starting inside an interval before them.
+ * Each overlapping interval is reported once, against the interval reaching the farthest before it.
+ * Identical intervals are left out, they are duplicated keys.
+ * \return: vector, in the order of the inner intervals
+ */
+auto CVnumRangeIndex::FindOverlaps() const -> std::vector<SOverlap>
+{
+	std::vector<SOverlap> vecOverlap;
+	if (m_vecInterval.empty())
+		return vecOverlap;
+
+	size_t reach = 0;
+	for (size_t i = 1; i < m_vecInterval.size(); ++i)
+	{
+		const auto & outer = m_vecInterval[reach];
+		const auto & current = m_vecInterval[i];
+		if (current.first <= outer.last && (current.first != outer.first || current.last != outer.last))
+			vecOverlap.push_back({ outer, current });
+
+		if (current.last > outer.last)
+			reach = i;
+	}
+
+	return vecOverlap;
+}
+
+/**
+ * \brief
+ * Find the lowest block of free vnums of a size, at or above a vnum.
+ * \param: count: uint32_t, size of the block
+ * \param: from: uint32_t
+ * \param: first: uint32_t, set to the first vnum of the block when there's one
+ * \return: bool, false if no block of that size is free from there on
+ */
+auto CVnumRangeIndex::FindFree(uint32_t count, uint32_t from, uint32_t& first) const -> bool
+{
+	const auto it = std::lower_bound(m_vecGap.begin(), m_vecGap.end(), from, [](const auto & gap, uint32_t vnum) { return gap.second < vnum; });
+	if (it == m_vecGap.end())
+		return false;
+
+	// The gap holding from (or the next one) only counts from there.
+	const auto begin = std::max(it->first, from);
+	if (uint64_t(it->second) - begin + 1 >= count)
+	{
+		first = begin;
+		return true;
+	}
+
+	const auto gap = FindGap(1, 0, m_LeafCount, static_cast<size_t>(it - m_vecGap.begin()) + 1, count);
+	if (gap == NO_GAP)
+		return false;
+
+	first = m_vecGap[gap].first;
+	return true;
+}
+
+/**
+ * \brief
+ * First gap at or after a gap which holds count vnums, the subtrees whose largest gap is too small are skipped.
+ * \param: node: size_t, covering the gaps [begin, end)
+ * \param: from: size_t, first gap looked at
+ * \param: count: uint64_t
+ * \return: size_t, NO_GAP if there's none
+ */
+auto CVnumRangeIndex::FindGap(size_t node, size_t begin, size_t end, size_t from, uint64_t count) const -> size_t
+{
+	if (end <= from || m_vecTree[node] < count)
+		return NO_GAP;
+
+	if (end - begin == 1)
+		return begin;
+
+	const auto middle = (begin + end) / 2;
+	const auto gap = FindGap(2 * node, begin, middle, from, count);
+	return gap != NO_GAP ? gap : FindGap(2 * node + 1, middle, end, from, count);
+}
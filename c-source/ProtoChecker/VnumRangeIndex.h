@@ -0,0 +1,69 @@
+#pragma once
+
+/**
+ * \brief
+ * Interval index over the keys of files: single vnums and `~` ranges, each a [first, last] interval.
+ * Build sorts the intervals once. Overlaps come out of a single sweep over them, and the free vnums are the gaps
+ * between the merged intervals, kept in a segment tree of their sizes so that the first gap which can hold a block
+ * is found in logarithmic time.
+ */
+class CVnumRangeIndex
+{
+	public:
+		/**
+		 * \brief
+		 * Key of a row, source is up to the caller (the file it comes from).
+		 */
+		struct SInterval
+		{
+			uint32_t first;
+			uint32_t last;
+			uint32_t source;
+			uint32_t line;
+		};
+
+		/**
+		 * \brief
+		 * Two overlapping intervals, outer starts first (or is the longer one when they start together).
+		 */
+		struct SOverlap
+		{
+			SInterval outer;
+			SInterval inner;
+		};
+
+	private:
+		std::vector<SInterval> m_vecInterval;
+		std::vector<std::pair<uint32_t, uint32_t>> m_vecGap;
+		std::vector<uint64_t> m_vecTree;
+		size_t m_LeafCount;
+
+	public:
+		CVnumRangeIndex() : m_LeafCount(0) {}
+		virtual ~CVnumRangeIndex() = default;
+
+	public:
+		auto Add(uint32_t first, uint32_t last, uint32_t source, uint32_t line) -> void;
+		auto Build() -> void;
+		auto FindOverlaps() const -> std::vector<SOverlap>;
+		auto FindFree(uint32_t count, uint32_t from, uint32_t& first) const -> bool;
+
+		/**
+		 * \brief
+		 * Intervals sorted by first vnum, valid after Build.
+		 */
+		auto GetIntervals() const -> const std::vector<SInterval>&
+		{
+			return m_vecInterval;
+		}
+
+	private:
+		auto FindGap(size_t node, size_t begin, size_t end, size_t from, uint64_t count) const -> size_t;
+
+		CVnumRangeIndex(const CVnumRangeIndex&) {}
+
+		auto operator =(const CVnumRangeIndex&) const -> const CVnumRangeIndex&
+		{
+			return *this;
+		}
+};
@@ -0,0 +1,443 @@
+#include "pch.h"
+#include "VnumSet.h"
+#include <bitset>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define VNUM_SET_SSE2
+	#include <emmintrin.h>
+#endif
+
+/**
+ * \brief
+ * Add a single vnum.
+ * \param: vnum: uint32_t
+ */
+auto CVnumSet::Add(uint32_t vnum) -> void
+{
+	auto & container = GetOrCreateContainer(static_cast<uint16_t>(vnum >> 16));
+	const auto low = static_cast<uint16_t>(vnum & 0xFFFF);
+
+	switch (container.type)
+	{
+		case CONTAINER_ARRAY:
+		{
+			auto & array = container.array;
+			if (array.empty() || array.back() < low)
+			{
+				array.push_back(low);
+			}
+			else
+			{
+				const auto it = std::lower_bound(array.begin(), array.end(), low);
+				if (*it == low)
+					return;
+				array.insert(it, low);
+			}
+
+			if (++container.cardinality > ARRAY_MAX_SIZE)
+				ToBitmap(container);
+			break;
+		}
+		case CONTAINER_RUN:
+			if (ContainerContains(container, low))
+				return;
+			ToBitmap(container);
+			// fall through
+		case CONTAINER_BITMAP:
+		{
+			auto & word = container.bitmap[low >> 6];
+			const auto bit = uint64_t(1) << (low & 63);
+			if (!(word & bit))
+			{
+				word |= bit;
+				++container.cardinality;
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * \brief
+ * Add every vnum of the inclusive range [first, last], each container touched by the range stores it as a run.
+ * \param: first: uint32_t
+ * \param: last: uint32_t
+ */
+auto CVnumSet::AddRange(uint32_t first, uint32_t last) -> void
+{
+	if (first > last)
+		return;
+
+	for (auto key = first >> 16; key <= (last >> 16); ++key)
+	{
+		const auto low = key == (first >> 16) ? first & 0xFFFF : 0;
+		const auto high = key == (last >> 16) ? last & 0xFFFF : 0xFFFF;
+		auto & container = GetOrCreateContainer(static_cast<uint16_t>(key));
+
+		if (container.cardinality == 0)
+		{
+			container.type = CONTAINER_RUN;
+			container.array = {};
+			container.bitmap = {};
+			container.runs.push_back({ static_cast<uint16_t>(low), static_cast<uint16_t>(high - low) });
+			container.cardinality = high - low + 1;
+		}
+		else if (container.type == CONTAINER_RUN)
+		{
+			auto & runs = container.runs;
+			const auto it = std::lower_bound(runs.begin(), runs.end(), low, [](const SRun& run, uint32_t value) { return run.start < value; });
+			runs.insert(it, { static_cast<uint16_t>(low), static_cast<uint16_t>(high - low) });
+
+			std::vector<SRun> merged;
+			merged.reserve(runs.size());
+			for (const auto & run : runs)
+			{
+				const auto runEnd = static_cast<uint32_t>(run.start) + run.length;
+				if (!merged.empty() && run.start <= static_cast<uint32_t>(merged.back().start) + merged.back().length + 1)
+				{
+					auto & back = merged.back();
+					const auto backEnd = std::max(static_cast<uint32_t>(back.start) + back.length, runEnd);
+					back.length = static_cast<uint16_t>(backEnd - back.start);
+				}
+				else
+				{
+					merged.push_back(run);
+				}
+			}
+
+			runs.swap(merged);
+			container.cardinality = 0;
+			for (const auto & run : runs)
+				container.cardinality += static_cast<uint32_t>(run.length) + 1;
+		}
+		else
+		{
+			ToBitmap(container);
+			SetBitRange(container.bitmap, low, high, true);
+			container.cardinality = CountBits(container.bitmap);
+		}
+	}
+}
+
+/**
+ * \brief
+ * Check if a vnum is part of the set.
+ * \param: vnum: uint32_t
+ * \return: bool
+ */
+auto CVnumSet::Contains(uint32_t vnum) const -> bool
+{
+	const auto container = FindContainer(static_cast<uint16_t>(vnum >> 16));
+	return container && ContainerContains(*container, static_cast<uint16_t>(vnum & 0xFFFF));
+}
+
+auto CVnumSet::Cardinality() const -> uint64_t
+{
+	uint64_t cardinality = 0;
+	for (const auto & container : m_Containers)
+		cardinality += container.cardinality;
+	return cardinality;
+}
+
+auto CVnumSet::Clear() -> void
+{
+	m_Keys.clear();
+	m_Containers.clear();
+}
+
+/**
+ * \brief
+ * Convert every container to its smallest representation and drop the empty ones.
+ */
+auto CVnumSet::Optimize() -> void
+{
+	size_t index = 0;
+	for (size_t i = 0; i < m_Keys.size(); ++i)
+	{
+		if (m_Containers[i].cardinality == 0)
+			continue;
+
+		OptimizeContainer(m_Containers[i]);
+		if (index != i)
+		{
+			m_Keys[index] = m_Keys[i];
+			m_Containers[index] = std::move(m_Containers[i]);
+		}
+		++index;
+	}
+
+	m_Keys.resize(index);
+	m_Containers.resize(index);
+}
+
+/**
+ * \brief
+ * Build the set of vnums which are in this set and not in the other one.
+ * \param: other: CVnumSet
+ * \return: CVnumSet
+ */
+auto CVnumSet::AndNot(const CVnumSet& other) const -> CVnumSet
+{
+	CVnumSet result;
+	result.m_Keys.reserve(m_Keys.size());
+	result.m_Containers.reserve(m_Keys.size());
+
+	size_t j = 0;
+	for (size_t i = 0; i < m_Keys.size(); ++i)
+	{
+		while (j < other.m_Keys.size() && other.m_Keys[j] < m_Keys[i])
+			++j;
+
+		auto container = (j < other.m_Keys.size() && other.m_Keys[j] == m_Keys[i]) ? AndNotContainer(m_Containers[i], other.m_Containers[j]) : m_Containers[i];
+		if (container.cardinality == 0)
+			continue;
+
+		result.m_Keys.push_back(m_Keys[i]);
+		result.m_Containers.push_back(std::move(container));
+	}
+
+	return result;
+}
+
+auto CVnumSet::ToVector() const -> std::vector<uint32_t>
+{
+	std::vector<uint32_t> vecVnum;
+	vecVnum.reserve(static_cast<size_t>(Cardinality()));
+	ForEach([&vecVnum](uint32_t vnum) { vecVnum.push_back(vnum); });
+	return vecVnum;
+}
+
+auto CVnumSet::GetOrCreateContainer(uint16_t key) -> SContainer&
+{
+	if (!m_Keys.empty() && m_Keys.back() == key)
+		return m_Containers.back();
+
+	const auto it = std::lower_bound(m_Keys.begin(), m_Keys.end(), key);
+	const auto index = static_cast<size_t>(it - m_Keys.begin());
+	if (it != m_Keys.end() && *it == key)
+		return m_Containers[index];
+
+	m_Keys.insert(it, key);
+	return *m_Containers.emplace(m_Containers.begin() + index);
+}
+
+auto CVnumSet::FindContainer(uint16_t key) const -> const SContainer*
+{
+	const auto it = std::lower_bound(m_Keys.begin(), m_Keys.end(), key);
+	if (it == m_Keys.end() || *it != key)
+		return nullptr;
+
+	return &m_Containers[it - m_Keys.begin()];
+}
+
+auto CVnumSet::ToBitmap(SContainer& container) -> void
+{
+	if (container.type == CONTAINER_BITMAP)
+		return;
+
+	container.bitmap.assign(BITMAP_WORDS, 0);
+	if (container.type == CONTAINER_ARRAY)
+	{
+		for (const auto low : container.array)
+			container.bitmap[low >> 6] |= uint64_t(1) << (low & 63);
+	}
+	else
+	{
+		for (const auto & run : container.runs)
+			SetBitRange(container.bitmap, run.start, static_cast<uint32_t>(run.start) + run.length, true);
+	}
+
+	container.type = CONTAINER_BITMAP;
+	container.array = {};
+	container.runs = {};
+}
+
+auto CVnumSet::SetBitRange(std::vector<uint64_t>& bitmap, uint32_t first, uint32_t last, bool value) -> void
+{
+	const auto firstWord = first >> 6;
+	const auto lastWord = last >> 6;
+
+	for (auto word = firstWord; word <= lastWord; ++word)
+	{
+		auto mask = ~uint64_t(0);
+		if (word == firstWord)
+			mask &= ~uint64_t(0) << (first & 63);
+		if (word == lastWord)
+			mask &= ~uint64_t(0) >> (63 - (last & 63));
+
+		if (value)
+			bitmap[word] |= mask;
+		else
+			bitmap[word] &= ~mask;
+	}
+}
+
+auto CVnumSet::CountBits(const std::vector<uint64_t>& bitmap) -> uint32_t
+{
+	uint32_t count = 0;
+	for (const auto word : bitmap)
+		count += static_cast<uint32_t>(std::bitset<64>(word).count());
+	return count;
+}
+
+auto CVnumSet::ContainerContains(const SContainer& container, uint16_t low) -> bool
+{
+	switch (container.type)
+	{
+		case CONTAINER_ARRAY:
+			return std::binary_search(container.array.begin(), container.array.end(), low);
+		case CONTAINER_BITMAP:
+			return (container.bitmap[low >> 6] >> (low & 63)) & 1;
+		case CONTAINER_RUN:
+		{
+			const auto it = std::upper_bound(container.runs.begin(), container.runs.end(), low, [](uint16_t value, const SRun& run) { return value < run.start; });
+			if (it == container.runs.begin())
+				return false;
+
+			const auto & run = *(it - 1);
+			return low <= static_cast<uint32_t>(run.start) + run.length;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * \brief
+ * Pick the smallest of the three representations for a container, like Roaring's runOptimize.
+ * \param: container: SContainer
+ */
+auto CVnumSet::OptimizeContainer(SContainer& container) -> void
+{
+	std::vector<SRun> runs;
+	const auto AppendValue = [&runs](uint32_t low)
+	{
+		if (!runs.empty() && static_cast<uint32_t>(runs.back().start) + runs.back().length + 1 == low)
+			++runs.back().length;
+		else
+			runs.push_back({ static_cast<uint16_t>(low), 0 });
+	};
+
+	switch (container.type)
+	{
+		case CONTAINER_ARRAY:
+			for (const auto low : container.array)
+				AppendValue(low);
+			break;
+		case CONTAINER_BITMAP:
+			for (uint32_t word = 0; word < BITMAP_WORDS; ++word)
+			{
+				for (auto bits = container.bitmap[word]; bits; bits &= bits - 1)
+					AppendValue((word << 6) | count_trailing_zeros(bits));
+			}
+			break;
+		case CONTAINER_RUN:
+			runs = container.runs;
+			break;
+	}
+
+	const auto runBytes = runs.size() * sizeof(SRun);
+	const auto arrayBytes = container.cardinality <= ARRAY_MAX_SIZE ? container.cardinality * sizeof(uint16_t) : SIZE_MAX;
+	const auto bitmapBytes = BITMAP_WORDS * sizeof(uint64_t);
+
+	if (runBytes < arrayBytes && runBytes < bitmapBytes)
+	{
+		container.type = CONTAINER_RUN;
+		container.runs.swap(runs);
+		container.array = {};
+		container.bitmap = {};
+	}
+	else if (arrayBytes < bitmapBytes)
+	{
+		if (container.type != CONTAINER_ARRAY)
+		{
+			std::vector<uint16_t> array;
+			array.reserve(container.cardinality);
+			for (const auto & run : runs)
+			{
+				for (uint32_t low = run.start; low <= static_cast<uint32_t>(run.start) + run.length; ++low)
+					array.push_back(static_cast<uint16_t>(low));
+			}
+
+			container.type = CONTAINER_ARRAY;
+			container.array.swap(array);
+			container.runs = {};
+			container.bitmap = {};
+		}
+	}
+	else
+	{
+		ToBitmap(container);
+	}
+}
+
+/**
+ * \brief
+ * Difference of two containers with the same key.
+ * Arrays are filtered value by value, everything else is subtracted on a bitmap copy of the left container,
+ * a bitmap right side goes through a vectorized AND-NOT.
+ * \param: left: SContainer
+ * \param: right: SContainer
+ * \return: SContainer
+ */
+auto CVnumSet::AndNotContainer(const SContainer& left, const SContainer& right) -> SContainer
+{
+	SContainer result;
+
+	if (left.type == CONTAINER_ARRAY)
+	{
+		result.array.reserve(left.array.size());
+		if (right.type == CONTAINER_ARRAY)
+		{
+			std::set_difference(left.array.begin(), left.array.end(), right.array.begin(), right.array.end(), std::back_inserter(result.array));
+		}
+		else
+		{
+			for (const auto low : left.array)
+			{
+				if (!ContainerContains(right, low))
+					result.array.push_back(low);
+			}
+		}
+
+		result.cardinality = static_cast<uint32_t>(result.array.size());
+		return result;
+	}
+
+	result = left;
+	ToBitmap(result);
+
+	auto & bitmap = result.bitmap;
+	switch (right.type)
+	{
+		case CONTAINER_BITMAP:
+		{
+#ifdef VNUM_SET_SSE2
+			for (uint32_t word = 0; word < BITMAP_WORDS; word += 2)
+			{
+				const auto leftBits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bitmap.data() + word));
+				const auto rightBits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right.bitmap.data() + word));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(bitmap.data() + word), _mm_andnot_si128(rightBits, leftBits));
+			}
+#else
+			for (uint32_t word = 0; word < BITMAP_WORDS; ++word)
+				bitmap[word] &= ~right.bitmap[word];
+#endif
+			break;
+		}
+		case CONTAINER_ARRAY:
+			for (const auto low : right.array)
+				bitmap[low >> 6] &= ~(uint64_t(1) << (low & 63));
+			break;
+		case CONTAINER_RUN:
+			for (const auto & run : right.runs)
+				SetBitRange(bitmap, run.start, static_cast<uint32_t>(run.start) + run.length, false);
+			break;
+	}
+
+	result.cardinality = CountBits(bitmap);
+	if (result.cardinality)
+		OptimizeContainer(result);
+
+	return result;
+}
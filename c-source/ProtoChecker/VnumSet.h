@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * \brief
+ * Compressed set of vnums, organised like a Roaring bitmap.
+ * The high 16 bits of a vnum select a container, the low 16 bits are stored in it as:
+ *   - array:  sorted list of values, used up to ARRAY_MAX_SIZE values
+ *   - bitmap: 65536 bits, used for dense containers
+ *   - run:    sorted list of [start, start + length] intervals, used for `~` ranges
+ */
+class CVnumSet
+{
+	private:
+		static constexpr uint32_t ARRAY_MAX_SIZE = 4096;
+		static constexpr uint32_t BITMAP_WORDS = 1024;
+
+		enum EContainerType : uint8_t
+		{
+			CONTAINER_ARRAY,
+			CONTAINER_BITMAP,
+			CONTAINER_RUN,
+		};
+
+		struct SRun
+		{
+			uint16_t start;
+			uint16_t length;
+		};
+
+		struct SContainer
+		{
+			EContainerType type = CONTAINER_ARRAY;
+			uint32_t cardinality = 0;
+			std::vector<uint16_t> array;
+			std::vector<uint64_t> bitmap;
+			std::vector<SRun> runs;
+		};
+
+		std::vector<uint16_t> m_Keys;
+		std::vector<SContainer> m_Containers;
+
+	public:
+		CVnumSet() = default;
+		virtual ~CVnumSet() = default;
+
+	public:
+		auto Add(uint32_t vnum) -> void;
+		auto AddRange(uint32_t first, uint32_t last) -> void;
+		auto Contains(uint32_t vnum) const -> bool;
+		auto Cardinality() const -> uint64_t;
+		auto Clear() -> void;
+		auto Optimize() -> void;
+
+		auto AndNot(const CVnumSet& other) const -> CVnumSet;
+		auto ToVector() const -> std::vector<uint32_t>;
+
+		template <typename F>
+		auto ForEach(F func) const -> void
+		{
+			for (size_t i = 0; i < m_Keys.size(); ++i)
+			{
+				const auto high = static_cast<uint32_t>(m_Keys[i]) << 16;
+				const auto & container = m_Containers[i];
+				switch (container.type)
+				{
+					case CONTAINER_ARRAY:
+						for (const auto low : container.array)
+							func(high | low);
+						break;
+					case CONTAINER_BITMAP:
+						for (uint32_t word = 0; word < BITMAP_WORDS; ++word)
+						{
+							for (auto bits = container.bitmap[word]; bits; bits &= bits - 1)
+								func(high | (word << 6) | count_trailing_zeros(bits));
+						}
+						break;
+					case CONTAINER_RUN:
+						for (const auto & run : container.runs)
+						{
+							for (uint32_t low = run.start; low <= static_cast<uint32_t>(run.start) + run.length; ++low)
+								func(high | low);
+						}
+						break;
+				}
+			}
+		}
+
+	private:
+		auto GetOrCreateContainer(uint16_t key) -> SContainer&;
+		auto FindContainer(uint16_t key) const -> const SContainer*;
+
+		static auto ToBitmap(SContainer& container) -> void;
+		static auto SetBitRange(std::vector<uint64_t>& bitmap, uint32_t first, uint32_t last, bool value) -> void;
+		static auto CountBits(const std::vector<uint64_t>& bitmap) -> uint32_t;
+		static auto ContainerContains(const SContainer& container, uint16_t low) -> bool;
+		static auto OptimizeContainer(SContainer& container) -> void;
+		static auto AndNotContainer(const SContainer& left, const SContainer& right) -> SContainer;
+};
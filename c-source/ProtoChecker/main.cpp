@@ -1,9 +1,288 @@
 #include "pch.h"
 #include "ProtoChecker.h"
+#include "Profiler.h"
+#include <filesystem>
 
-int main()
+/**
+ * \brief
+ * Export the phase metrics of the run, as <path>.json and as <path>.prom in the Prometheus text format.
+ * \param: stPath: string, the extension is replaced
+ * \return: bool
+ */
+static auto write_profile(const std::string& stPath) -> bool
 {
-	CProtoChecker obj;
-	obj.run();
+	auto path = std::filesystem::path(stPath);
+	auto & profiler = cProfiler::Instance();
+	if (profiler.WriteJson(path.replace_extension(".json").string()) && profiler.WritePrometheus(path.replace_extension(".prom").string()))
+		return true;
+
+	std::cerr << "Cannot write the profile: " << stPath << std::endl;
+	return false;
+}
+
+/**
+ * \brief
+ * Every subdirectory of a locale directory which contains a names file, sorted by name.
+ * \param: stRootPath: string
+ * \param: stDirectory: string, relative to the root path
+ * \return: vector, paths relative to the root path ending with '/'
+ */
+static auto find_locales(const std::string& stRootPath, const std::string& stDirectory) -> std::vector<std::string>
+{
+	std::vector<std::string> vecLocale;
+	std::error_code error;
+
+	for (const auto & entry : std::filesystem::directory_iterator(stRootPath + stDirectory, error))
+	{
+		if (!entry.is_directory(error))
+			continue;
+
+		const auto & path = entry.path();
+		if (!std::filesystem::exists(path / ITEM_NAMES_FILE_NAME, error) && !std::filesystem::exists(path / MOB_NAMES_FILE_NAME, error))
+			continue;
+
+		vecLocale.push_back(stDirectory + path.filename().string() + "/");
+	}
+
+	std::sort(vecLocale.begin(), vecLocale.end());
+	return vecLocale;
+}
+
+/**
+ * \brief
+ * Print the command line options.
+ */
+static auto print_usage() -> void
+{
+	std::cerr << "Usage: ProtoChecker [options]\n"
+		"  --root <dir>                  resource directory (default " << ROOT_PATH << ")\n"
+		"  --no-snapshot                 always parse the files, don't read or write their snapshots\n"
+		"  --locale <dir>                check the names files of a locale directory against the protos\n"
+		"  --locales <dir>               check every locale directory of a directory\n"
+		"  --similar-names               report near duplicate names\n"
+		"  --clones                      report proto rows copied under another vnum\n"
+		"  --fix                         rewrite the files without duplicates and with the missing names\n"
+		"  --keep-order                  --fix keeps the order of the rows instead of sorting them\n"
+		"  --watch                       check the files again whenever they change\n"
+		"  --diff <old> <new>            compare two revisions of a file\n"
+		"  --free-vnums <count> <from>   find a free block of vnums\n"
+		"  --serve <socket>              answer requests on a local socket\n"
+		"  --json <file>                 write the findings as JSON\n"
+		"  --sarif <file>                write the findings as SARIF\n"
+		"  --profile <path>              export the phase metrics as <path>.json and <path>.prom\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::string stRootPath(ROOT_PATH);
+	std::vector<std::unique_ptr<cLogWriter>> vecReport;
+	auto bWatch = false;
+	auto bSnapshot = true;
+	auto bFix = false;
+	auto bSort = true;
+	auto bSimilarNames = false;
+	auto bClones = false;
+	std::vector<uint32_t> vecFreeVnums;
+	std::string stSocketPath;
+	std::string stProfilePath;
+	std::vector<std::string> vecDiff;
+	std::vector<std::pair<bool, std::string>> vecLocaleArgument;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string stArgument(argv[i]);
+		if (stArgument == "--watch")
+		{
+			bWatch = true;
+		}
+		else if (stArgument == "--no-snapshot")
+		{
+			bSnapshot = false;
+		}
+		else if (stArgument == "--fix")
+		{
+			bFix = true;
+		}
+		else if (stArgument == "--keep-order")
+		{
+			bSort = false;
+		}
+		else if (stArgument == "--similar-names")
+		{
+			bSimilarNames = true;
+		}
+		else if (stArgument == "--clones")
+		{
+			bClones = true;
+		}
+		else if (stArgument == "--free-vnums")
+		{
+			uint32_t iCount, iFrom;
+			if (i + 2 >= argc || !parse_vnum(argv[i + 1], iCount) || iCount == 0 || !parse_vnum(argv[i + 2], iFrom))
+			{
+				std::cerr << "Usage: --free-vnums <count> <from>, count is a positive number of vnums and from a vnum" << std::endl;
+				return 1;
+			}
+
+			vecFreeVnums = { iCount, iFrom };
+			i += 2;
+		}
+		else if (stArgument == "--diff" && i + 2 < argc)
+		{
+			vecDiff.assign(argv + i + 1, argv + i + 3);
+			i += 2;
+		}
+		else if (stArgument == "--profile" && i + 1 < argc)
+		{
+			stProfilePath = argv[++i];
+		}
+		else if (stArgument == "--serve" && i + 1 < argc)
+		{
+			stSocketPath = argv[++i];
+		}
+		else if (stArgument == "--root" && i + 1 < argc)
+		{
+			stRootPath = argv[++i];
+			if (!stRootPath.empty() && stRootPath.back() != '/' && stRootPath.back() != '\\')
+				stRootPath += '/';
+		}
+		else if ((stArgument == "--locale" || stArgument == "--locales") && i + 1 < argc)
+		{
+			std::string stPath(argv[++i]);
+			if (!stPath.empty() && stPath.back() != '/' && stPath.back() != '\\')
+				stPath += '/';
+
+			vecLocaleArgument.emplace_back(stArgument == "--locales", stPath);
+		}
+		else if ((stArgument == "--json" || stArgument == "--sarif") && i + 1 < argc)
+		{
+			std::unique_ptr<cFileLogWriter> writer;
+			if (stArgument == "--json")
+				writer = std::make_unique<cJsonLogWriter>(argv[++i]);
+			else
+				writer = std::make_unique<cSarifLogWriter>(argv[++i]);
+
+			if (!writer->IsOpen())
+			{
+				std::cerr << "Cannot open report file: " << argv[i] << std::endl;
+				return 1;
+			}
+
+			vecReport.emplace_back(std::move(writer));
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	// --locale names one locale directory, --locales a directory holding one subdirectory per locale.
+	std::vector<std::string> vecLocale;
+	for (const auto & argument : vecLocaleArgument)
+	{
+		if (!argument.first)
+		{
+			vecLocale.push_back(argument.second);
+			continue;
+		}
+
+		const auto & vecFound = find_locales(stRootPath, argument.second);
+		if (vecFound.empty())
+		{
+			std::cerr << "No locale found in: " << stRootPath << argument.second << std::endl;
+			return 1;
+		}
+
+		vecLocale.insert(vecLocale.end(), vecFound.begin(), vecFound.end());
+	}
+
+	if (bWatch && !vecLocale.empty())
+	{
+		std::cerr << "--watch checks a single locale, it can't be combined with --locale/--locales" << std::endl;
+		return 1;
+	}
+
+	if (bFix && (bWatch || !vecLocale.empty()))
+	{
+		std::cerr << "--fix rewrites the files of a single run, it can't be combined with --watch or --locale/--locales" << std::endl;
+		return 1;
+	}
+
+	if (!vecDiff.empty() && (bWatch || bFix || !vecLocale.empty()))
+	{
+		std::cerr << "--diff compares two revisions of a file, it can't be combined with --watch, --fix or --locale/--locales" << std::endl;
+		return 1;
+	}
+
+	if (!vecFreeVnums.empty() && (bWatch || bFix || !vecDiff.empty() || !stSocketPath.empty() || !vecLocale.empty()))
+	{
+		std::cerr << "--free-vnums answers on its own, it can't be combined with --watch, --fix, --diff, --serve or --locale/--locales" << std::endl;
+		return 1;
+	}
+
+	if (!stSocketPath.empty() && (bWatch || bFix || bSimilarNames || bClones || !vecDiff.empty() || !vecLocale.empty()))
+	{
+		std::cerr << "--serve answers requests on its own, it can't be combined with --watch, --fix, --similar-names, --clones, --diff or --locale/--locales" << std::endl;
+		return 1;
+	}
+
+	if (!stProfilePath.empty() && (bWatch || !stSocketPath.empty()))
+	{
+		std::cerr << "--profile exports the metrics when the run ends, it can't be combined with --watch or --serve" << std::endl;
+		return 1;
+	}
+
+	// Enabled before the checker loads any file.
+	if (!stProfilePath.empty())
+		cProfiler::Instance().Enable();
+
+	CProtoChecker obj(stRootPath, bSnapshot);
+	obj.add_log_writer(std::make_unique<cConsoleLogWriter>());
+	obj.add_log_writer(std::make_unique<cTextLogWriter>(LOG_FILE_NAME));
+	for (auto & report : vecReport)
+		obj.add_log_writer(std::move(report));
+
+	// A revision diff only compares the two given files.
+	if (!vecDiff.empty())
+	{
+		const auto bDiff = obj.diff(vecDiff[0], vecDiff[1]);
+		if (!stProfilePath.empty() && !write_profile(stProfilePath))
+			return 1;
+
+		return bDiff ? 0 : 1;
+	}
+
+	// A free block query only looks at the keys of the loaded files.
+	if (!vecFreeVnums.empty())
+	{
+		obj.find_free_vnums(vecFreeVnums[0], vecFreeVnums[1]);
+		return 0;
+	}
+
+	// The daemon keeps the files in memory and checks them on request.
+	if (!stSocketPath.empty())
+		return obj.serve(stSocketPath) ? 0 : 1;
+
+	if (vecLocale.empty())
+		obj.run();
+	else
+		obj.run_locales(vecLocale);
+
+	if (bSimilarNames)
+		obj.check_similar_names();
+
+	if (bClones)
+		obj.check_clone_rows(obj.load_clone_rules());
+
+	if (bFix)
+		obj.fix(bSort);
+
+	if (!stProfilePath.empty() && !write_profile(stProfilePath))
+		return 1;
+
+	if (bWatch)
+		obj.watch();
+
 	return 0;
-}
\ No newline at end of file
+}
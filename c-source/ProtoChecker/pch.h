@@ -2,21 +2,29 @@
 #define PCH_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <cstdarg>
+#include <cstdio>
 #include <set>
 #include <algorithm>
 #include <regex>
 #include <cstdint>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+#include <unordered_map>
 
 /**
  * \brief
  * A system function in windows to change the colour of text and the console background.
  */
+#ifdef _WIN32
 static const int32_t console_color = system("color 00");
+#endif
 
 /**
  * \brief
@@ -32,19 +40,94 @@ inline auto strtoul(const std::string& format) -> uint32_t
 
 /**
  * \brief
- * Write formatted output using a pointer to a list of arguments.
- * \param format: string
+ * Index of the lowest set bit, the value must not be 0.
+ * \param value: uint64_t
+ * \return: uint32_t
+ */
+inline auto count_trailing_zeros(const uint64_t value) -> uint32_t
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	#ifdef _M_X64
+	_BitScanForward64(&index, value);
+	#else
+	if (!_BitScanForward(&index, static_cast<uint32_t>(value)))
+	{
+		_BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+		index += 32;
+	}
+	#endif
+	return index;
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+/**
+ * \brief
+ * Parse a vnum made only of decimal digits.
+ * \param text: string_view
+ * \param value: uint32_t
+ * \return: bool, false if the text is empty, contains any other character or overflows
+ */
+inline auto parse_vnum(const std::string_view text, uint32_t& value) -> bool
+{
+	if (text.empty() || text.size() > 10)
+		return false;
+
+	uint64_t result = 0;
+	for (const auto c : text)
+	{
+		if (c < '0' || c > '9')
+			return false;
+		result = result * 10 + static_cast<uint32_t>(c - '0');
+	}
+
+	if (result > UINT32_MAX)
+		return false;
+
+	value = static_cast<uint32_t>(result);
+	return true;
+}
+
+/**
+ * \brief
+ * Write formatted output using a list of arguments.
+ * The result is returned by value, so it's safe to call from several threads and long lines are never truncated.
+ * \param format: const char*
+ * \param args: va_list
+ * \return: string
+ */
+inline auto vformat(const char* format, va_list args) -> std::string
+{
+	va_list argsLength;
+	va_copy(argsLength, args);
+	const auto iLength = std::vsnprintf(nullptr, 0, format, argsLength);
+	va_end(argsLength);
+
+	if (iLength <= 0)
+		return {};
+
+	std::string stResult(static_cast<size_t>(iLength) + 1, '\0');
+	std::vsnprintf(&stResult[0], stResult.size(), format, args);
+	stResult.pop_back();
+	return stResult;
+}
+
+/**
+ * \brief
+ * Write formatted output using a variable number of arguments.
+ * \param format: const char*
  * \param ...: any
- * \return: char *
+ * \return: string
  */
-inline const char * format(const std::string format, ...)
+inline auto format(const char* format, ...) -> std::string
 {
-	static char cFormatLine[512];
 	va_list args;
 	va_start(args, format);
-	_vsnprintf_s(cFormatLine, sizeof(cFormatLine), format.c_str(), args);
+	auto stResult = vformat(format, args);
 	va_end(args);
-	return cFormatLine;
+	return stResult;
 }
 
 #endif //PCH_H
@@ -0,0 +1,166 @@
+/***********************************
+Parity test of the csv loaders: cCsvMappedFile has to read the same rows as the line based cCsvFile::Load,
+with every scanner implementation the cpu supports and when the file is cut into several chunks,
+and has to report the line every row starts on.
+***********************************/
+#include "pch.h"
+#include "CsvReader.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	/**
+	 * \brief
+	 * Test input and the line every row starts on, rows are counted from the header.
+	 */
+	struct SInput
+	{
+		std::string data;
+		std::vector<uint32_t> rowLines;
+	};
+
+	/**
+	 * \brief
+	 * Rows with quoted separators and quotes, quoted line breaks (LF and CRLF), CRLF line ends, comments holding a quote,
+	 * blank lines, empty and missing fields. The block is repeated so the chunks split it at every kind of line.
+	 * \param: iRepeat: uint32_t
+	 * \return: SInput
+	 */
+	auto MakeInput(uint32_t iRepeat) -> SInput
+	{
+		SInput input;
+		uint32_t line = 0;
+		const auto AddLines = [&](std::string_view text, bool bRow)
+		{
+			if (bRow)
+				input.rowLines.push_back(line + 1);
+
+			input.data.append(text);
+			line += static_cast<uint32_t>(std::count(text.begin(), text.end(), '\n'));
+		};
+
+		AddLines("VNUM\tNAME\tTYPE\tVALUE0\tVALUE1\tVALUE2\tVALUE3\n", true);
+		for (uint32_t i = 0; i < iRepeat; ++i)
+		{
+			const auto & stVnum = std::to_string(i * 10 + 1);
+			AddLines(stVnum + "\tPlain name\t1\t2\t3\t4\t5\n", true);
+			AddLines(stVnum + "\tWindows line\t1\t2\t3\t4\t5\r\n", true);
+			AddLines("# comment \"with an odd quote\n", false);
+			AddLines("\n", false);
+			AddLines(stVnum + "\t\"Quoted \"\"name\"\"\twith a tab\"\t1\t\t\t\t5\n", true);
+			AddLines(stVnum + "\t\"First line\nsecond line\"\t2\t3\t4\t5\t6\n", true);
+			AddLines(stVnum + "\t\"First line\r\n# not a comment\r\nthird line\"\t2\t\"3\"\t4\t5\t6\r\n", true);
+			AddLines("  \t\r\n", false);
+			AddLines(stVnum + "\tShort row\n", true);
+			AddLines(stVnum + "~" + std::to_string(i * 10 + 9) + "\tRange\t1\t2\t3\t4\t\"5\"\n", true);
+		}
+
+		AddLines("99999\tLast row without a line end\t1\t2\t3\t4\t5", true);
+		return input;
+	}
+
+	/**
+	 * \brief
+	 * Compare a mapped load with the line based one and with the lines the rows start on.
+	 * \return: uint32_t, number of mismatches, the first ones are printed
+	 */
+	auto Compare(const std::string& stCase, const cCsvFile& expected, const cCsvMappedFile& mapped, const std::vector<uint32_t>& vecLine) -> uint32_t
+	{
+		uint32_t iMismatch = 0;
+		const auto Report = [&](size_t row, const std::string& stWhat)
+		{
+			if (++iMismatch <= 5)
+				std::cerr << stCase << ": row " << row << ": " << stWhat << std::endl;
+		};
+
+		if (mapped.GetRowCount() != expected.GetRowCount())
+			Report(0, "row count " + std::to_string(mapped.GetRowCount()) + " instead of " + std::to_string(expected.GetRowCount()));
+
+		for (size_t row = 0; row < std::min(mapped.GetRowCount(), expected.GetRowCount()); ++row)
+		{
+			const auto & expectedRow = *expected[row];
+			if (mapped.GetColCount(row) != expectedRow.size())
+			{
+				Report(row, "column count " + std::to_string(mapped.GetColCount(row)) + " instead of " + std::to_string(expectedRow.size()));
+				continue;
+			}
+
+			for (size_t col = 0; col < expectedRow.size(); ++col)
+			{
+				if (mapped.GetField(row, col) != expectedRow[col])
+					Report(row, "column " + std::to_string(col) + " is \"" + std::string(mapped.GetField(row, col)) + "\" instead of \"" + expectedRow[col] + "\"");
+			}
+
+			if (row < vecLine.size() && mapped.GetLine(row) != vecLine[row])
+				Report(row, "line " + std::to_string(mapped.GetLine(row)) + " instead of " + std::to_string(vecLine[row]));
+		}
+
+		return iMismatch;
+	}
+}
+
+int main()
+{
+	const auto & input = MakeInput(500);
+	const auto & stPath = (std::filesystem::temp_directory_path() / "CsvReaderTest.txt").string();
+	{
+		std::ofstream file(stPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		file << input.data;
+		if (!file)
+		{
+			std::cerr << "Cannot write " << stPath << std::endl;
+			return 1;
+		}
+	}
+
+	// Everything, a shallow projection cut with memchr and a deep one cut from the structural index.
+	const std::vector<std::pair<std::string, cCsvColumnMask>> vecMask = {
+		{ "all", cCsvColumnMask() },
+		{ "{0,1}", cCsvColumnMask{ 0, 1 } },
+		{ "{0,5}", cCsvColumnMask{ 0, 5 } },
+	};
+
+	uint32_t iMismatch = 0;
+	uint32_t iCase = 0;
+	for (const auto & mask : vecMask)
+	{
+		cCsvFile expected;
+		if (!expected.Load(stPath.c_str(), '\t', '"', mask.second))
+		{
+			std::cerr << "Cannot load " << stPath << std::endl;
+			return 1;
+		}
+
+		for (auto implementation = cCsvScanner::IMPL_SCALAR; implementation <= cCsvScanner::GetBestImplementation(); implementation = static_cast<cCsvScanner::EImplementation>(implementation + 1))
+		{
+			for (const size_t chunkCount : { 0, 1, 3, 16 })
+			{
+				cCsvMappedFile mapped;
+				mapped.SetScannerImplementation(implementation);
+				mapped.SetChunkCount(chunkCount);
+				if (!mapped.Load(stPath.c_str(), '\t', '"', mask.second))
+				{
+					std::cerr << "Cannot map " << stPath << std::endl;
+					return 1;
+				}
+
+				const auto & stCase = std::string(cCsvScanner::GetImplementationName(implementation)) + " mask " + mask.first + " chunks " + std::to_string(chunkCount);
+				iMismatch += Compare(stCase, expected, mapped, input.rowLines);
+				++iCase;
+			}
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::remove(stPath, error);
+
+	if (iMismatch)
+	{
+		std::cerr << iMismatch << " mismatches" << std::endl;
+		return 1;
+	}
+
+	std::cout << iCase << " cases passed" << std::endl;
+	return 0;
+}
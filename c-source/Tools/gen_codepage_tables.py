@@ -0,0 +1,51 @@
+"""
+Generates ProtoChecker/CodePageTables.h, the code page to unicode tables of cTextEncoding.
+The mappings are taken from the codecs of the python standard library:
+    python3 Tools/gen_codepage_tables.py > ProtoChecker/CodePageTables.h
+"""
+import sys
+
+CP949_LEAD_FIRST, CP949_LEAD_LAST = 0x81, 0xFE
+CP949_TRAIL_FIRST, CP949_TRAIL_LAST = 0x41, 0xFE
+
+
+def decode(data, codec):
+    try:
+        text = data.decode(codec)
+    except UnicodeDecodeError:
+        return 0
+    return ord(text) if len(text) == 1 else 0
+
+
+def write_table(out, name, values):
+    out.write('static constexpr uint16_t %s[%d] =\n{\n' % (name, len(values)))
+    for i in range(0, len(values), 16):
+        out.write('\t' + ', '.join('0x%04X' % value for value in values[i:i + 16]) + ',\n')
+    out.write('};\n')
+
+
+def main():
+    cp949 = [decode(bytes([lead, trail]), 'cp949')
+             for lead in range(CP949_LEAD_FIRST, CP949_LEAD_LAST + 1)
+             for trail in range(CP949_TRAIL_FIRST, CP949_TRAIL_LAST + 1)]
+
+    # The 5 bytes windows-1252 leaves undefined map to the C1 controls, as MultiByteToWideChar does.
+    cp1252 = [decode(bytes([byte]), 'cp1252') or byte for byte in range(0x80, 0x100)]
+
+    out = sys.stdout
+    out.write('#pragma once\n')
+    out.write('// Generated by Tools/gen_codepage_tables.py, do not edit.\n\n')
+    out.write('static constexpr uint32_t CP949_LEAD_FIRST = 0x%02X;\n' % CP949_LEAD_FIRST)
+    out.write('static constexpr uint32_t CP949_LEAD_LAST = 0x%02X;\n' % CP949_LEAD_LAST)
+    out.write('static constexpr uint32_t CP949_TRAIL_FIRST = 0x%02X;\n' % CP949_TRAIL_FIRST)
+    out.write('static constexpr uint32_t CP949_TRAIL_LAST = 0x%02X;\n' % CP949_TRAIL_LAST)
+    out.write('static constexpr uint32_t CP949_TRAIL_COUNT = CP949_TRAIL_LAST - CP949_TRAIL_FIRST + 1;\n\n')
+    out.write('/**\n * \\brief\n * Unicode code point of a CP949 (UHC) double byte sequence, 0 if the sequence is undefined.\n')
+    out.write(' * Indexed by (lead - CP949_LEAD_FIRST) * CP949_TRAIL_COUNT + trail - CP949_TRAIL_FIRST.\n */\n')
+    write_table(out, 'CP949_TABLE', cp949)
+    out.write('\n/**\n * \\brief\n * Unicode code point of the windows-1252 bytes 0x80-0xFF.\n */\n')
+    write_table(out, 'CP1252_TABLE', cp1252)
+
+
+if __name__ == '__main__':
+    main()
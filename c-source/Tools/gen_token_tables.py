@@ -0,0 +1,129 @@
+"""
+Generates ProtoChecker/TokenTables.h, the token dictionaries of the enum columns as minimal perfect hashes.
+The tokens are read from name tables (`name[] = { "A", "B", ... };`, as in the server's db/src/ProtoReader.cpp)
+or from enums (`enum name { A, B = 5, ... };`) of the given sources, Tools/proto_tokens.h by default:
+    python3 Tools/gen_token_tables.py [sources...] > ProtoChecker/TokenTables.h
+A token's value is its position in the name table (or its enum value), the value the server stores.
+The hashes mirror hash_token/mix_token_hash of ProtoChecker/TokenDictionary.h.
+"""
+import os
+import re
+import sys
+
+# Dictionary name, name table or enum it's read from.
+DICTIONARIES = [
+    ('ITEM_TYPE', 'arItemType'),
+    ('LIMIT_TYPE', 'arLimitType'),
+    ('APPLY_TYPE', 'arApplyType'),
+    ('MOB_RANK', 'arRank'),
+    ('MOB_TYPE', 'arType'),
+    ('BATTLE_TYPE', 'arBattleType'),
+]
+
+MASK = (1 << 64) - 1
+MAX_SEED = 0xFFFF
+
+
+def hash_token(token):
+    value = 0xCBF29CE484222325
+    for byte in token.encode():
+        value = ((value ^ byte) * 0x100000001B3) & MASK
+    return value
+
+
+def mix_token_hash(value, seed):
+    value ^= (seed * 0x9E3779B97F4A7C15) & MASK
+    value ^= value >> 31
+    value = (value * 0xBF58476D1CE4E5B9) & MASK
+    value ^= value >> 29
+    return value
+
+
+def reduce(value, count):
+    return ((value & 0xFFFFFFFF) * count) >> 32
+
+
+def read_sources(paths):
+    tables = {}
+    for path in paths:
+        with open(path, encoding='utf-8', errors='replace') as source:
+            text = re.sub(r'//[^\n]*|/\*.*?\*/', '', source.read(), flags=re.S)
+
+        for name, body in re.findall(r'(\w+)\s*\[\s*\w*\s*\]\s*=\s*\{([^}]*)\}', text):
+            tables.setdefault(name, [(token, value) for value, token in enumerate(re.findall(r'"([^"]*)"', body))])
+
+        for name, body in re.findall(r'enum\s+(?:class\s+)?(\w+)\s*(?::\s*\w+\s*)?\{([^}]*)\}', text):
+            tokens, value = [], 0
+            for item in filter(None, (item.strip() for item in body.split(','))):
+                token, _, assigned = item.partition('=')
+                if assigned.strip():
+                    value = int(assigned.strip(), 0)
+                tokens.append((token.strip(), value))
+                value += 1
+            tables.setdefault(name, tokens)
+    return tables
+
+
+def build(tokens):
+    """
+    Hash and displace: every token lands in a bucket, each bucket gets the first seed which moves all of its tokens
+    into free slots, so there are exactly as many slots as tokens.
+    """
+    count = len(tokens)
+    bucket_count = max(1, (count + 1) // 2)
+    buckets = [[] for _ in range(bucket_count)]
+    for token, value in tokens:
+        buckets[reduce(hash_token(token), bucket_count)].append((token, value))
+
+    slots = [None] * count
+    seeds = [0] * bucket_count
+    for bucket in sorted(range(bucket_count), key=lambda index: -len(buckets[index])):
+        if not buckets[bucket]:
+            continue
+
+        for seed in range(MAX_SEED + 1):
+            placed = [reduce(mix_token_hash(hash_token(token), seed) >> 32, count) for token, _ in buckets[bucket]]
+            if len(set(placed)) == len(placed) and all(slots[slot] is None for slot in placed):
+                break
+        else:
+            sys.exit('no seed for a bucket of %d tokens' % len(buckets[bucket]))
+
+        seeds[bucket] = seed
+        for slot, entry in zip(placed, buckets[bucket]):
+            slots[slot] = entry
+    return slots, seeds
+
+
+def main():
+    tools = os.path.dirname(os.path.abspath(__file__))
+    paths = sys.argv[1:] or [os.path.join(tools, 'proto_tokens.h')]
+    tables = read_sources(paths)
+
+    out = sys.stdout
+    out.write('#pragma once\n')
+    out.write('// Generated by Tools/gen_token_tables.py, do not edit.\n')
+    out.write('#include "TokenDictionary.h"\n')
+    for name, source in DICTIONARIES:
+        tokens = tables.get(source)
+        if not tokens:
+            sys.exit('%s not found in %s' % (source, ', '.join(paths)))
+        if len({token for token, _ in tokens}) != len(tokens):
+            sys.exit('%s has a repeated token' % source)
+        if max(value for _, value in tokens) > 0xFF:
+            sys.exit('%s has a value above 255' % source)
+
+        slots, seeds = build(tokens)
+        out.write('\nstatic constexpr STokenEntry %s_ENTRIES[%d] =\n{\n' % (name, len(slots)))
+        for token, value in slots:
+            out.write('\t{"%s", %d},\n' % (token, value))
+        out.write('};\n\n')
+        out.write('static constexpr uint16_t %s_SEEDS[%d] =\n{\n' % (name, len(seeds)))
+        for i in range(0, len(seeds), 16):
+            out.write('\t' + ', '.join('%d' % seed for seed in seeds[i:i + 16]) + ',\n')
+        out.write('};\n\n')
+        out.write('static constexpr cTokenDictionary %s_TOKENS("%s", %s_ENTRIES, %s_SEEDS);\n' % (name, name, name, name))
+        out.write('static_assert(%s_TOKENS.IsPerfect(), "%s_TOKENS doesn\'t find its own tokens");\n' % (name, name))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,86 @@
+/*
+ * Token names of the enum columns of item_proto.txt and mob_proto.txt, in the order of their game enums,
+ * laid out like the name tables of the server's db/src/ProtoReader.cpp.
+ * Input of Tools/gen_token_tables.py when it isn't given the server sources.
+ */
+
+static const char* arItemType[] =
+{
+	"ITEM_NONE", "ITEM_WEAPON", "ITEM_ARMOR", "ITEM_USE",
+	"ITEM_AUTOUSE", "ITEM_MATERIAL", "ITEM_SPECIAL", "ITEM_TOOL",
+	"ITEM_LOTTERY", "ITEM_ELK", "ITEM_METIN", "ITEM_CONTAINER",
+	"ITEM_FISH", "ITEM_ROD", "ITEM_RESOURCE", "ITEM_CAMPFIRE",
+	"ITEM_UNIQUE", "ITEM_SKILLBOOK", "ITEM_QUEST", "ITEM_POLYMORPH",
+	"ITEM_TREASURE_BOX", "ITEM_TREASURE_KEY", "ITEM_SKILLFORGET", "ITEM_GIFTBOX",
+	"ITEM_PICK", "ITEM_HAIR", "ITEM_TOTEM", "ITEM_BLEND",
+	"ITEM_COSTUME", "ITEM_DS", "ITEM_SPECIAL_DS", "ITEM_EXTRACT",
+	"ITEM_SECONDARY_COIN", "ITEM_RING", "ITEM_BELT", "ITEM_PET",
+	"ITEM_MEDIUM", "ITEM_GACHA", "ITEM_SOUL",
+};
+
+static const char* arLimitType[] =
+{
+	"LIMIT_NONE", "LEVEL", "STR", "DEX",
+	"INT", "CON", "PC_BANG", "REAL_TIME",
+	"REAL_TIME_FIRST_USE", "TIMER_BASED_ON_WEAR",
+};
+
+static const char* arApplyType[] =
+{
+	"APPLY_NONE", "APPLY_MAX_HP", "APPLY_MAX_SP",
+	"APPLY_CON", "APPLY_INT", "APPLY_STR",
+	"APPLY_DEX", "APPLY_ATT_SPEED", "APPLY_MOV_SPEED",
+	"APPLY_CAST_SPEED", "APPLY_HP_REGEN", "APPLY_SP_REGEN",
+	"APPLY_POISON_PCT", "APPLY_STUN_PCT", "APPLY_SLOW_PCT",
+	"APPLY_CRITICAL_PCT", "APPLY_PENETRATE_PCT", "APPLY_ATTBONUS_HUMAN",
+	"APPLY_ATTBONUS_ANIMAL", "APPLY_ATTBONUS_ORC", "APPLY_ATTBONUS_MILGYO",
+	"APPLY_ATTBONUS_UNDEAD", "APPLY_ATTBONUS_DEVIL", "APPLY_STEAL_HP",
+	"APPLY_STEAL_SP", "APPLY_MANA_BURN_PCT", "APPLY_DAMAGE_SP_RECOVER",
+	"APPLY_BLOCK", "APPLY_DODGE", "APPLY_RESIST_SWORD",
+	"APPLY_RESIST_TWOHAND", "APPLY_RESIST_DAGGER", "APPLY_RESIST_BELL",
+	"APPLY_RESIST_FAN", "APPLY_RESIST_BOW", "APPLY_RESIST_FIRE",
+	"APPLY_RESIST_ELEC", "APPLY_RESIST_MAGIC", "APPLY_RESIST_WIND",
+	"APPLY_REFLECT_MELEE", "APPLY_REFLECT_CURSE", "APPLY_POISON_REDUCE",
+	"APPLY_KILL_SP_RECOVER", "APPLY_EXP_DOUBLE_BONUS", "APPLY_GOLD_DOUBLE_BONUS",
+	"APPLY_ITEM_DROP_BONUS", "APPLY_POTION_BONUS", "APPLY_KILL_HP_RECOVER",
+	"APPLY_IMMUNE_STUN", "APPLY_IMMUNE_SLOW", "APPLY_IMMUNE_FALL",
+	"APPLY_SKILL", "APPLY_BOW_DISTANCE", "APPLY_ATT_GRADE_BONUS",
+	"APPLY_DEF_GRADE_BONUS", "APPLY_MAGIC_ATT_GRADE", "APPLY_MAGIC_DEF_GRADE",
+	"APPLY_CURSE_PCT", "APPLY_MAX_STAMINA", "APPLY_ATTBONUS_WARRIOR",
+	"APPLY_ATTBONUS_ASSASSIN", "APPLY_ATTBONUS_SURA", "APPLY_ATTBONUS_SHAMAN",
+	"APPLY_ATTBONUS_MONSTER", "APPLY_MALL_ATTBONUS", "APPLY_MALL_DEFBONUS",
+	"APPLY_MALL_EXPBONUS", "APPLY_MALL_ITEMBONUS", "APPLY_MALL_GOLDBONUS",
+	"APPLY_MAX_HP_PCT", "APPLY_MAX_SP_PCT", "APPLY_SKILL_DAMAGE_BONUS",
+	"APPLY_NORMAL_HIT_DAMAGE_BONUS", "APPLY_SKILL_DEFEND_BONUS", "APPLY_NORMAL_HIT_DEFEND_BONUS",
+	"APPLY_PC_BANG_EXP_BONUS", "APPLY_PC_BANG_DROP_BONUS", "APPLY_EXTRACT_HP_PCT",
+	"APPLY_RESIST_WARRIOR", "APPLY_RESIST_ASSASSIN", "APPLY_RESIST_SURA",
+	"APPLY_RESIST_SHAMAN", "APPLY_ENERGY", "APPLY_DEF_GRADE",
+	"APPLY_COSTUME_ATTR_BONUS", "APPLY_MAGIC_ATTBONUS_PER", "APPLY_MELEE_MAGIC_ATTBONUS_PER",
+	"APPLY_RESIST_ICE", "APPLY_RESIST_EARTH", "APPLY_RESIST_DARK",
+	"APPLY_ANTI_CRITICAL_PCT", "APPLY_ANTI_PENETRATE_PCT", "APPLY_BLEEDING_REDUCE",
+	"APPLY_BLEEDING_PCT", "APPLY_ATTBONUS_WOLFMAN", "APPLY_RESIST_WOLFMAN",
+	"APPLY_RESIST_CLAW", "APPLY_ACCEDRAIN_RATE", "APPLY_RESIST_MAGIC_REDUCTION",
+	"APPLY_ENCHANT_ELECT", "APPLY_ENCHANT_FIRE", "APPLY_ENCHANT_ICE",
+	"APPLY_ENCHANT_WIND", "APPLY_ENCHANT_EARTH", "APPLY_ENCHANT_DARK",
+	"APPLY_ATTBONUS_CZ", "APPLY_ATTBONUS_INSECT", "APPLY_ATTBONUS_DESERT",
+	"APPLY_ATTBONUS_SWORD", "APPLY_ATTBONUS_TWOHAND", "APPLY_ATTBONUS_DAGGER",
+	"APPLY_ATTBONUS_BELL", "APPLY_ATTBONUS_FAN", "APPLY_ATTBONUS_BOW",
+	"APPLY_ATTBONUS_CLAW", "APPLY_RESIST_HUMAN", "APPLY_RESIST_MOUNT_FALL",
+};
+
+static const char* arRank[] =
+{
+	"PAWN", "S_PAWN", "KNIGHT", "S_KNIGHT", "BOSS", "KING",
+};
+
+static const char* arType[] =
+{
+	"MONSTER", "NPC", "STONE", "WARP", "DOOR", "BUILDING",
+	"PC", "POLYMORPH_PC", "HORSE", "GOTO", "PET",
+};
+
+static const char* arBattleType[] =
+{
+	"MELEE", "RANGE", "MAGIC", "SPECIAL",
+	"POWER", "TANKER", "SUPER_POWER", "SUPER_TANKER",
+};